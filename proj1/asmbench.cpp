@@ -0,0 +1,250 @@
+/**
+ *	@file 		asmbench.cpp
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Assembler benchmark.
+ *
+ *	@section 	DESCRIPTION
+ * 	This program generates large assembly sources with many
+ *      labels and times PassOne and PassTwo on them, and the
+ *      single pass assembler and PassTwo on a thread per core
+ *      (at least two) on the same source, so the cost of label
+ *      resolution can be seen as programs grow. Last it
+ *      reassembles from a line cache after inserting one line
+ *      in the middle, which moves half the labels.
+ *      Throughput is in MB of assembly source per second.
+ *
+ *        asmbench [labels ...]
+ **********************************************************/
+
+#ifndef ASMBENCH_CPP
+#define ASMBENCH_CPP
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <list>
+#include <iterator>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <cstdio>
+#include "passes.h"
+#include "onepass.h"
+#include "parallel.h"
+#include "incremental.h"
+
+void Generate(int, std::list<std::string> &);
+void Bench(int);
+double Reassemble(std::list<std::string> &, int &);
+
+int main(int argc, char *argv[])
+{
+  std::vector<int> sizes;
+  for(int i = 1; i < argc; ++i)
+    sizes.push_back(atoi(argv[i]));
+  if(sizes.empty())
+  {
+    sizes.push_back(1000);
+    sizes.push_back(10000);
+    sizes.push_back(50000);
+  }
+
+  std::cout << std::setw(10) << "Labels" << std::setw(10) << "Lines"
+            << std::setw(12) << "Pass One" << std::setw(12) << "Pass Two"
+            << std::setw(10) << "MB/s" << std::setw(12) << "One Pass"
+            << std::setw(10) << "MB/s" << std::setw(12) << "Parallel"
+            << std::setw(10) << "Threads" << std::setw(12) << "Edit"
+            << std::setw(10) << "Encoded" << std::endl;
+  for(size_t i = 0; i < sizes.size(); ++i)
+    Bench(sizes[i]);
+  return 0;
+}
+
+// writes a program with the given number of text labels, each
+// followed by a few instructions that branch, jump and load
+// through other labels, and a data label for every text label.
+// Loads and stores name the data label alone, since $gp offsets
+// only reach 32KB of data, so they expand to two words each
+void Generate(int labels, std::list<std::string> &source)
+{
+  unsigned int seed = 12345;
+  std::ostringstream line;
+
+  source.push_back(".text");
+  for(int i = 0; i < labels; ++i)
+  {
+    seed = seed * 1103515245 + 12345;
+    int target = (seed >> 8) % labels;
+    // branches only reach 32K words, so they go to a label
+    // at most a thousand away
+    int near = i + (int)((seed >> 8) % 2001) - 1000;
+    near = near < 0 ? 0 : near >= labels ? labels - 1 : near;
+
+    line.str("");
+    line << "L" << i << ":";
+    source.push_back(line.str());
+
+    line.str("");
+    line << "lw $t0,D" << target;
+    source.push_back(line.str());
+    source.push_back("addu $t1,$t0,$t1");
+    source.push_back("slt $t2,$t1,$t0");
+
+    line.str("");
+    line << "beq $t2,$zero,L" << near;
+    source.push_back(line.str());
+
+    line.str("");
+    line << "sw $t1,D" << i;
+    source.push_back(line.str());
+
+    line.str("");
+    line << "j L" << (i + 1) % labels;
+    source.push_back(line.str());
+  }
+
+  source.push_back(".data");
+  for(int i = 0; i < labels; ++i)
+  {
+    line.str("");
+    line << "D" << i << ": .word " << i;
+    source.push_back(line.str());
+  }
+}
+
+// times both passes, the single pass assembler and the parallel
+// pass two on a generated program, and checks they agree
+void Bench(int labels)
+{
+  std::list<std::string> source;
+  std::vector<machine> machineCode;
+  SymbolTable addressTable;
+  OnePass streamed;
+  std::vector<machine> parallelCode;
+  Source lexed;
+  int threads = std::thread::hardware_concurrency();
+  if(threads < 2)
+    threads = 2;
+
+  Generate(labels, source);
+  double megabytes = 0;
+  for(std::list<std::string>::iterator it = source.begin();
+      it != source.end(); ++it)
+    megabytes += (*it).size() + 1;
+  megabytes /= 1e6;
+
+  // pass one's time takes in lexing the source
+  std::chrono::steady_clock::time_point start
+    = std::chrono::steady_clock::now();
+  for(std::list<std::string>::iterator it = source.begin();
+      it != source.end(); ++it)
+    lexed.Add(*it);
+  int errors = PassOne(lexed, addressTable, machineCode);
+  std::chrono::steady_clock::time_point middle
+    = std::chrono::steady_clock::now();
+  errors += PassTwo(lexed, addressTable, machineCode);
+  std::chrono::steady_clock::time_point end
+    = std::chrono::steady_clock::now();
+  for(std::list<std::string>::iterator it = source.begin();
+      it != source.end(); ++it)
+    streamed.Line(*it);
+  errors += streamed.Finish();
+  std::chrono::steady_clock::time_point last
+    = std::chrono::steady_clock::now();
+
+  // pass two again on threads, over the data words pass one left
+  parallelCode.assign(machineCode.begin() + addressTable.DataStart(),
+                      machineCode.end());
+  std::chrono::steady_clock::time_point parallelStart
+    = std::chrono::steady_clock::now();
+  errors += PassTwoParallel(lexed, addressTable, parallelCode, threads);
+  std::chrono::steady_clock::time_point parallelEnd
+    = std::chrono::steady_clock::now();
+
+  int encoded = 0;
+  double edit = Reassemble(source, encoded);
+
+  double one = std::chrono::duration<double>(middle - start).count();
+  double two = std::chrono::duration<double>(end - middle).count();
+  double single = std::chrono::duration<double>(last - end).count();
+  double parallel
+    = std::chrono::duration<double>(parallelEnd - parallelStart).count();
+  std::cout << std::setw(10) << labels << std::setw(10) << source.size()
+            << std::setw(12) << std::fixed << std::setprecision(4) << one
+            << std::setw(12) << two << std::setw(10) << std::setprecision(1)
+            << megabytes / (one + two) << std::setw(12)
+            << std::setprecision(4) << single << std::setw(10)
+            << std::setprecision(1) << megabytes / single << std::setw(12)
+            << std::setprecision(4) << parallel << std::setw(10) << threads
+            << std::setw(12) << edit << std::setw(10) << encoded;
+  if(encoded < 0)
+    std::cout << "  (incremental differs)";
+  if(errors)
+    std::cout << "  (" << errors << " errors)";
+
+  std::vector<machine>::iterator it = machineCode.begin();
+  for(size_t i = 0; i < streamed.Code().size(); ++i, ++it)
+  {
+    if(it == machineCode.end() || (*it).machineCode != streamed.Code()[i])
+    {
+      std::cout << "  (one pass differs at word " << i << ")";
+      break;
+    }
+  }
+  it = parallelCode.begin();
+  for(std::vector<machine>::iterator serial = machineCode.begin();
+      serial != machineCode.end(); ++serial, ++it)
+  {
+    if(it == parallelCode.end() || (*it).machineCode != (*serial).machineCode
+       || (*it).address != (*serial).address)
+    {
+      std::cout << "  (parallel differs)";
+      break;
+    }
+  }
+  std::cout << std::endl;
+}
+
+// fills a line cache from the source, inserts a line in its middle
+// and times reassembling from the cache. Sets encoded to the lines
+// that had to be encoded, or -1 if the words are not the single pass
+// assembler's
+double Reassemble(std::list<std::string> &source, int &encoded)
+{
+  const char *name = "asmbench.cache";
+  Incremental cold;
+  for(std::list<std::string>::iterator it = source.begin();
+      it != source.end(); ++it)
+    cold.Line(*it);
+  cold.Finish();
+  cold.Save(name);
+
+  std::list<std::string>::iterator middle = source.begin();
+  std::advance(middle, source.size() / 4);
+  source.insert(middle, "addu $t3,$t3,$t3");
+
+  std::chrono::steady_clock::time_point start
+    = std::chrono::steady_clock::now();
+  Incremental warm;
+  warm.Load(name);
+  for(std::list<std::string>::iterator it = source.begin();
+      it != source.end(); ++it)
+    warm.Line(*it);
+  warm.Finish();
+  std::chrono::steady_clock::time_point end
+    = std::chrono::steady_clock::now();
+  remove(name);
+
+  OnePass fresh;
+  for(std::list<std::string>::iterator it = source.begin();
+      it != source.end(); ++it)
+    fresh.Line(*it);
+  fresh.Finish();
+  encoded = warm.Code() == fresh.Code() ? warm.Encoded() : -1;
+  return std::chrono::duration<double>(end - start).count();
+}
+
+#endif
@@ -0,0 +1,219 @@
+/**
+ *	@file 		batch.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Running many program instances at once.
+ *
+ *	@section 	DESCRIPTION
+ * 	A batch is many runs of a few programs, each run an
+ *      Instance of one program over one input. Every program is
+ *      loaded and decoded once into an Image that all its
+ *      instances share read only; each instance only has its
+ *      registers and its memory pages of its own, and a page is
+ *      copied from the program's words the first time it is
+ *      stored into (see memory.h).
+ *
+ *      StealingPool spreads the instances over threads. Each
+ *      thread starts with an equal range of them and takes its
+ *      next from the front of its own range; one that runs out
+ *      steals the back half of the largest range left, so the
+ *      threads finish together however long each run takes.
+ *      Instances share nothing they write, so each runs with no
+ *      lock, and throughput grows with the number of cores.
+ **********************************************************/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "interp.h"
+#include "pipeline.h"
+
+// a program of the batch, loaded and decoded once
+struct BatchProgram
+{
+  BatchProgram(): image(NULL) {}
+  ~BatchProgram() {delete image;}
+
+  std::string name;
+  Program program;
+  Image *image;
+  std::vector<int> text;    // for the pipeline, if timed
+};
+
+// one run of a program and what came of it
+struct Instance
+{
+  int program;
+  int input;                // index of its input, -1 for none
+  Stop stop;
+  int exitCode;
+  unsigned long long instructions;
+  unsigned long long cycles;
+  std::string output;       // everything its syscalls printed
+  std::string fault;
+};
+
+// how every instance is run
+struct BatchOptions
+{
+  BatchOptions(): limit(ULLONG_MAX), memory(DEFAULT_MEMORY),
+                  blocks(false), timed(false)
+  {
+  }
+
+  unsigned long long limit;
+  size_t memory;
+  bool blocks;
+  bool timed;               // times it on the pipeline
+  PipelineConfig pipeline;
+};
+
+// runs one instance on its own interpreter, reading input
+inline void RunInstance(const BatchProgram &p, const std::string &input,
+                        const BatchOptions &options, Instance &run)
+{
+  std::istringstream in(input);
+  std::ostringstream out;
+  Interpreter machine(*p.image, options.memory);
+  machine.Streams(in, out);
+  machine.Translate(options.blocks);
+  Pipeline *pipeline = NULL;
+  if(options.timed)
+  {
+    pipeline = new Pipeline(p.text, machine.TextWords(), options.pipeline);
+    machine.Trace(pipeline);
+  }
+
+  run.stop = machine.Run(options.limit);
+  run.exitCode = machine.ExitCode();
+  run.instructions = machine.Executed();
+  run.cycles = pipeline ? pipeline->Cycles() : 0;
+  run.output = out.str();
+  if(run.stop == STOP_FAULT)
+    run.fault = machine.Fault();
+  delete pipeline;
+}
+
+// a thread pool running jobs 0 to count - 1 by work stealing
+class StealingPool
+{
+public:
+
+  // constructor, threads to run on, at least 1
+  StealingPool(int threads): _threads(threads < 1 ? 1 : threads),
+                             _steals(0)
+  {
+  }
+
+  // calls job(i) once for every i below count, from the threads,
+  // and returns when all have returned
+  template<class Job>
+  void Run(size_t count, Job job)
+  {
+    std::vector<Range> ranges(_threads);
+    for(int t = 0; t < _threads; ++t)
+    {
+      ranges[t].next = count * t / _threads;
+      ranges[t].end = count * (t + 1) / _threads;
+    }
+    _ranges = &ranges;
+    std::vector<std::thread> pool;
+    for(int t = 1; t < _threads; ++t)
+      pool.push_back(std::thread(&StealingPool::Work<Job>, this, t, job));
+    Work(0, job);
+    for(size_t i = 0; i < pool.size(); ++i)
+      pool[i].join();
+    _ranges = NULL;
+  }
+
+  int Threads() const {return _threads;}
+  // ranges split off by a thread that ran out
+  unsigned long long Steals() const {return _steals;}
+
+private:
+  // the jobs a thread has left, padded apart so threads taking
+  // from their own do not share a cache line. They change only
+  // under the lock but may be read without it
+  struct Range
+  {
+    std::mutex lock;
+    std::atomic<size_t> next;
+    std::atomic<size_t> end;
+    char pad[64];
+  };
+
+  // thread body, runs its own jobs then steals until none are left
+  template<class Job>
+  void Work(int self, Job job)
+  {
+    Range &mine = (*_ranges)[self];
+    while(true)
+    {
+      size_t i = 0;
+      bool any;
+      {
+        std::lock_guard<std::mutex> hold(mine.lock);
+        any = mine.next < mine.end;
+        if(any)
+          i = mine.next++;
+      }
+      if(any)
+        job(i);
+      else if(!Steal(self))
+        return;
+    }
+  }
+
+  // moves the back half of the largest other range to self's,
+  // which is empty. Returns false if there was nothing to take
+  bool Steal(int self)
+  {
+    std::vector<Range> &ranges = *_ranges;
+    while(true)
+    {
+      int victim = -1;
+      size_t most = 0;
+      for(int t = 0; t < _threads; ++t)
+      {
+        // read without the lock, only to pick a victim
+        size_t next = ranges[t].next;
+        size_t end = ranges[t].end;
+        if(t != self && next < end && end - next > most)
+        {
+          most = end - next;
+          victim = t;
+        }
+      }
+      if(victim < 0)
+        return false;
+
+      size_t from, to;
+      {
+        std::lock_guard<std::mutex> hold(ranges[victim].lock);
+        Range &r = ranges[victim];
+        if(r.next >= r.end)
+          continue;
+        to = r.end;
+        from = r.next + (r.end - r.next) / 2;
+        r.end = from;
+      }
+      std::lock_guard<std::mutex> hold(ranges[self].lock);
+      ranges[self].next = from;
+      ranges[self].end = to;
+      ++_steals;
+      return true;
+    }
+  }
+
+  int _threads;
+  std::vector<Range> *_ranges;
+  std::atomic<unsigned long long> _steals;
+};
+
+#endif
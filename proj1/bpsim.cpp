@@ -0,0 +1,93 @@
+/**
+ *	@file 		bpsim.cpp
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Branch predictor simulator.
+ *
+ *	@section 	DESCRIPTION
+ * 	This program runs branch predictors (see predict.h) over a
+ *      branch trace, such as mipsrun --branch-trace writes, and
+ *      reports their accuracy. A trace does not say how many
+ *      instructions ran, so MPKI and CPI are only reported when
+ *      --instructions gives it.
+ *
+ *        bpsim [--predict list] [--penalty cycles] [--instructions n]
+ *              trace
+ **********************************************************/
+
+#ifndef BPSIM_CPP
+#define BPSIM_CPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include "predict.h"
+
+int main(int argc, char *argv[])
+{
+  std::string predictors = "all";
+  int penalty = 2;
+  unsigned long long instructions = 0;
+  while(argc > 3 && argv[1][0] == '-')
+  {
+    std::string option = argv[1];
+    if(option == "--predict")
+      predictors = argv[2];
+    else if(option == "--penalty")
+      penalty = atoi(argv[2]);
+    else if(option == "--instructions")
+      instructions = strtoull(argv[2], NULL, 0);
+    argv += 2;
+    argc -= 2;
+  }
+  if(argc != 2)
+  {
+    std::cerr << "usage: bpsim [--predict list] [--penalty cycles]"
+              << " [--instructions n] trace" << std::endl;
+    return 1;
+  }
+
+  BranchPredictors predicting;
+  if(!predicting.AddList(predictors))
+  {
+    std::cerr << "error: unknown predictor in '" << predictors << "'"
+              << std::endl;
+    return 1;
+  }
+  FILE *trace = fopen(argv[1], "r");
+  if(!trace)
+  {
+    std::cerr << "error: cannot read '" << argv[1] << "'" << std::endl;
+    return 1;
+  }
+
+  std::vector<BranchOutcome> batch(TRACE_BATCH);
+  size_t count = 0;
+  int bad = 0;
+  char line[64];
+  while(fgets(line, sizeof(line), trace))
+  {
+    if(!ParseBranch(line, batch[count]))
+    {
+      ++bad;
+      continue;
+    }
+    if(++count == TRACE_BATCH)
+    {
+      predicting.Branches(&batch[0], count);
+      count = 0;
+    }
+  }
+  if(count)
+    predicting.Branches(&batch[0], count);
+  fclose(trace);
+  if(bad)
+    std::cerr << bad << " line(s) are not branches" << std::endl;
+
+  predicting.Report(std::cout, instructions, instructions, penalty, NULL);
+  return 0;
+}
+
+#endif
@@ -0,0 +1,258 @@
+/**
+ *	@file 		disasm.cpp
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Disassembler and round trip verifier.
+ *
+ *	@section 	DESCRIPTION
+ * 	This program lists the words of a .obj or object file as
+ *      source, checks that a program assembles, disassembles
+ *      and assembles again to the same words, or does the same
+ *      for millions of random instruction words and reports how
+ *      fast they disassemble.
+ *
+ *        disasm file.obj | file.o
+ *        disasm --round-trip file.s
+ *        disasm --fuzz [words] [seed]
+ **********************************************************/
+
+#ifndef DISASM_CPP
+#define DISASM_CPP
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include "onepass.h"
+#include "object.h"
+#include "disasm.h"
+
+int List(const char *);
+int RoundTrip(const char *);
+int Fuzz(int, unsigned int);
+
+int main(int argc, char *argv[])
+{
+  std::string mode = argc > 1 ? argv[1] : "";
+  if(mode == "--round-trip" && argc > 2)
+    return RoundTrip(argv[2]);
+  if(mode == "--fuzz")
+    return Fuzz(argc > 2 ? atoi(argv[2]) : 1000000,
+                argc > 3 ? atoi(argv[3]) : 1);
+  if(argc == 2 && mode[0] != '-')
+    return List(argv[1]);
+
+  std::cerr << "usage: disasm file.obj | file.o" << std::endl
+            << "       disasm --round-trip file.s" << std::endl
+            << "       disasm --fuzz [words] [seed]" << std::endl;
+  return 1;
+}
+
+// prints a program as source. An object file says where its data
+// starts, the hex words of a .obj do not, so they are all
+// disassembled as text
+int List(const char *name)
+{
+  Object obj;
+  std::vector<int> code;
+  int dataStart;
+  size_t zeroWords = 0;
+  if(ReadObject(name, obj))
+  {
+    code = obj.text;
+    code.insert(code.end(), obj.data.begin(), obj.data.end());
+    dataStart = obj.text.size();
+    zeroWords = obj.zeroWords;
+  }
+  else
+  {
+    std::ifstream hex(name);
+    if(!hex)
+    {
+      std::cerr << "error: cannot read '" << name << "'" << std::endl;
+      return 1;
+    }
+    unsigned int word;
+    while(hex >> std::hex >> word)
+      code.push_back(word);
+    dataStart = code.size();
+  }
+
+  std::vector<std::string> lines;
+  int bad = DisassembleProgram(code, dataStart, lines, zeroWords);
+  for(size_t i = 0; i < lines.size(); ++i)
+    std::cout << (lines[i][lines[i].size() - 1] == ':' || lines[i][0] == '.'
+                  ? "" : "   ") << lines[i] << std::endl;
+  if(bad)
+    std::cerr << bad << " word(s) cannot be disassembled" << std::endl;
+  return 0;
+}
+
+// assembles a source a line at a time, returns the number of errors
+int Assemble(std::istream &in, OnePass &assembler)
+{
+  std::string lineIn;
+  do
+  {
+    std::ws(in);
+    std::getline(in, lineIn);
+    if(!in) break;
+    if(!CleanLine(lineIn)) continue;
+    assembler.Line(lineIn);
+  }while(in.eof() == 0);
+  return assembler.Finish();
+}
+
+// assembles a program, disassembles it and assembles that again,
+// printing every word that came back different
+int RoundTrip(const char *name)
+{
+  std::ifstream asmFile(name);
+  if(!asmFile)
+  {
+    std::cerr << "error: cannot read '" << name << "'" << std::endl;
+    return 1;
+  }
+  OnePass first;
+  if(Assemble(asmFile, first))
+    return 1;
+
+  std::vector<std::string> lines;
+  const std::vector<int> &code = first.Code();
+  int bad = DisassembleProgram(code, first.Symbols().DataStart(), lines,
+                               first.ZeroWords());
+  std::ostringstream source;
+  for(size_t i = 0; i < lines.size(); ++i)
+    source << lines[i] << std::endl;
+  std::istringstream again(source.str());
+  OnePass second;
+  int errors = Assemble(again, second) + bad;
+
+  const std::vector<int> &back = second.Code();
+  int differ = 0;
+  for(size_t i = 0; i < code.size() || i < back.size(); ++i)
+  {
+    if(i < code.size() && i < back.size() && code[i] == back[i])
+      continue;
+    if(++differ > 10)
+      continue;
+    std::string text;
+    if(i < code.size())
+      Disassemble(code[i], i, text);
+    std::cout << "word " << std::dec << i << ": " << std::hex
+              << std::setw(8) << std::setfill('0')
+              << (i < code.size() ? code[i] : 0) << " came back as "
+              << std::setw(8) << (i < back.size() ? back[i] : 0)
+              << "  " << text << std::endl;
+  }
+  if(second.ZeroWords() != first.ZeroWords())
+  {
+    ++differ;
+    std::cout << std::dec << first.ZeroWords() << " zero words came back as "
+              << second.ZeroWords() << std::endl;
+  }
+  std::cout << std::dec << code.size() << " words, " << differ
+            << " differ" << std::endl;
+  return errors || differ ? 1 : 0;
+}
+
+// 32 random bits from a linear congruential generator, taking the
+// high half of two steps since its low bits repeat quickly
+unsigned int RandomWord(unsigned int &seed)
+{
+  seed = seed * 1103515245 + 12345;
+  unsigned int high = seed >> 16;
+  seed = seed * 1103515245 + 12345;
+  return (high << 16) | (seed >> 16);
+}
+
+// disassembles random words and checks each instruction assembles
+// back to its word. Half the words are made from a random row of
+// INSTRUCTIONS with random operand fields, so every row is covered,
+// and half are any 32 bits, most of which must be rejected
+int Fuzz(int count, unsigned int seed)
+{
+  std::vector<unsigned int> words(count);
+  std::vector<int> rows(count, -1);
+  for(int i = 0; i < count; ++i)
+  {
+    unsigned int w = RandomWord(seed);
+    if(i & 1)
+    {
+      words[i] = w;
+      continue;
+    }
+    rows[i] = RandomWord(seed) % Decoder::COUNT;
+    const InstrDesc &d = INSTRUCTIONS[rows[i]];
+    w = FixedBits(d) | (w & OperandMask(d));
+    for(int k = 0; k < 3; ++k)
+    {
+      if(d.operands[k] == RDT)
+        w = (w & ~(0x1Fu << 11)) | (((w >> 16) & 0x1F) << 11);
+    }
+    words[i] = w;
+  }
+
+  // branches sit well past 32K words so every target is positive
+  const int pc = 1 << 20;
+  std::string text;
+  int decoded = 0;
+  std::chrono::steady_clock::time_point start
+    = std::chrono::steady_clock::now();
+  for(int i = 0; i < count; ++i)
+    decoded += Disassemble(words[i], pc, text);
+  std::chrono::steady_clock::time_point end
+    = std::chrono::steady_clock::now();
+
+  SymbolTable labels;
+  std::vector<std::string> tok;
+  int failed = 0;
+  for(int i = 0; i < count; ++i)
+  {
+    const InstrDesc *d = DecodeInstruction(words[i]);
+    if(rows[i] >= 0 && d != &INSTRUCTIONS[rows[i]])
+    {
+      if(++failed <= 10)
+        std::cout << std::hex << std::setw(8) << std::setfill('0')
+                  << words[i] << std::dec << " is not decoded as '"
+                  << INSTRUCTIONS[rows[i]].name << "'" << std::endl;
+      continue;
+    }
+    if(!Disassemble(words[i], pc, text))
+      continue;
+
+    // labels are named for their address, so one table serves
+    // every word until it grows large
+    int target;
+    if(LabelTarget(*d, words[i], pc, target))
+    {
+      if(labels.Size() > 65536)
+        labels = SymbolTable();
+      labels.Define(text.substr(text.rfind('L')), target, text);
+    }
+    int errors = 0;
+    SplitStatement(text, tok);
+    unsigned int back = EncodeStatement(tok, labels, pc, text, errors);
+    if(errors || back != words[i])
+    {
+      if(++failed <= 10)
+        std::cout << std::hex << std::setw(8) << std::setfill('0')
+                  << words[i] << " -> " << text << " -> " << std::setw(8)
+                  << back << std::dec << std::endl;
+    }
+  }
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout << count << " words, " << decoded << " instructions, "
+            << std::fixed << std::setprecision(1)
+            << count / seconds / 1e6 << " M words/s, " << failed
+            << " failed the round trip" << std::endl;
+  return failed ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,334 @@
+/**
+ *	@file 		disasm.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Disassembler.
+ *
+ *	@section 	DESCRIPTION
+ * 	Turns machine words back into statements the assembler
+ *      reads. The row of INSTRUCTIONS a word encodes is found
+ *      with no search or switch: the op code picks which field
+ *      tells its instructions apart (funct for SPECIAL and
+ *      SPECIAL2, rt for REGIMM, none otherwise), and the op
+ *      code's first slot plus that field indexes a table of
+ *      rows the compiler builds from INSTRUCTIONS. A word with
+ *      bits set outside its row's fields, or rd and rt differing for clz and
+ *      clo, is not one the assembler makes and is rejected.
+ *      Branch and jump targets are written as labels L<n> of
+ *      the word address n they reach.
+ **********************************************************/
+
+#ifndef DISASM_H
+#define DISASM_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include "isa.h"
+
+// the field that tells the instructions of an op code apart
+constexpr unsigned int SubShift(int opcode)
+{
+  return opcode == 1 ? 16 : 0;
+}
+
+constexpr unsigned int SubMask(int opcode)
+{
+  return opcode == 0 || opcode == 28 ? 0x3F : opcode == 1 ? 0x1F : 0;
+}
+
+// decode table slots of an op code, one per value of its field
+constexpr unsigned int SubCount(int opcode)
+{
+  return SubMask(opcode) + 1;
+}
+
+// the first decode table slot of an op code
+constexpr unsigned int SubBase(int opcode)
+{
+  return opcode == 0 ? 0 : SubBase(opcode - 1) + SubCount(opcode - 1);
+}
+
+const unsigned int DECODE_SLOTS = SubBase(64);
+
+// the field value that picks a row among its op code's rows
+constexpr unsigned int RowSub(const InstrDesc &d)
+{
+  return SubMask(d.opcode) & (d.opcode == 1 ? d.rt : d.funct);
+}
+
+// the row with an op code and field value, or -1
+constexpr int RowWith(int opcode, unsigned int sub, int i)
+{
+  return i >= (int)(sizeof(INSTRUCTIONS) / sizeof(INSTRUCTIONS[0])) ? -1
+    : INSTRUCTIONS[i].opcode == opcode && RowSub(INSTRUCTIONS[i]) == sub ? i
+    : RowWith(opcode, sub, i + 1);
+}
+
+// the row for decode table slot j, walking the op codes from
+// opcode, whose first slot is base
+constexpr int RowInSlot(unsigned int j, int opcode, unsigned int base)
+{
+  return j >= base + SubCount(opcode)
+    ? RowInSlot(j, opcode + 1, base + SubCount(opcode))
+    : RowWith(opcode, j - base, 0);
+}
+
+// the bits of a word an operand kind fills in
+constexpr unsigned int OperandBits(Operand op)
+{
+  return op == RD ? 0x1Fu << 11
+    : op == RS ? 0x1Fu << 21
+    : op == RT || op == HINT ? 0x1Fu << 16
+    : op == RDT ? (0x1Fu << 11) | (0x1Fu << 16)
+    : op == SA ? 0x1Fu << 6
+    : op == IMM || op == BRANCH ? 0xFFFFu
+    : op == MEM ? (0x1Fu << 21) | 0xFFFFu
+    : op == TARGET ? 0x3FFFFFFu : 0;
+}
+
+// the bits a row's operands may set, the rest are fixed
+constexpr unsigned int OperandMask(const InstrDesc &d)
+{
+  return OperandBits(d.operands[0]) | OperandBits(d.operands[1])
+    | OperandBits(d.operands[2]);
+}
+
+// the fixed bits of a row's words
+constexpr unsigned int FixedBits(const InstrDesc &d)
+{
+  return ((unsigned int)d.opcode << 26) | (d.rt << 16) | d.funct;
+}
+
+template<unsigned int N>
+struct DecodeTable
+{
+  short row[N];
+};
+
+template<unsigned int... I>
+constexpr DecodeTable<sizeof...(I)> BuildDecode(Indices<I...>)
+{
+  return DecodeTable<sizeof...(I)>{{(short)RowInSlot(I, 0, 0)...}};
+}
+
+template<unsigned int N>
+struct MaskTable
+{
+  unsigned int mask[N];
+};
+
+template<unsigned int... I>
+constexpr MaskTable<sizeof...(I)> BuildMasks(Indices<I...>)
+{
+  return MaskTable<sizeof...(I)>{{OperandMask(INSTRUCTIONS[I])...}};
+}
+
+// per op code its first slot, field mask and field shift packed
+// as base << 16 | mask << 8 | shift
+template<unsigned int... I>
+constexpr MaskTable<sizeof...(I)> BuildSubFields(Indices<I...>)
+{
+  return MaskTable<sizeof...(I)>{{(SubBase(I) << 16 | SubMask(I) << 8
+                                   | SubShift(I))...}};
+}
+
+struct Decoder
+{
+  static constexpr int COUNT = sizeof(INSTRUCTIONS) / sizeof(INSTRUCTIONS[0]);
+  static constexpr DecodeTable<DECODE_SLOTS> ROWS
+    = BuildDecode(MakeIndices<DECODE_SLOTS>::type());
+  static constexpr MaskTable<COUNT> OPERANDS
+    = BuildMasks(MakeIndices<COUNT>::type());
+  static constexpr MaskTable<64> SUBFIELD
+    = BuildSubFields(MakeIndices<64>::type());
+
+  // the row a word encodes or -1
+  static int Row(unsigned int word)
+  {
+    unsigned int sub = SUBFIELD.mask[word >> 26];
+    int i = ROWS.row[(sub >> 16)
+                     + ((word >> (sub & 0xFF)) & ((sub >> 8) & 0xFF))];
+    if(i < 0 || (word & ~OPERANDS.mask[i]) != FixedBits(INSTRUCTIONS[i]))
+      return -1;
+    return i;
+  }
+};
+
+constexpr DecodeTable<DECODE_SLOTS> Decoder::ROWS;
+constexpr MaskTable<Decoder::COUNT> Decoder::OPERANDS;
+constexpr MaskTable<64> Decoder::SUBFIELD;
+
+// the row of INSTRUCTIONS a word encodes, or NULL if the
+// assembler would not make it
+inline const InstrDesc *DecodeInstruction(unsigned int word)
+{
+  int i = Decoder::Row(word);
+  if(i < 0)
+    return NULL;
+  const InstrDesc &d = INSTRUCTIONS[i];
+  int rt = (word >> 16) & 0x1F;
+  int rd = (word >> 11) & 0x1F;
+  for(int k = 0; k < 3; ++k)
+  {
+    if(d.operands[k] == RDT && rd != rt)
+      return NULL;
+  }
+  return &d;
+}
+
+// finds the word address a branch or jump at pc reaches, returns
+// false if the row has no label operand
+inline bool LabelTarget(const InstrDesc &d, unsigned int word, int pc,
+                        int &target)
+{
+  for(int k = 0; k < 3; ++k)
+  {
+    if(d.operands[k] == BRANCH)
+    {
+      target = pc + 1 + (short)(word & 0xFFFF);
+      return true;
+    }
+    if(d.operands[k] == TARGET)
+    {
+      target = word & 0x3FFFFFF;
+      return true;
+    }
+  }
+  return false;
+}
+
+// writes the statement a word at word address pc encodes into out,
+// returns false and leaves out empty if it is not an instruction
+inline bool Disassemble(unsigned int word, int pc, std::string &out)
+{
+  out.clear();
+  const InstrDesc *d = DecodeInstruction(word);
+  if(!d)
+    return false;
+
+  char buf[32];
+  int target = 0;
+  LabelTarget(*d, word, pc, target);
+  int rs = (word >> 21) & 0x1F;
+  int rt = (word >> 16) & 0x1F;
+  int rd = (word >> 11) & 0x1F;
+  short imm = word & 0xFFFF;
+  out = d->name;
+  for(int k = 0; k < 3 && d->operands[k] != NONE; ++k)
+  {
+    out += k ? "," : " ";
+    switch(d->operands[k])
+    {
+    case RD:
+    case RDT:
+      out += REGISTERS[rd].name;
+      break;
+    case RS:
+      out += REGISTERS[rs].name;
+      break;
+    case RT:
+      out += REGISTERS[rt].name;
+      break;
+    case SA:
+      snprintf(buf, sizeof(buf), "%d", (word >> 6) & 0x1F);
+      out += buf;
+      break;
+    case HINT:
+      snprintf(buf, sizeof(buf), "%d", rt);
+      out += buf;
+      break;
+    case IMM:
+      // the logical immediates are zero extended
+      if(d->opcode >= 12 && d->opcode <= 15)
+        snprintf(buf, sizeof(buf), "0x%x", word & 0xFFFF);
+      else
+        snprintf(buf, sizeof(buf), "%d", imm);
+      out += buf;
+      break;
+    case MEM:
+      snprintf(buf, sizeof(buf), "%d(%s)", imm, REGISTERS[rs].name);
+      out += buf;
+      break;
+    case BRANCH:
+    case TARGET:
+      snprintf(buf, sizeof(buf), "L%d", target);
+      out += buf;
+      break;
+    default:
+      break;
+    }
+  }
+  return true;
+}
+
+// writes a program's words as source the assembler reads back
+// into the same words: its text as statements with a label
+// L<n> at every word n a branch or jump reaches, and its data
+// as one labelled .word per word and the zeroWords zeros after
+// it as one .space. Returns the number of words
+// that cannot be written that way, text words that are not
+// instructions and targets outside the program
+inline int DisassembleProgram(const std::vector<int> &code, int dataStart,
+                              std::vector<std::string> &lines,
+                              size_t zeroWords = 0)
+{
+  int size = code.size();
+  int errors = 0;
+  std::vector<bool> labelled(size + 1, false);
+  std::vector<std::string> text(dataStart);
+  for(int pc = 0; pc < dataStart; ++pc)
+  {
+    if(!Disassemble(code[pc], pc, text[pc]))
+    {
+      ++errors;
+      continue;
+    }
+    int target;
+    if(!LabelTarget(*DecodeInstruction(code[pc]), code[pc], pc, target))
+      continue;
+    if(target < 0 || target > size || (target == size && size > dataStart))
+      ++errors;
+    else
+      labelled[target] = true;
+  }
+
+  char buf[48];
+  lines.clear();
+  lines.push_back(".text");
+  for(int pc = 0; pc <= dataStart; ++pc)
+  {
+    // data words carry their own labels
+    if(labelled[pc] && (pc < dataStart || dataStart == size))
+    {
+      snprintf(buf, sizeof(buf), "L%d:", pc);
+      lines.push_back(buf);
+    }
+    if(pc == dataStart)
+      break;
+    if(text[pc].empty())
+    {
+      snprintf(buf, sizeof(buf), "# 0x%08x is not an instruction",
+               (unsigned int)code[pc]);
+      text[pc] = buf;
+    }
+    lines.push_back(text[pc]);
+  }
+
+  if(dataStart < size || zeroWords)
+    lines.push_back(".data");
+  for(int pc = dataStart; pc < size; ++pc)
+  {
+    snprintf(buf, sizeof(buf), "L%d: .word 0x%x", pc, (unsigned int)code[pc]);
+    lines.push_back(buf);
+  }
+  if(zeroWords)
+  {
+    snprintf(buf, sizeof(buf), "L%d: .space %lu", size,
+             (unsigned long)zeroWords);
+    lines.push_back(buf);
+  }
+  return errors;
+}
+
+#endif
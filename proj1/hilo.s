@@ -0,0 +1,17 @@
+# addresses built from hi:, ha: and lo: operands
+   .text
+main:
+   lui $t0, hi:arr
+   ori $t0, $t0, lo:arr
+   lw $t1, 0($t0)
+   lui $t2, ha:last
+   lw $t3, lo:last($t2)
+   addu $a0, $t1, $t3
+   addiu $v0, $zero, 1
+   syscall
+   addiu $v0, $zero, 10
+   syscall
+
+   .data
+arr: .word 7, 8, 9
+last: .word 35
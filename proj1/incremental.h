@@ -0,0 +1,384 @@
+/**
+ *	@file 		incremental.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Incremental reassembly.
+ *
+ *	@section 	DESCRIPTION
+ * 	Incremental keeps, for every distinct source line, the
+ *      words it encodes to with their label fields left zero
+ *      and the label uses that fill them in. A line found in
+ *      the cache is not split or encoded again; its words are
+ *      copied and only its label fields are refilled from the
+ *      current addresses, a table lookup per use. After a small
+ *      edit only the changed lines are encoded. The cache is
+ *      saved between runs, holding just the lines of the last
+ *      source:
+ *
+ *        magic "ASMCACH1", version, number of lines
+ *        per line: text, words, label uses (word, use, label)
+ *
+ *      all numbers 32 bit little endian, strings preceded by
+ *      their length. The file is read into memory whole and
+ *      lines are found in it through a hash of their text, so
+ *      loading it allocates nothing per line.
+ **********************************************************/
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstring>
+#include "passes.h"
+#include "object.h"
+
+const char CACHE_MAGIC[] = "ASMCACH1";
+const int CACHE_VERSION = 1;
+
+// one line of the cache as it lies in the buffer
+struct CachedLine
+{
+  const char *text;
+  unsigned int length;
+  const char *words;        // little endian words
+  unsigned int count;
+  const char *uses;         // word, use, label length, label
+  unsigned int useCount;
+  size_t end;               // buffer offset after the line
+};
+
+class Incremental
+{
+public:
+
+  // constructor
+  Incremental(): _inData(false), _errors(0), _encoded(0), _lines(0)
+  {
+  }
+
+  // reads a saved cache, an unreadable or stale file is treated
+  // as an empty cache
+  void Load(const std::string &name)
+  {
+    _buffer.clear();
+    _index.clear();
+    std::ifstream f(name.c_str(), std::ios::binary);
+    if(!f)
+      return;
+    f.seekg(0, std::ios::end);
+    _buffer.resize((size_t)f.tellg());
+    f.seekg(0);
+    if(!_buffer.empty())
+      f.read(&_buffer[0], _buffer.size());
+    if(!Parse())
+    {
+      _buffer.clear();
+      _index.clear();
+    }
+  }
+
+  // writes the cache, keeping only the lines of this run
+  bool Save(const std::string &name) const
+  {
+    std::vector<char> out(CACHE_MAGIC, CACHE_MAGIC + OBJECT_MAGIC_SIZE);
+    PutWord(out, CACHE_VERSION);
+    PutWord(out, 0);
+
+    unsigned int lines = 0;
+    std::unordered_set<size_t> written;
+    for(size_t i = 0; i < _placed.size(); ++i)
+    {
+      size_t at = _placed[i].first;
+      if(!_placed[i].second.cached || !written.insert(at).second)
+        continue;
+      CachedLine line;
+      Walk(at, line);
+      out.insert(out.end(), _buffer.begin() + at, _buffer.begin() + line.end);
+      ++lines;
+    }
+    for(int i = 0; i < 4; ++i)
+      out[OBJECT_MAGIC_SIZE + 4 + i] = (char)((lines >> (8 * i)) & 0xFF);
+
+    std::ofstream f(name.c_str(), std::ios::binary);
+    f.write(&out[0], out.size());
+    return (bool)f;
+  }
+
+  // assembles one cleaned source line
+  void Line(const std::string &text)
+  {
+    if(text[0] == '.')
+    {
+      if(text.substr(0, text.find_first_of(" \t")) == ".data")
+      {
+        _inData = true;
+        _addressTable.SetDataStart(_code.size());
+      }
+      return;
+    }
+
+    // a text label takes no words, a data label is defined here
+    // and its words come from the cache like any other line
+    size_t colon = LabelColon(text);
+    if(colon != std::string::npos)
+    {
+      std::string label = text.substr(0, colon);
+      _errors += DefineLabel(_addressTable, label, _code.size(), text);
+      if(!_inData)
+        return;
+      _addressTable[_addressTable.Intern(label)].inData = true;
+    }
+
+    ++_lines;
+    Placement place = {(int)_code.size(), true};
+    size_t at = Lookup(text, place.cached);
+    CachedLine line;
+    Walk(at, line);
+    for(unsigned int i = 0; i < line.count; ++i)
+      _code.push_back(GetWord(line.words + 4 * i));
+    _placed.push_back(std::make_pair(at, place));
+  }
+
+  // fills in every label field and reports labels that were never
+  // defined, returns the number of errors found
+  int Finish()
+  {
+    if(_addressTable.DataStart() < 0)
+      _addressTable.SetDataStart(_code.size());
+
+    for(size_t i = 0; i < _placed.size(); ++i)
+    {
+      CachedLine line;
+      Walk(_placed[i].first, line);
+      const char *u = line.uses;
+      for(unsigned int k = 0; k < line.useCount; ++k)
+      {
+        int pc = _placed[i].second.pc + GetWord(u);
+        LabelUse use = (LabelUse)GetWord(u + 4);
+        unsigned int length = GetWord(u + 8);
+        const char *label = u + 12;
+        u += 12 + length;
+
+        Symbol &sym = _addressTable[_addressTable.Intern(label, length)];
+        if(!sym.defined)
+        {
+          if(sym.usedBy.empty())
+            sym.usedBy.assign(line.text, line.length);
+          continue;
+        }
+        bool inRange;
+        _code[pc] |= LabelValue(use, sym.address, pc,
+                                _addressTable.DataStart(), inRange);
+        if(!inRange)
+        {
+          std::cerr << "error: label '" << std::string(label, length)
+                    << "' out of range in '"
+                    << std::string(line.text, line.length) << "'"
+                    << std::endl;
+          ++_errors;
+        }
+      }
+    }
+    return _errors + _addressTable.ReportUndefined(std::cerr);
+  }
+
+  // text words followed by data words
+  const std::vector<int> &Code() const {return _code;}
+  // lines assembled and how many of them had to be encoded
+  int Lines() const {return _lines;}
+  int Encoded() const {return _encoded;}
+
+private:
+  struct Placement
+  {
+    int pc;                 // address of the line's first word
+    bool cached;            // kept for the next run
+  };
+  typedef std::unordered_map<unsigned long long, size_t> Index;
+
+  // 64 bit FNV-1a of a line, Lookup still compares the text
+  static unsigned long long LineHash(const char *s, size_t n)
+  {
+    unsigned long long h = 14695981039346656037ull;
+    for(size_t i = 0; i < n; ++i)
+      h = (h ^ (unsigned char)s[i]) * 1099511628211ull;
+    return h;
+  }
+
+  // the buffer offset of the cached line for text, encoding it
+  // onto the end of the buffer if it is not cached. A line with
+  // errors is left out of the index and the saved cache so its
+  // errors are reported again next time
+  size_t Lookup(const std::string &text, bool &cached)
+  {
+    unsigned long long h = LineHash(text.data(), text.size());
+    Index::iterator it = _index.find(h);
+    if(it != _index.end())
+    {
+      CachedLine line;
+      Walk(it->second, line);
+      if(line.length == text.size()
+         && memcmp(line.text, text.data(), text.size()) == 0)
+        return it->second;
+    }
+
+    ++_encoded;
+    int errors = 0;
+    size_t at = _buffer.size();
+    if(_inData)
+      EncodeData(text, errors);
+    else
+      EncodeText(text, errors);
+    _errors += errors;
+    cached = errors == 0;
+    if(cached)
+      _index[h] = at;
+    return at;
+  }
+
+  // appends a line's words and label uses to the buffer
+  void Append(const std::string &text)
+  {
+    PutString(_buffer, text.data(), text.size());
+    PutWord(_buffer, _words.size());
+    for(size_t i = 0; i < _words.size(); ++i)
+      PutWord(_buffer, _words[i]);
+    PutWord(_buffer, _fixups.size());
+    for(size_t i = 0; i < _fixups.size(); ++i)
+    {
+      PutWord(_buffer, _fixups[i].pc);
+      PutWord(_buffer, _fixups[i].use);
+      const std::string &label = _labels.Name(_fixups[i].symbol);
+      PutString(_buffer, label.data(), label.size());
+    }
+  }
+
+  // encodes a statement with every label left to be filled in.
+  // The labels are looked up in a table with nothing defined, so
+  // each use comes back as a fixup at its word of the line
+  void EncodeText(const std::string &text, int &errors)
+  {
+    _words.clear();
+    _fixups.clear();
+    SplitStatement(text, _tok);
+    if(!ExpandStatement(_tok, text, _expanded, errors))
+      _expanded.assign(1, text);
+    for(size_t i = 0; i < _expanded.size(); ++i)
+    {
+      SplitStatement(_expanded[i], _sub);
+      _words.push_back(EncodeStatement(_sub, _labels, i, text, errors,
+                                       &_fixups));
+    }
+    Append(text);
+  }
+
+  // the words of label: .word n, ... or label: .space n, none if
+  // a value is bad
+  void EncodeData(const std::string &text, int &errors)
+  {
+    _words.clear();
+    _fixups.clear();
+    SplitStatement(text.substr(LabelColon(text) + 1), _tok);
+    if(!_tok.empty() && !DataValuesOk(_tok, text, errors))
+      _tok.clear();
+    if(!_tok.empty() && _tok[0] == ".word")
+    {
+      for(size_t i = 1; i < _tok.size(); ++i)
+        _words.push_back(NumberValue(_tok[i]));
+    }
+    else if(!_tok.empty() && _tok[0] == ".space" && _tok.size() > 1)
+      _words.resize(NumberValue(_tok[1]), 0);
+    Append(text);
+  }
+
+  // indexes a loaded cache, false if it is not one
+  bool Parse()
+  {
+    size_t pos = OBJECT_MAGIC_SIZE + 8;
+    if(_buffer.size() < pos
+       || memcmp(&_buffer[0], CACHE_MAGIC, OBJECT_MAGIC_SIZE) != 0
+       || GetWord(&_buffer[OBJECT_MAGIC_SIZE]) != (unsigned int)CACHE_VERSION)
+      return false;
+
+    unsigned int lines = GetWord(&_buffer[OBJECT_MAGIC_SIZE + 4]);
+    _index.reserve(lines);
+    for(unsigned int i = 0; i < lines; ++i)
+    {
+      CachedLine line;
+      if(!Walk(pos, line))
+        return false;
+      _index[LineHash(line.text, line.length)] = pos;
+      pos = line.end;
+    }
+    return pos == _buffer.size();
+  }
+
+  // finds the parts of the line at pos, false if it runs past the
+  // buffer or a use is not in the line's words
+  bool Walk(size_t pos, CachedLine &line) const
+  {
+    size_t size = _buffer.size();
+    if(pos + 4 > size)
+      return false;
+    line.length = GetWord(&_buffer[pos]);
+    if(line.length > size - pos - 4)
+      return false;
+    line.text = &_buffer[pos + 4];
+    pos += 4 + line.length;
+
+    if(pos + 4 > size)
+      return false;
+    line.count = GetWord(&_buffer[pos]);
+    if(line.count > (size - pos - 4) / 4)
+      return false;
+    line.words = &_buffer[pos + 4];
+    pos += 4 + 4ull * line.count;
+
+    if(pos + 4 > size)
+      return false;
+    line.useCount = GetWord(&_buffer[pos]);
+    pos += 4;
+    line.uses = &_buffer[0] + pos;
+    for(unsigned int k = 0; k < line.useCount; ++k)
+    {
+      if(pos + 12 > size || GetWord(&_buffer[pos]) >= line.count
+         || GetWord(&_buffer[pos + 4]) > USE_LO)
+        return false;
+      unsigned int length = GetWord(&_buffer[pos + 8]);
+      if(length > size - pos - 12)
+        return false;
+      pos += 12 + length;
+    }
+    line.end = pos;
+    return true;
+  }
+
+  static void PutString(std::vector<char> &out, const char *s, size_t n)
+  {
+    PutWord(out, n);
+    out.insert(out.end(), s, s + n);
+  }
+
+  bool _inData;
+  int _errors;
+  int _encoded;
+  int _lines;
+  std::vector<char> _buffer;
+  Index _index;
+  std::vector<std::pair<size_t, Placement> > _placed;
+  std::vector<int> _code;
+  SymbolTable _addressTable;
+  SymbolTable _labels;
+  std::vector<std::string> _tok;
+  std::vector<std::string> _expanded;
+  std::vector<std::string> _sub;
+  std::vector<int> _words;
+  std::vector<Fixup> _fixups;
+};
+
+#endif
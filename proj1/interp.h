@@ -0,0 +1,1241 @@
+/**
+ *	@file 		interp.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		MIPS interpreter.
+ *
+ *	@section 	DESCRIPTION
+ * 	Interpreter runs assembled programs. Every text word is
+ *      decoded once, when the program is loaded, into a small
+ *      Decoded record: the row of INSTRUCTIONS it encodes, its
+ *      registers, and its immediate already extended the way
+ *      the instruction uses it, with branch and jump targets
+ *      turned into word addresses. Run then dispatches on the
+ *      row through a table of label addresses (computed goto),
+ *      one indirect jump per instruction with no switch.
+ *
+ *      Memory (see memory.h) holds text from 0, data after it
+ *      and a stack at the top; $gp holds the data start and $sp
+ *      the top. It is paged and allocated as it is written, so
+ *      the zeros .space reserves take nothing until used, and
+ *      the loaded words are read where LoadProgram left them,
+ *      an object file's in its mapping, until stored into.
+ *      Addresses in registers are byte addresses, words are
+ *      stored in host (little endian) order, and there are no
+ *      delay slots, as in SPIM. The SPIM syscalls print int
+ *      (1), print string (4), read int (5), exit (10), print
+ *      char (11) and exit2 (17) are handled. A write to $zero
+ *      goes to a spare register 32 that is never read, so no
+ *      instruction has to check for it. The instruction limit
+ *      is checked on jumps and taken branches only, so straight
+ *      line code is not slowed down and Run stops at most one
+ *      basic block past the limit.
+ *
+ *      With Translate on, code runs from a cache of basic
+ *      blocks instead, each translated from the decoded text
+ *      the first time it is reached. A block starts with an
+ *      entry record that counts all its instructions at once
+ *      and checks the limit, common pairs such as slt+beq and
+ *      lw+addu become one superinstruction dispatched once,
+ *      and a branch leaving a block is chained: the first time
+ *      it is taken its record is patched to point straight at
+ *      the translated successor. A store into the text decodes
+ *      that word again, and drops every translated block.
+ *
+ *      Given a RefSink, Run also reports every memory reference
+ *      the program makes, each instruction fetch and each load
+ *      and store, as the MemRef records of the cache simulator
+ *      (../proj2/trace.h), handed over in batches. Traced runs
+ *      use the plain dispatch, which sees every instruction.
+ *      A BranchSink gets just the pc and direction of every
+ *      conditional branch, cheaply enough to run predictors on
+ *      at near full speed.
+ **********************************************************/
+
+#ifndef INTERP_H
+#define INTERP_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include "object.h"
+#include "disasm.h"
+#include "memory.h"
+#include "../proj2/trace.h"
+
+// default memory size in bytes, the stack starts at the top
+const size_t DEFAULT_MEMORY = 4 << 20;
+
+// ops past the rows of INSTRUCTIONS
+enum
+{
+  OP_END = sizeof(INSTRUCTIONS) / sizeof(INSTRUCTIONS[0]), // ran off text
+  OP_BAD_TARGET,            // branched outside the text
+  OP_INVALID,               // not an instruction
+
+  // only in translated blocks
+  OP_ENTER,                 // block entry, imm is its instruction count
+  OP_GOTO,                  // falls through to the next block
+  OP_SLT_BEQ,               // superinstructions, each run together
+  OP_SLT_BNE,               // with the record after it
+  OP_LW_ADDU,
+  OP_ADDIU_BNE,
+  OP_SLL_ADDU,
+  OP_COUNT
+};
+
+// most instructions in one translated block
+const int MAX_BLOCK = 64;
+
+// references handed to a RefSink at a time
+const size_t TRACE_BATCH = 4096;
+
+// receives the memory references of a traced run in the order
+// they are made
+class RefSink
+{
+public:
+  virtual ~RefSink() {}
+  virtual void Refs(const MemRef *refs, size_t count) = 0;
+};
+
+// a conditional branch as it ran, pc and target are byte addresses
+struct BranchOutcome
+{
+  unsigned int pc;
+  unsigned int target;
+  bool taken;
+};
+
+// receives the conditional branches of a run in the order they run
+class BranchSink
+{
+public:
+  virtual ~BranchSink() {}
+  virtual void Branches(const BranchOutcome *branches, size_t count) = 0;
+};
+
+// the registers with names the interpreter uses
+enum
+{
+  REG_V0 = 2,
+  REG_A0 = 4,
+  REG_GP = 28,
+  REG_SP = 29,
+  REG_RA = 31,
+  REG_SINK = 32             // where writes to $zero go
+};
+
+// why Run returned
+enum Stop
+{
+  STOP_EXIT,                // exit syscall
+  STOP_END,                 // ran past the last text word
+  STOP_LIMIT,               // executed the instructions asked for
+  STOP_FAULT                // see Fault()
+};
+
+// a text word decoded for execution
+struct Decoded
+{
+  unsigned char op;         // row of INSTRUCTIONS or an OP_ value
+  unsigned char rs;
+  unsigned char rt;
+  unsigned char rd;         // register written, REG_SINK if none
+  int imm;                  // extended immediate, shift amount or
+                            // target word address
+};
+
+// the row of INSTRUCTIONS with a name, for the dispatch table
+constexpr bool SameName(const char *a, const char *b)
+{
+  return *a == *b && (*a == 0 || SameName(a + 1, b + 1));
+}
+
+constexpr int RowOf(const char *name, int i = 0)
+{
+  return i >= OP_END ? -1
+    : SameName(INSTRUCTIONS[i].name, name) ? i : RowOf(name, i + 1);
+}
+
+// pairs of rows run as one superinstruction
+struct FusedPair
+{
+  int first;
+  int second;
+  int op;
+};
+
+const FusedPair FUSED_PAIRS[] =
+{
+  {RowOf("slt"), RowOf("beq"), OP_SLT_BEQ},
+  {RowOf("slt"), RowOf("bne"), OP_SLT_BNE},
+  {RowOf("lw"), RowOf("addu"), OP_LW_ADDU},
+  {RowOf("addiu"), RowOf("bne"), OP_ADDIU_BNE},
+  {RowOf("sll"), RowOf("addu"), OP_SLL_ADDU},
+};
+
+// decodes a text word at pc of a program with the given number
+// of text words
+inline Decoded DecodeWord(unsigned int word, int pc, int textWords)
+{
+  Decoded d = {OP_INVALID, 0, 0, REG_SINK, 0};
+  const InstrDesc *desc = DecodeInstruction(word);
+  if(!desc)
+    return d;
+
+  d.op = desc - INSTRUCTIONS;
+  d.rs = (word >> 21) & 0x1F;
+  d.rt = (word >> 16) & 0x1F;
+  int rd = (word >> 11) & 0x1F;
+
+  // the register an instruction writes: rd if it has one, else
+  // a leading rt unless it is the value a store stores
+  bool store = desc->opcode >= 40 && desc->opcode <= 46;
+  int dest = -1;
+  for(int k = 0; k < 3; ++k)
+  {
+    if(desc->operands[k] == RD || desc->operands[k] == RDT)
+      dest = rd;
+  }
+  if(dest < 0 && desc->operands[0] == RT && !store)
+    dest = d.rt;
+  if(dest > 0)
+    d.rd = dest;
+
+  // logical immediates are zero extended, the rest sign extended
+  if(desc->opcode >= 12 && desc->opcode <= 14)
+    d.imm = word & 0xFFFF;
+  else if(desc->opcode == 15)
+    d.imm = (word & 0xFFFF) << 16;
+  else
+    d.imm = (short)(word & 0xFFFF);
+
+  if(desc->format == R_TYPE)
+    d.imm = (word >> 6) & 0x1F;
+
+  int target;
+  if(LabelTarget(*desc, word, pc, target))
+  {
+    if(target < 0 || target > textWords)
+      target = textWords + 1;
+    d.imm = target;
+  }
+  return d;
+}
+
+// a label in the text, for reports
+struct TextLabel
+{
+  int pc;                   // word address
+  std::string name;
+  bool operator<(const TextLabel &b) const
+  {
+    return pc != b.pc ? pc < b.pc : name < b.name;
+  }
+};
+
+// a program to run: text words, then data words from dataStart,
+// then zeroWords zero words that are not held. The words are an
+// object file's in place when it is mapped, else code's
+struct Program
+{
+  Program(): dataStart(0), zeroWords(0) {}
+
+  const int *Words() const
+  {
+    return mapped.Mapped() ? (const int *)mapped.Words() : code.data();
+  }
+  size_t Size() const
+  {
+    return mapped.Mapped() ? mapped.Header().textWords
+      + mapped.Header().dataWords : code.size();
+  }
+  // a copy of the text words
+  std::vector<int> Text() const
+  {
+    return std::vector<int>(Words(), Words() + dataStart);
+  }
+
+  std::vector<int> code;
+  MappedObject mapped;
+  int dataStart;
+  size_t zeroWords;
+  std::vector<TextLabel> labels;    // by pc, none for hex words
+};
+
+// a program's text decoded once, with the sentinels past its end,
+// for any number of interpreters to run at once. Nothing changes
+// it after the constructor, so threads need no lock to share it.
+// The program must outlive it
+class Image
+{
+public:
+  Image(const Program &program): _program(program)
+  {
+    const int *code = program.Words();
+    int dataStart = program.dataStart;
+    _text.resize(dataStart + 2);
+    for(int pc = 0; pc < dataStart; ++pc)
+      _text[pc] = DecodeWord(code[pc], pc, dataStart);
+    Decoded end = {OP_END, 0, 0, REG_SINK, 0};
+    Decoded bad = {OP_BAD_TARGET, 0, 0, REG_SINK, 0};
+    _text[dataStart] = end;
+    _text[dataStart + 1] = bad;
+  }
+
+  const Program &Source() const {return _program;}
+  const std::vector<Decoded> &Text() const {return _text;}
+
+private:
+  const Program &_program;
+  std::vector<Decoded> _text;
+};
+
+// the registers and counters of an interpreter, all of its state
+// but memory, as a snapshot keeps them
+struct MachineState
+{
+  unsigned int reg[33];
+  unsigned int hi;
+  unsigned int lo;
+  int pc;
+  unsigned long long executed;
+  int exitCode;
+  size_t inputs;            // values read so far
+};
+
+class Interpreter
+{
+public:
+
+  // constructor, loads a decoded program into memory of at least
+  // memoryBytes, more if it needs more. The image and its program
+  // must outlive the interpreter, which runs the decoded text and
+  // reads the words in place until it stores into them
+  Interpreter(const Image &image, size_t memoryBytes = DEFAULT_MEMORY)
+    : _in(&std::cin), _out(&std::cout), _text(&image.Text()[0]),
+      _textSize(image.Text().size()),
+      _memory(MemoryFor(image.Source(), memoryBytes)), _pc(0), _hi(0),
+      _lo(0), _executed(0), _exitCode(0), _translate(false), _blocks(0),
+      _chained(0), _lookups(0), _flushes(0), _sink(NULL),
+      _refCount(0), _branchSink(NULL), _outcomeCount(0), _inputLog(NULL),
+      _inputs(0)
+  {
+    const Program &program = image.Source();
+    int dataStart = program.dataStart;
+    _memory.Map(0, program.Words(), program.Size() * 4);
+
+    memset(_reg, 0, sizeof(_reg));
+    _reg[REG_GP] = dataStart * 4;
+    _reg[REG_SP] = _memory.Size();
+  }
+
+  // sends the references of later runs to sink, none if NULL
+  void Trace(RefSink *sink)
+  {
+    _sink = sink;
+    _refs.resize(sink ? TRACE_BATCH : 0);
+    _refCount = 0;
+  }
+
+  // sends the conditional branches of later runs to sink
+  void WatchBranches(BranchSink *sink)
+  {
+    _branchSink = sink;
+    _outcomes.resize(sink ? TRACE_BATCH : 0);
+    _outcomeCount = 0;
+  }
+
+  // runs from translated basic blocks or not
+  void Translate(bool on)
+  {
+    _translate = on;
+    if(on && _entry.empty())
+      _entry.assign(_textSize, -1);
+  }
+
+  // where syscalls read and print
+  void Streams(std::istream &in, std::ostream &out)
+  {
+    _in = &in;
+    _out = &out;
+  }
+
+  // keeps every value a syscall reads in log, and reads from it
+  // instead of the input while it has values left, so a run over
+  // a log repeats the run that made it
+  void LogInput(std::vector<int> *log)
+  {
+    _inputLog = log;
+  }
+
+  // runs from the current pc until the program stops or about
+  // limit more instructions have run
+  Stop Run(unsigned long long limit = ULLONG_MAX)
+  {
+    if(_sink)
+      return _branchSink ? Execute<false, true, true>(limit)
+        : Execute<false, true, false>(limit);
+    if(_branchSink)
+      return Execute<false, false, true>(limit);
+    return _translate ? Execute<true, false, false>(limit)
+      : Execute<false, false, false>(limit);
+  }
+
+  // runs until the program stops or exactly count more
+  // instructions have run, with no sinks, one at a time
+  Stop RunExactly(unsigned long long count)
+  {
+    return count ? Execute<false, false, false, true>(count) : STOP_LIMIT;
+  }
+
+  void Save(MachineState &state) const
+  {
+    memcpy(state.reg, _reg, sizeof(_reg));
+    state.hi = _hi;
+    state.lo = _lo;
+    state.pc = _pc;
+    state.executed = _executed;
+    state.exitCode = _exitCode;
+    state.inputs = _inputs;
+  }
+
+  // goes back to a saved state. The caller restores the memory
+  // first, textChanged if any of the text is different
+  void Restore(const MachineState &state, bool textChanged)
+  {
+    memcpy(_reg, state.reg, sizeof(_reg));
+    _hi = state.hi;
+    _lo = state.lo;
+    _pc = state.pc;
+    _executed = state.executed;
+    _exitCode = state.exitCode;
+    _inputs = state.inputs;
+    if(textChanged)
+    {
+      for(int pc = 0; pc < TextWords(); ++pc)
+        Redecode(pc);
+      if(!_entry.empty())
+        DropBlocks();
+    }
+  }
+
+  GuestMemory &Memory() {return _memory;}
+
+  unsigned long long Executed() const {return _executed;}
+  int ExitCode() const {return _exitCode;}
+  const std::string &Fault() const {return _fault;}
+  int Pc() const {return _pc;}
+  unsigned int Register(int r) const {return _reg[r];}
+  unsigned int Hi() const {return _hi;}
+  unsigned int Lo() const {return _lo;}
+  int TextWords() const {return _textSize - 2;}
+  // memory pages the program has written
+  size_t PagesTouched() const {return _memory.Pages();}
+  // blocks translated, branches that followed a chain, blocks
+  // looked up by address and times a store into the text
+  // dropped them all
+  unsigned long long Blocks() const {return _blocks;}
+  unsigned long long ChainHits() const {return _chained;}
+  unsigned long long Lookups() const {return _lookups;}
+  unsigned long long Flushes() const {return _flushes;}
+
+private:
+  // the memory a program needs: its words and zeros and a page
+  // of stack, or memoryBytes if more
+  static size_t MemoryFor(const Program &program, size_t memoryBytes)
+  {
+    size_t bytes = (program.Size() + program.zeroWords) * 4 + PAGE_SIZE;
+    return memoryBytes < bytes ? bytes : memoryBytes;
+  }
+
+  // stops with a fault message for the word at pc, naming the
+  // address involved if there is one
+  Stop Fail(const char *what, int pc, long long address = -1)
+  {
+    char buf[128];
+    if(address >= 0)
+      snprintf(buf, sizeof(buf), "%s 0x%llx at word %d", what, address, pc);
+    else
+      snprintf(buf, sizeof(buf), "%s at word %d", what, pc);
+    _fault = buf;
+    return STOP_FAULT;
+  }
+
+  // handles a syscall, returns false if the program exits
+  bool Syscall(int pc, Stop &stop);
+
+  // EXACT checks the limit after every instruction
+  template<bool BLOCKS, bool TRACE, bool BRANCHES, bool EXACT = false>
+  Stop Execute(unsigned long long limit);
+
+  // true for rows that write memory
+  static bool Stores(int op)
+  {
+    int opcode = INSTRUCTIONS[op].opcode;
+    return (opcode >= 40 && opcode <= 46) || opcode == 56;
+  }
+
+  // records a reference, passing them on a batch at a time
+  void Reference(unsigned int address, bool write, int size)
+  {
+    MemRef &r = _refs[_refCount];
+    r.address = address;
+    r.write = write;
+    r.size = size;
+    if(++_refCount == TRACE_BATCH)
+      FlushRefs();
+  }
+
+  // records a conditional branch and returns whether it is taken
+  bool Outcome(int pc, int target, bool taken)
+  {
+    BranchOutcome &b = _outcomes[_outcomeCount];
+    b.pc = pc * 4;
+    b.target = target * 4;
+    b.taken = taken;
+    if(++_outcomeCount == TRACE_BATCH)
+      FlushOutcomes();
+    return taken;
+  }
+
+  void FlushOutcomes()
+  {
+    if(_outcomeCount)
+      _branchSink->Branches(&_outcomes[0], _outcomeCount);
+    _outcomeCount = 0;
+  }
+
+  void FlushRefs()
+  {
+    if(_refCount)
+      _sink->Refs(&_refs[0], _refCount);
+    _refCount = 0;
+  }
+
+  // appends a record of a translated block
+  void Emit(const Decoded &d, int pc)
+  {
+    _code.push_back(d);
+    _guest.push_back(pc);
+  }
+
+  // the superinstruction for two rows or -1
+  static int Fused(int first, int second)
+  {
+    for(size_t i = 0; i < sizeof(FUSED_PAIRS) / sizeof(FUSED_PAIRS[0]); ++i)
+    {
+      if(FUSED_PAIRS[i].first == first && FUSED_PAIRS[i].second == second)
+        return FUSED_PAIRS[i].op;
+    }
+    return -1;
+  }
+
+  int TranslateBlock(int pc);
+
+  // the record the block at pc starts at, translating it if needed
+  int Lookup(int pc)
+  {
+    ++_lookups;
+    if(_entry[pc] < 0)
+      TranslateBlock(pc);
+    return _entry[pc];
+  }
+
+  // points a branch record, whose imm is -1 - the pc it goes
+  // to, at the block there and returns the block's record
+  int Link(size_t record)
+  {
+    int t = Lookup(-_code[record].imm - 1);
+    _code[record].imm = t;
+    return t;
+  }
+
+  // a store changed the text word holding address
+  void TextWritten(unsigned int address)
+  {
+    Redecode(address / 4);
+    if(!_entry.empty())
+    {
+      DropBlocks();
+      ++_flushes;
+    }
+  }
+
+  // decodes the text word at pc again from memory
+  void Redecode(int pc)
+  {
+    unsigned int word;
+    memcpy(&word, _memory.Read(pc * 4), 4);
+    if(_written.empty())
+    {
+      // the shared text is copied to be changed
+      _written.assign(_text, _text + _textSize);
+      _text = &_written[0];
+    }
+    _written[pc] = DecodeWord(word, pc, TextWords());
+  }
+
+  void DropBlocks()
+  {
+    _code.clear();
+    _guest.clear();
+    _entry.assign(_textSize, -1);
+  }
+
+  std::istream *_in;
+  std::ostream *_out;
+  // the decoded text, the image's until a store changes it, then
+  // a copy of our own
+  const Decoded *_text;
+  size_t _textSize;
+  std::vector<Decoded> _written;
+  GuestMemory _memory;
+  unsigned int _reg[33];
+  int _pc;
+  unsigned int _hi;
+  unsigned int _lo;
+  unsigned long long _executed;
+  int _exitCode;
+  std::string _fault;
+
+  // the block cache: translated records, the pc of each, and the
+  // record the block at each pc starts at
+  bool _translate;
+  std::vector<Decoded> _code;
+  std::vector<int> _guest;
+  std::vector<int> _entry;
+  unsigned long long _blocks;
+  unsigned long long _chained;
+  unsigned long long _lookups;
+  unsigned long long _flushes;
+
+  RefSink *_sink;
+  std::vector<MemRef> _refs;
+  size_t _refCount;
+  BranchSink *_branchSink;
+  std::vector<BranchOutcome> _outcomes;
+  size_t _outcomeCount;
+  std::vector<int> *_inputLog;
+  size_t _inputs;
+};
+
+// translates the basic block at pc: its instructions up to the
+// first jump, branch or syscall, with fused pairs merged and a
+// goto to the next pc after anything that can fall through.
+// Successors are linked when first taken
+inline int Interpreter::TranslateBlock(int pc)
+{
+  int at = _code.size();
+  int start = pc;
+  int textWords = TextWords();
+  int n = 0;
+  Decoded enter = {OP_ENTER, 0, 0, REG_SINK, 0};
+  Emit(enter, pc);
+
+  while(true)
+  {
+    Decoded x = _text[pc];
+    if(x.op >= OP_END)
+    {
+      Emit(x, pc);
+      break;
+    }
+    int fused = pc + 1 < textWords ? Fused(x.op, _text[pc + 1].op) : -1;
+    if(fused >= 0)
+    {
+      x.op = fused;
+      Emit(x, pc);
+      ++n;
+      x = _text[++pc];
+    }
+
+    const InstrDesc &desc = INSTRUCTIONS[x.op];
+    int target;
+    bool branch = LabelTarget(desc, 0, 0, target);
+    bool conditional = branch && desc.format != J_TYPE;
+    if(branch)
+      x.imm = -x.imm - 1;
+    Emit(x, pc);
+    ++n;
+    ++pc;
+
+    if((branch && !conditional) || x.op == RowOf("jr")
+       || x.op == RowOf("jalr"))
+      break;
+    if(conditional || x.op == RowOf("syscall") || x.op == RowOf("break")
+       || n >= MAX_BLOCK)
+    {
+      Decoded next = {OP_GOTO, 0, 0, REG_SINK, -pc - 1};
+      Emit(next, pc);
+      break;
+    }
+  }
+  _code[at].imm = n;
+  _entry[start] = at;
+  ++_blocks;
+  return at;
+}
+
+inline bool Interpreter::Syscall(int pc, Stop &stop)
+{
+  unsigned int a0 = _reg[REG_A0];
+  switch(_reg[REG_V0])
+  {
+  case 1:
+    *_out << (int)a0;
+    return true;
+  case 4:
+    for(; a0 < _memory.Size() && *_memory.Read(a0); ++a0)
+      _out->put(*_memory.Read(a0));
+    if(a0 >= _memory.Size())
+    {
+      stop = Fail("string runs past memory from", pc, _reg[REG_A0]);
+      return false;
+    }
+    return true;
+  case 5:
+  {
+    int value = 0;
+    if(_inputLog && _inputs < _inputLog->size())
+      value = (*_inputLog)[_inputs];
+    else
+    {
+      *_in >> value;
+      if(_inputLog)
+        _inputLog->push_back(value);
+    }
+    ++_inputs;
+    _reg[REG_V0] = value;
+    return true;
+  }
+  case 11:
+    _out->put((char)a0);
+    return true;
+  case 10:
+    _exitCode = 0;
+    stop = STOP_EXIT;
+    return false;
+  case 17:
+    _exitCode = a0;
+    stop = STOP_EXIT;
+    return false;
+  default:
+    stop = Fail("unknown syscall", pc, _reg[REG_V0]);
+    return false;
+  }
+}
+
+template<bool BLOCKS, bool TRACE, bool BRANCHES, bool EXACT>
+inline Stop Interpreter::Execute(unsigned long long limit)
+{
+  // handler for every row, rows without one are not supported
+  void *ops[OP_COUNT];
+  for(int i = 0; i < OP_COUNT; ++i)
+    ops[i] = &&unsupported;
+#define HANDLER(name, label) ops[RowOf(name)] = &&label
+  HANDLER("sll", op_sll);     HANDLER("srl", op_srl);
+  HANDLER("sra", op_sra);     HANDLER("sllv", op_sllv);
+  HANDLER("srlv", op_srlv);   HANDLER("srav", op_srav);
+  HANDLER("jr", op_jr);       HANDLER("jalr", op_jalr);
+  HANDLER("movz", op_movz);   HANDLER("movn", op_movn);
+  HANDLER("syscall", op_syscall);
+  HANDLER("break", op_break); HANDLER("sync", op_nop);
+  HANDLER("mfhi", op_mfhi);   HANDLER("mthi", op_mthi);
+  HANDLER("mflo", op_mflo);   HANDLER("mtlo", op_mtlo);
+  HANDLER("mult", op_mult);   HANDLER("multu", op_multu);
+  HANDLER("div", op_div);     HANDLER("divu", op_divu);
+  HANDLER("add", op_add);     HANDLER("addu", op_addu);
+  HANDLER("sub", op_sub);     HANDLER("subu", op_subu);
+  HANDLER("and", op_and);     HANDLER("or", op_or);
+  HANDLER("xor", op_xor);     HANDLER("nor", op_nor);
+  HANDLER("slt", op_slt);     HANDLER("sltu", op_sltu);
+  HANDLER("tge", op_tge);     HANDLER("tgeu", op_tgeu);
+  HANDLER("tlt", op_tlt);     HANDLER("tltu", op_tltu);
+  HANDLER("teq", op_teq);     HANDLER("tne", op_tne);
+  HANDLER("bltz", op_bltz);   HANDLER("bgez", op_bgez);
+  HANDLER("bltzl", op_bltz);  HANDLER("bgezl", op_bgez);
+  HANDLER("tgei", op_tgei);   HANDLER("tgeiu", op_tgeiu);
+  HANDLER("tlti", op_tlti);   HANDLER("tltiu", op_tltiu);
+  HANDLER("teqi", op_teqi);   HANDLER("tnei", op_tnei);
+  HANDLER("bltzal", op_bltzal); HANDLER("bgezal", op_bgezal);
+  HANDLER("bltzall", op_bltzal); HANDLER("bgezall", op_bgezal);
+  HANDLER("j", op_j);         HANDLER("jal", op_jal);
+  HANDLER("beq", op_beq);     HANDLER("bne", op_bne);
+  HANDLER("blez", op_blez);   HANDLER("bgtz", op_bgtz);
+  HANDLER("beql", op_beq);    HANDLER("bnel", op_bne);
+  HANDLER("blezl", op_blez);  HANDLER("bgtzl", op_bgtz);
+  HANDLER("addi", op_addi);   HANDLER("addiu", op_addiu);
+  HANDLER("slti", op_slti);   HANDLER("sltiu", op_sltiu);
+  HANDLER("andi", op_andi);   HANDLER("ori", op_ori);
+  HANDLER("xori", op_xori);   HANDLER("lui", op_lui);
+  HANDLER("madd", op_madd);   HANDLER("maddu", op_maddu);
+  HANDLER("mul", op_mul);     HANDLER("msub", op_msub);
+  HANDLER("msubu", op_msubu); HANDLER("clz", op_clz);
+  HANDLER("clo", op_clo);
+  HANDLER("lb", op_lb);       HANDLER("lh", op_lh);
+  HANDLER("lw", op_lw);       HANDLER("lbu", op_lbu);
+  HANDLER("lhu", op_lhu);     HANDLER("sb", op_sb);
+  HANDLER("sh", op_sh);       HANDLER("sw", op_sw);
+  HANDLER("ll", op_lw);       HANDLER("sc", op_sc);
+  HANDLER("pref", op_nop);
+#undef HANDLER
+  ops[OP_END] = &&end;
+  ops[OP_BAD_TARGET] = &&bad_target;
+  ops[OP_INVALID] = &&invalid;
+  ops[OP_ENTER] = &&op_enter;
+  ops[OP_GOTO] = &&op_goto;
+  ops[OP_SLT_BEQ] = &&op_slt_beq;
+  ops[OP_SLT_BNE] = &&op_slt_bne;
+  ops[OP_LW_ADDU] = &&op_lw_addu;
+  ops[OP_ADDIU_BNE] = &&op_addiu_bne;
+  ops[OP_SLL_ADDU] = &&op_sll_addu;
+
+  // the records run, decoded text or translated blocks, and the
+  // entry record of the block running
+  const Decoded *base = BLOCKS ? _code.data() : _text;
+  const Decoded *d = base + (BLOCKS ? 0 : _pc);
+  const Decoded *block = NULL;
+  unsigned long long chained = 0;
+  unsigned int *R = _reg;
+  const unsigned char *const *readable = _memory.Readable();
+  unsigned char *const *writable = _memory.Writable();
+  size_t size = _memory.Size();
+  unsigned long long count = _executed;
+  unsigned long long stopAt = limit > ULLONG_MAX - count ? ULLONG_MAX
+    : count + limit;
+  unsigned int textWords = TextWords();
+  unsigned int textBytes = textWords * 4;
+  Stop stop = STOP_END;
+  unsigned int address = 0;
+  unsigned long long wide;
+
+// the pc of a record
+#define AT(p) (BLOCKS ? _guest[(p) - base] : (int)((p) - base))
+// runs the next instruction, blocks count theirs on entry
+#define NEXT ++d; if(!BLOCKS) ++count; \
+    if(EXACT && count >= stopAt) goto limit_reached; \
+    FETCH; goto *ops[d->op]
+// a traced run records the fetch of every instruction it runs
+#define FETCH if(TRACE && d->op < OP_END) Reference((d - base) * 4, false, 4)
+// moves to a word address, stopping if the limit has been reached.
+// Blocks check the limit on entry
+#define JUMP(target) { if(BLOCKS) { int t = Lookup(target); \
+      base = _code.data(); d = base + t; goto *ops[d->op]; } \
+    d = base + (target); ++count; \
+    if(count >= stopAt) { goto limit_reached; } \
+    FETCH; \
+    goto *ops[d->op]; }
+// takes the branch of a record, in a block following its chain
+// or linking it
+#define BRANCH(rec) { if(!BLOCKS) JUMP((rec)->imm); \
+    int t = (rec)->imm; \
+    if(t < 0) { t = Link((rec) - base); base = _code.data(); } \
+    else ++chained; \
+    d = base + t; goto *ops[d->op]; }
+// takes a conditional branch if cond holds, telling a BranchSink
+#define TAKEN(cond) \
+    if(BRANCHES ? Outcome(AT(d), d->imm, cond) : (cond)) BRANCH(d)
+// a store into the text has to be decoded again
+#define STORED if(address < textBytes) goto text_written
+// the byte address of a load or store, which must be aligned and
+// in memory
+#define ADDRESS(bytes) address = R[d->rs] + d->imm; \
+    if((address & ((bytes) - 1)) || address > size - (bytes)) \
+      goto bad_address; \
+    if(TRACE) Reference(address, Stores(d->op), bytes)
+// the same for a store, whose page must have been written before.
+// If not the page is given one and the store runs again
+#define STORE_ADDRESS(bytes) address = R[d->rs] + d->imm; \
+    if((address & ((bytes) - 1)) || address > size - (bytes)) \
+      goto bad_address; \
+    if(!writable[address >> PAGE_BITS]) goto touch_page; \
+    if(TRACE) Reference(address, true, bytes)
+// the host bytes behind a load's and a store's address
+#define LOADED (readable[address >> PAGE_BITS] + (address & PAGE_MASK))
+#define STORING (writable[address >> PAGE_BITS] + (address & PAGE_MASK))
+
+  if(BLOCKS)
+    JUMP(_pc);
+  FETCH;
+  goto *ops[d->op];
+
+op_enter:
+  if(count >= stopAt)
+    goto limit_reached;
+  block = d;
+  count += d->imm;
+  ++d;
+  goto *ops[d->op];
+op_goto:
+  BRANCH(d);
+op_slt_beq:
+  R[d->rd] = (int)R[d->rs] < (int)R[d->rt];
+  ++d;
+  TAKEN(R[d->rs] == R[d->rt]);
+  NEXT;
+op_slt_bne:
+  R[d->rd] = (int)R[d->rs] < (int)R[d->rt];
+  ++d;
+  TAKEN(R[d->rs] != R[d->rt]);
+  NEXT;
+op_lw_addu:
+  ADDRESS(4);
+  memcpy(&R[d->rd], LOADED, 4);
+  ++d;
+  R[d->rd] = R[d->rs] + R[d->rt];
+  NEXT;
+op_addiu_bne:
+  R[d->rd] = R[d->rs] + d->imm;
+  ++d;
+  TAKEN(R[d->rs] != R[d->rt]);
+  NEXT;
+op_sll_addu:
+  R[d->rd] = R[d->rt] << d->imm;
+  ++d;
+  R[d->rd] = R[d->rs] + R[d->rt];
+  NEXT;
+
+op_sll:   R[d->rd] = R[d->rt] << d->imm; NEXT;
+op_srl:   R[d->rd] = R[d->rt] >> d->imm; NEXT;
+op_sra:   R[d->rd] = (int)R[d->rt] >> d->imm; NEXT;
+op_sllv:  R[d->rd] = R[d->rt] << (R[d->rs] & 31); NEXT;
+op_srlv:  R[d->rd] = R[d->rt] >> (R[d->rs] & 31); NEXT;
+op_srav:  R[d->rd] = (int)R[d->rt] >> (R[d->rs] & 31); NEXT;
+op_jr:
+  address = R[d->rs];
+  if((address & 3) || address / 4 >= textWords)
+    goto bad_jump;
+  JUMP(address / 4);
+op_jalr:
+  address = R[d->rs];
+  R[d->rd] = (AT(d) + 1) * 4;
+  if((address & 3) || address / 4 >= textWords)
+    goto bad_jump;
+  JUMP(address / 4);
+op_movz: if(R[d->rt] == 0) R[d->rd] = R[d->rs]; NEXT;
+op_movn: if(R[d->rt] != 0) R[d->rd] = R[d->rs]; NEXT;
+op_syscall:
+  _pc = AT(d);
+  if(!Syscall(_pc, stop))
+  {
+    if(!BLOCKS)
+      ++count;
+    goto done;
+  }
+  NEXT;
+op_break:
+  stop = Fail("break", AT(d));
+  goto done;
+op_nop:   NEXT;
+op_mfhi:  R[d->rd] = _hi; NEXT;
+op_mthi:  _hi = R[d->rs]; NEXT;
+op_mflo:  R[d->rd] = _lo; NEXT;
+op_mtlo:  _lo = R[d->rs]; NEXT;
+op_mult:
+  wide = (long long)(int)R[d->rs] * (int)R[d->rt];
+  _lo = wide; _hi = wide >> 32; NEXT;
+op_multu:
+  wide = (unsigned long long)R[d->rs] * R[d->rt];
+  _lo = wide; _hi = wide >> 32; NEXT;
+op_div:
+  // division by zero leaves HI and LO as they were
+  if(R[d->rt] != 0 && !((int)R[d->rs] == INT_MIN && (int)R[d->rt] == -1))
+  {
+    _lo = (int)R[d->rs] / (int)R[d->rt];
+    _hi = (int)R[d->rs] % (int)R[d->rt];
+  }
+  else if(R[d->rt] != 0)
+  {
+    _lo = R[d->rs];
+    _hi = 0;
+  }
+  NEXT;
+op_divu:
+  if(R[d->rt] != 0)
+  {
+    _lo = R[d->rs] / R[d->rt];
+    _hi = R[d->rs] % R[d->rt];
+  }
+  NEXT;
+op_add:
+  if(__builtin_add_overflow((int)R[d->rs], (int)R[d->rt], (int *)&address))
+    goto overflow;
+  R[d->rd] = address; NEXT;
+op_addu:  R[d->rd] = R[d->rs] + R[d->rt]; NEXT;
+op_sub:
+  if(__builtin_sub_overflow((int)R[d->rs], (int)R[d->rt], (int *)&address))
+    goto overflow;
+  R[d->rd] = address; NEXT;
+op_subu:  R[d->rd] = R[d->rs] - R[d->rt]; NEXT;
+op_and:   R[d->rd] = R[d->rs] & R[d->rt]; NEXT;
+op_or:    R[d->rd] = R[d->rs] | R[d->rt]; NEXT;
+op_xor:   R[d->rd] = R[d->rs] ^ R[d->rt]; NEXT;
+op_nor:   R[d->rd] = ~(R[d->rs] | R[d->rt]); NEXT;
+op_slt:   R[d->rd] = (int)R[d->rs] < (int)R[d->rt]; NEXT;
+op_sltu:  R[d->rd] = R[d->rs] < R[d->rt]; NEXT;
+op_tge:   if((int)R[d->rs] >= (int)R[d->rt]) goto trap; NEXT;
+op_tgeu:  if(R[d->rs] >= R[d->rt]) goto trap; NEXT;
+op_tlt:   if((int)R[d->rs] < (int)R[d->rt]) goto trap; NEXT;
+op_tltu:  if(R[d->rs] < R[d->rt]) goto trap; NEXT;
+op_teq:   if(R[d->rs] == R[d->rt]) goto trap; NEXT;
+op_tne:   if(R[d->rs] != R[d->rt]) goto trap; NEXT;
+op_bltz:  TAKEN((int)R[d->rs] < 0); NEXT;
+op_bgez:  TAKEN((int)R[d->rs] >= 0); NEXT;
+op_tgei:  if((int)R[d->rs] >= d->imm) goto trap; NEXT;
+op_tgeiu: if(R[d->rs] >= (unsigned int)d->imm) goto trap; NEXT;
+op_tlti:  if((int)R[d->rs] < d->imm) goto trap; NEXT;
+op_tltiu: if(R[d->rs] < (unsigned int)d->imm) goto trap; NEXT;
+op_teqi:  if((int)R[d->rs] == d->imm) goto trap; NEXT;
+op_tnei:  if((int)R[d->rs] != d->imm) goto trap; NEXT;
+op_bltzal:
+  address = R[d->rs];
+  R[REG_RA] = (AT(d) + 1) * 4;
+  TAKEN((int)address < 0);
+  NEXT;
+op_bgezal:
+  address = R[d->rs];
+  R[REG_RA] = (AT(d) + 1) * 4;
+  TAKEN((int)address >= 0);
+  NEXT;
+op_j:     BRANCH(d);
+op_jal:   R[REG_RA] = (AT(d) + 1) * 4; BRANCH(d);
+op_beq:   TAKEN(R[d->rs] == R[d->rt]); NEXT;
+op_bne:   TAKEN(R[d->rs] != R[d->rt]); NEXT;
+op_blez:  TAKEN((int)R[d->rs] <= 0); NEXT;
+op_bgtz:  TAKEN((int)R[d->rs] > 0); NEXT;
+op_addi:
+  if(__builtin_add_overflow((int)R[d->rs], d->imm, (int *)&address))
+    goto overflow;
+  R[d->rd] = address; NEXT;
+op_addiu: R[d->rd] = R[d->rs] + d->imm; NEXT;
+op_slti:  R[d->rd] = (int)R[d->rs] < d->imm; NEXT;
+op_sltiu: R[d->rd] = R[d->rs] < (unsigned int)d->imm; NEXT;
+op_andi:  R[d->rd] = R[d->rs] & d->imm; NEXT;
+op_ori:   R[d->rd] = R[d->rs] | d->imm; NEXT;
+op_xori:  R[d->rd] = R[d->rs] ^ d->imm; NEXT;
+op_lui:   R[d->rd] = d->imm; NEXT;
+op_madd:
+  wide = ((unsigned long long)_hi << 32 | _lo)
+    + (long long)(int)R[d->rs] * (int)R[d->rt];
+  _lo = wide; _hi = wide >> 32; NEXT;
+op_maddu:
+  wide = ((unsigned long long)_hi << 32 | _lo)
+    + (unsigned long long)R[d->rs] * R[d->rt];
+  _lo = wide; _hi = wide >> 32; NEXT;
+op_mul:   R[d->rd] = (int)R[d->rs] * (long long)(int)R[d->rt]; NEXT;
+op_msub:
+  wide = ((unsigned long long)_hi << 32 | _lo)
+    - (long long)(int)R[d->rs] * (int)R[d->rt];
+  _lo = wide; _hi = wide >> 32; NEXT;
+op_msubu:
+  wide = ((unsigned long long)_hi << 32 | _lo)
+    - (unsigned long long)R[d->rs] * R[d->rt];
+  _lo = wide; _hi = wide >> 32; NEXT;
+op_clz:   R[d->rd] = R[d->rs] ? __builtin_clz(R[d->rs]) : 32; NEXT;
+op_clo:   R[d->rd] = ~R[d->rs] ? __builtin_clz(~R[d->rs]) : 32; NEXT;
+op_lb:    ADDRESS(1); R[d->rd] = (signed char)*LOADED; NEXT;
+op_lbu:   ADDRESS(1); R[d->rd] = *LOADED; NEXT;
+op_lh:
+  ADDRESS(2);
+  { short h; memcpy(&h, LOADED, 2); R[d->rd] = h; }
+  NEXT;
+op_lhu:
+  ADDRESS(2);
+  { unsigned short h; memcpy(&h, LOADED, 2); R[d->rd] = h; }
+  NEXT;
+op_lw:    ADDRESS(4); memcpy(&R[d->rd], LOADED, 4); NEXT;
+op_sb:    STORE_ADDRESS(1); *STORING = R[d->rt]; STORED; NEXT;
+op_sh:
+  STORE_ADDRESS(2);
+  { unsigned short h = R[d->rt]; memcpy(STORING, &h, 2); }
+  STORED;
+  NEXT;
+op_sw:
+  STORE_ADDRESS(4);
+  memcpy(STORING, &R[d->rt], 4);
+  STORED;
+  NEXT;
+op_sc:
+  STORE_ADDRESS(4);
+  memcpy(STORING, &R[d->rt], 4);
+  R[d->rd] = 1;
+  STORED;
+  NEXT;
+
+touch_page:
+  _memory.Touch(address);
+  goto *ops[d->op];
+text_written:
+  // a store into the text, its word is decoded again. Blocks are
+  // all dropped, so the rest of this one is counted back out and
+  // running goes on in a new block
+  if(!BLOCKS)
+  {
+    // the text may have been copied to be changed
+    TextWritten(address);
+    d = _text + (d - base);
+    base = _text;
+    NEXT;
+  }
+  {
+    int next = AT(d) + 1;
+    count = count - block->imm + (next - _guest[block - base]);
+    TextWritten(address);
+    block = NULL;
+    JUMP(next);
+  }
+#undef NEXT
+#undef JUMP
+#undef BRANCH
+#undef ADDRESS
+#undef STORE_ADDRESS
+#undef LOADED
+#undef STORING
+#undef STORED
+#undef FETCH
+#undef TAKEN
+
+limit_reached:
+  stop = STOP_LIMIT;
+  goto done;
+end:
+  stop = STOP_END;
+  goto done;
+bad_target:
+  // the sentinel past the end, so no word to name
+  _fault = "branch or jump outside the text";
+  stop = STOP_FAULT;
+  goto done;
+bad_jump:
+  stop = Fail("jump to", AT(d), address);
+  goto done;
+bad_address:
+  stop = Fail("bad address", AT(d), address);
+  goto done;
+overflow:
+  stop = Fail("overflow", AT(d));
+  goto done;
+trap:
+  stop = Fail("trap", AT(d));
+  goto done;
+invalid:
+  memcpy(&address, _memory.Read(AT(d) * 4), 4);
+  stop = Fail("not an instruction", AT(d), address);
+  goto done;
+unsupported:
+  stop = Fail("unsupported instruction", AT(d));
+  _fault += std::string(" (") + INSTRUCTIONS[d->op].name + ")";
+  goto done;
+
+done:
+  // a block counted all its instructions on entry, those after
+  // where it stopped are taken back
+  if(BLOCKS && block && stop != STOP_LIMIT)
+    count = count - block->imm + (AT(d) - _guest[block - base])
+      + (stop == STOP_EXIT);
+  _pc = AT(d);
+  _executed = count;
+  _chained += chained;
+  if(TRACE)
+    FlushRefs();
+  if(BRANCHES)
+    FlushOutcomes();
+  return stop;
+#undef AT
+}
+
+// reads a program to run: a source file ending in .s is assembled,
+// an object file must be linked and is mapped, not copied, and the
+// hex words of a .obj are text up to textWords, all text if it is
+// negative. Returns false after reporting why if it cannot be loaded
+inline bool LoadProgram(const std::string &name, Program &program,
+                        int textWords = -1)
+{
+  std::ifstream in(name.c_str());
+  if(!in)
+  {
+    std::cerr << "error: cannot read '" << name << "'" << std::endl;
+    return false;
+  }
+
+  if(name.size() > 2 && name.compare(name.size() - 2, 2, ".s") == 0)
+  {
+    OnePass assembler;
+    std::string lineIn;
+    do
+    {
+      std::ws(in);
+      std::getline(in, lineIn);
+      if(!in) break;
+      if(!CleanLine(lineIn)) continue;
+      assembler.Line(lineIn);
+    }while(in.eof() == 0);
+    if(assembler.Finish())
+      return false;
+    const SymbolTable &table = assembler.Symbols();
+    program.code = assembler.Code();
+    program.dataStart = table.DataStart();
+    program.zeroWords = assembler.ZeroWords();
+    program.labels.clear();
+    for(int i = 0; i < table.Size(); ++i)
+    {
+      if(table[i].defined && !table[i].inData)
+      {
+        TextLabel label = {table[i].address, table.Name(i)};
+        program.labels.push_back(label);
+      }
+    }
+    std::sort(program.labels.begin(), program.labels.end());
+    return true;
+  }
+
+  if(program.mapped.Map(name))
+  {
+    const ObjectHeader &h = program.mapped.Header();
+    if(h.relocations)
+    {
+      program.mapped.Unmap();
+      std::cerr << "error: '" << name << "' is not linked" << std::endl;
+      return false;
+    }
+    program.dataStart = h.textWords;
+    program.zeroWords = h.zeroWords;
+
+    // the symbols follow the words, their names are at the end
+    const char *p = program.mapped.Words() + 4 * (h.textWords + h.dataWords);
+    const char *strings = program.mapped.File() + program.mapped.Size()
+      - h.stringBytes;
+    program.labels.clear();
+    for(size_t i = 0; i < h.symbols; ++i, p += 16)
+    {
+      size_t offset = GetWord(p);
+      if(GetWord(p + 4) == SECTION_TEXT && offset < h.stringBytes
+         && memchr(strings + offset, 0, h.stringBytes - offset))
+      {
+        TextLabel label = {(int)GetWord(p + 8), strings + offset};
+        program.labels.push_back(label);
+      }
+    }
+    std::sort(program.labels.begin(), program.labels.end());
+    return true;
+  }
+
+  unsigned int word;
+  program.code.clear();
+  while(in >> std::hex >> word)
+    program.code.push_back(word);
+  program.dataStart = textWords >= 0 && textWords < (int)program.code.size()
+    ? textWords : program.code.size();
+  program.zeroWords = 0;
+  program.labels.clear();
+  return true;
+}
+
+#endif
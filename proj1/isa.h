@@ -0,0 +1,372 @@
+/**
+ *	@file 		isa.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Instruction and register tables.
+ *
+ *	@section 	DESCRIPTION
+ * 	Every instruction of the MIPS32 integer ISA is one row
+ *      of INSTRUCTIONS giving its format, op code, funct code
+ *      and operand layout, and every register name is one
+ *      row of REGISTERS. Both are looked up through perfect
+ *      hashes whose seeds and slot tables are worked out by
+ *      the compiler, so a lookup is one hash and one string
+ *      compare. Adding an instruction is adding a row.
+ **********************************************************/
+
+#ifndef ISA_H
+#define ISA_H
+
+#include <cstring>
+#include <string>
+
+// instruction formats
+enum Format
+{
+  R_TYPE,
+  I_TYPE,
+  J_TYPE
+};
+
+// the kinds of operand an instruction can take, in the order
+// they are written
+enum Operand
+{
+  NONE,       // no more operands
+  RD,         // register placed in the rd field
+  RS,         // register placed in the rs field
+  RT,         // register placed in the rt field
+  RDT,        // register placed in both the rd and rt fields
+  SA,         // 5 bit shift amount
+  HINT,       // 5 bit number placed in the rt field
+  IMM,        // 16 bit immediate
+  BRANCH,     // label turned into a word offset from pc + 1
+  MEM,        // offset(base), base placed in the rs field. A
+              // label offset is its byte offset from the start
+              // of the data section when the base is $gp and
+              // its byte address otherwise
+  TARGET      // label turned into a word address
+};
+
+// one row of the instruction table
+struct InstrDesc
+{
+  const char *name;
+  Format format;
+  int opcode;
+  int funct;
+  int rt;                   // fixed rt field, REGIMM uses it
+  Operand operands[3];
+};
+
+// one row of the register table
+struct RegDesc
+{
+  const char *name;
+  int number;
+};
+
+constexpr InstrDesc INSTRUCTIONS[] =
+{
+  // SPECIAL, op code 0, picked by funct
+  {"sll",     R_TYPE,  0,  0, 0, {RD, RT, SA}},
+  {"srl",     R_TYPE,  0,  2, 0, {RD, RT, SA}},
+  {"sra",     R_TYPE,  0,  3, 0, {RD, RT, SA}},
+  {"sllv",    R_TYPE,  0,  4, 0, {RD, RT, RS}},
+  {"srlv",    R_TYPE,  0,  6, 0, {RD, RT, RS}},
+  {"srav",    R_TYPE,  0,  7, 0, {RD, RT, RS}},
+  {"jr",      R_TYPE,  0,  8, 0, {RS, NONE, NONE}},
+  {"jalr",    R_TYPE,  0,  9, 0, {RD, RS, NONE}},
+  {"movz",    R_TYPE,  0, 10, 0, {RD, RS, RT}},
+  {"movn",    R_TYPE,  0, 11, 0, {RD, RS, RT}},
+  {"syscall", R_TYPE,  0, 12, 0, {NONE, NONE, NONE}},
+  {"break",   R_TYPE,  0, 13, 0, {NONE, NONE, NONE}},
+  {"sync",    R_TYPE,  0, 15, 0, {NONE, NONE, NONE}},
+  {"mfhi",    R_TYPE,  0, 16, 0, {RD, NONE, NONE}},
+  {"mthi",    R_TYPE,  0, 17, 0, {RS, NONE, NONE}},
+  {"mflo",    R_TYPE,  0, 18, 0, {RD, NONE, NONE}},
+  {"mtlo",    R_TYPE,  0, 19, 0, {RS, NONE, NONE}},
+  {"mult",    R_TYPE,  0, 24, 0, {RS, RT, NONE}},
+  {"multu",   R_TYPE,  0, 25, 0, {RS, RT, NONE}},
+  {"div",     R_TYPE,  0, 26, 0, {RS, RT, NONE}},
+  {"divu",    R_TYPE,  0, 27, 0, {RS, RT, NONE}},
+  {"add",     R_TYPE,  0, 32, 0, {RD, RS, RT}},
+  {"addu",    R_TYPE,  0, 33, 0, {RD, RS, RT}},
+  {"sub",     R_TYPE,  0, 34, 0, {RD, RS, RT}},
+  {"subu",    R_TYPE,  0, 35, 0, {RD, RS, RT}},
+  {"and",     R_TYPE,  0, 36, 0, {RD, RS, RT}},
+  {"or",      R_TYPE,  0, 37, 0, {RD, RS, RT}},
+  {"xor",     R_TYPE,  0, 38, 0, {RD, RS, RT}},
+  {"nor",     R_TYPE,  0, 39, 0, {RD, RS, RT}},
+  {"slt",     R_TYPE,  0, 42, 0, {RD, RS, RT}},
+  {"sltu",    R_TYPE,  0, 43, 0, {RD, RS, RT}},
+  {"tge",     R_TYPE,  0, 48, 0, {RS, RT, NONE}},
+  {"tgeu",    R_TYPE,  0, 49, 0, {RS, RT, NONE}},
+  {"tlt",     R_TYPE,  0, 50, 0, {RS, RT, NONE}},
+  {"tltu",    R_TYPE,  0, 51, 0, {RS, RT, NONE}},
+  {"teq",     R_TYPE,  0, 52, 0, {RS, RT, NONE}},
+  {"tne",     R_TYPE,  0, 54, 0, {RS, RT, NONE}},
+
+  // REGIMM, op code 1, picked by the rt field
+  {"bltz",    I_TYPE,  1,  0,  0, {RS, BRANCH, NONE}},
+  {"bgez",    I_TYPE,  1,  0,  1, {RS, BRANCH, NONE}},
+  {"bltzl",   I_TYPE,  1,  0,  2, {RS, BRANCH, NONE}},
+  {"bgezl",   I_TYPE,  1,  0,  3, {RS, BRANCH, NONE}},
+  {"tgei",    I_TYPE,  1,  0,  8, {RS, IMM, NONE}},
+  {"tgeiu",   I_TYPE,  1,  0,  9, {RS, IMM, NONE}},
+  {"tlti",    I_TYPE,  1,  0, 10, {RS, IMM, NONE}},
+  {"tltiu",   I_TYPE,  1,  0, 11, {RS, IMM, NONE}},
+  {"teqi",    I_TYPE,  1,  0, 12, {RS, IMM, NONE}},
+  {"tnei",    I_TYPE,  1,  0, 14, {RS, IMM, NONE}},
+  {"bltzal",  I_TYPE,  1,  0, 16, {RS, BRANCH, NONE}},
+  {"bgezal",  I_TYPE,  1,  0, 17, {RS, BRANCH, NONE}},
+  {"bltzall", I_TYPE,  1,  0, 18, {RS, BRANCH, NONE}},
+  {"bgezall", I_TYPE,  1,  0, 19, {RS, BRANCH, NONE}},
+
+  // jumps
+  {"j",       J_TYPE,  2,  0, 0, {TARGET, NONE, NONE}},
+  {"jal",     J_TYPE,  3,  0, 0, {TARGET, NONE, NONE}},
+
+  // branches and immediates
+  {"beq",     I_TYPE,  4,  0, 0, {RS, RT, BRANCH}},
+  {"bne",     I_TYPE,  5,  0, 0, {RS, RT, BRANCH}},
+  {"blez",    I_TYPE,  6,  0, 0, {RS, BRANCH, NONE}},
+  {"bgtz",    I_TYPE,  7,  0, 0, {RS, BRANCH, NONE}},
+  {"addi",    I_TYPE,  8,  0, 0, {RT, RS, IMM}},
+  {"addiu",   I_TYPE,  9,  0, 0, {RT, RS, IMM}},
+  {"slti",    I_TYPE, 10,  0, 0, {RT, RS, IMM}},
+  {"sltiu",   I_TYPE, 11,  0, 0, {RT, RS, IMM}},
+  {"andi",    I_TYPE, 12,  0, 0, {RT, RS, IMM}},
+  {"ori",     I_TYPE, 13,  0, 0, {RT, RS, IMM}},
+  {"xori",    I_TYPE, 14,  0, 0, {RT, RS, IMM}},
+  {"lui",     I_TYPE, 15,  0, 0, {RT, IMM, NONE}},
+  {"beql",    I_TYPE, 20,  0, 0, {RS, RT, BRANCH}},
+  {"bnel",    I_TYPE, 21,  0, 0, {RS, RT, BRANCH}},
+  {"blezl",   I_TYPE, 22,  0, 0, {RS, BRANCH, NONE}},
+  {"bgtzl",   I_TYPE, 23,  0, 0, {RS, BRANCH, NONE}},
+
+  // SPECIAL2, op code 28, picked by funct
+  {"madd",    R_TYPE, 28,  0, 0, {RS, RT, NONE}},
+  {"maddu",   R_TYPE, 28,  1, 0, {RS, RT, NONE}},
+  {"mul",     R_TYPE, 28,  2, 0, {RD, RS, RT}},
+  {"msub",    R_TYPE, 28,  4, 0, {RS, RT, NONE}},
+  {"msubu",   R_TYPE, 28,  5, 0, {RS, RT, NONE}},
+  {"clz",     R_TYPE, 28, 32, 0, {RDT, RS, NONE}},
+  {"clo",     R_TYPE, 28, 33, 0, {RDT, RS, NONE}},
+
+  // loads and stores
+  {"lb",      I_TYPE, 32,  0, 0, {RT, MEM, NONE}},
+  {"lh",      I_TYPE, 33,  0, 0, {RT, MEM, NONE}},
+  {"lwl",     I_TYPE, 34,  0, 0, {RT, MEM, NONE}},
+  {"lw",      I_TYPE, 35,  0, 0, {RT, MEM, NONE}},
+  {"lbu",     I_TYPE, 36,  0, 0, {RT, MEM, NONE}},
+  {"lhu",     I_TYPE, 37,  0, 0, {RT, MEM, NONE}},
+  {"lwr",     I_TYPE, 38,  0, 0, {RT, MEM, NONE}},
+  {"sb",      I_TYPE, 40,  0, 0, {RT, MEM, NONE}},
+  {"sh",      I_TYPE, 41,  0, 0, {RT, MEM, NONE}},
+  {"swl",     I_TYPE, 42,  0, 0, {RT, MEM, NONE}},
+  {"sw",      I_TYPE, 43,  0, 0, {RT, MEM, NONE}},
+  {"swr",     I_TYPE, 46,  0, 0, {RT, MEM, NONE}},
+  {"ll",      I_TYPE, 48,  0, 0, {RT, MEM, NONE}},
+  {"pref",    I_TYPE, 51,  0, 0, {HINT, MEM, NONE}},
+  {"sc",      I_TYPE, 56,  0, 0, {RT, MEM, NONE}},
+};
+
+constexpr RegDesc REGISTERS[] =
+{
+  {"$zero", 0}, {"$at", 1}, {"$v0", 2}, {"$v1", 3},
+  {"$a0", 4},   {"$a1", 5}, {"$a2", 6}, {"$a3", 7},
+  {"$t0", 8},   {"$t1", 9}, {"$t2", 10}, {"$t3", 11},
+  {"$t4", 12},  {"$t5", 13}, {"$t6", 14}, {"$t7", 15},
+  {"$s0", 16},  {"$s1", 17}, {"$s2", 18}, {"$s3", 19},
+  {"$s4", 20},  {"$s5", 21}, {"$s6", 22}, {"$s7", 23},
+  {"$t8", 24},  {"$t9", 25}, {"$k0", 26}, {"$k1", 27},
+  {"$gp", 28},  {"$sp", 29}, {"$fp", 30}, {"$ra", 31},
+  {"$s8", 30},
+  {"$0", 0},   {"$1", 1},   {"$2", 2},   {"$3", 3},
+  {"$4", 4},   {"$5", 5},   {"$6", 6},   {"$7", 7},
+  {"$8", 8},   {"$9", 9},   {"$10", 10}, {"$11", 11},
+  {"$12", 12}, {"$13", 13}, {"$14", 14}, {"$15", 15},
+  {"$16", 16}, {"$17", 17}, {"$18", 18}, {"$19", 19},
+  {"$20", 20}, {"$21", 21}, {"$22", 22}, {"$23", 23},
+  {"$24", 24}, {"$25", 25}, {"$26", 26}, {"$27", 27},
+  {"$28", 28}, {"$29", 29}, {"$30", 30}, {"$31", 31},
+};
+
+
+// FNV-1a over a null terminated string
+constexpr unsigned int HashName(const char *s, unsigned int h)
+{
+  return *s ? HashName(s + 1, (h ^ (unsigned char)*s) * 16777619u) : h;
+}
+
+// the slot of a name in a table of 2^bits slots for a seed
+constexpr unsigned int HashSlot(const char *s, unsigned int seed,
+                                unsigned int bits)
+{
+  return (HashName(s, 2166136261u ^ (seed * 0x9E3779B9u)) * 2654435769u)
+    >> (32 - bits);
+}
+
+// HashSlot over the first length characters of s, for names that
+// are not null terminated
+inline unsigned int HashSlot(const char *s, size_t length, unsigned int seed,
+                             unsigned int bits)
+{
+  unsigned int h = 2166136261u ^ (seed * 0x9E3779B9u);
+  for(size_t i = 0; i < length; ++i)
+    h = (h ^ (unsigned char)s[i]) * 16777619u;
+  return (h * 2654435769u) >> (32 - bits);
+}
+
+// keys of the two tables, a table is sized at about eight slots
+// per name so a seed with no collisions turns up quickly
+struct InstrKeys
+{
+  static constexpr int COUNT = sizeof(INSTRUCTIONS) / sizeof(INSTRUCTIONS[0]);
+  static constexpr unsigned int BITS = 10;
+  static constexpr const char *Key(int i){return INSTRUCTIONS[i].name;}
+};
+
+struct RegKeys
+{
+  static constexpr int COUNT = sizeof(REGISTERS) / sizeof(REGISTERS[0]);
+  static constexpr unsigned int BITS = 9;
+  static constexpr const char *Key(int i){return REGISTERS[i].name;}
+};
+
+// true if key i shares a slot with any key from j on
+template<class K>
+constexpr bool Collides(int i, int j, unsigned int seed)
+{
+  return j < K::COUNT
+    && (HashSlot(K::Key(i), seed, K::BITS)
+        == HashSlot(K::Key(j), seed, K::BITS)
+        || Collides<K>(i, j + 1, seed));
+}
+
+// true if no two keys from i on share a slot
+template<class K>
+constexpr bool Perfect(int i, unsigned int seed)
+{
+  return i >= K::COUNT
+    || (!Collides<K>(i, i + 1, seed) && Perfect<K>(i + 1, seed));
+}
+
+template<class K>
+constexpr int FindSeed(unsigned int lo, unsigned int hi);
+
+template<class K>
+constexpr int FirstSeed(int found, unsigned int mid, unsigned int hi)
+{
+  return found >= 0 ? found : FindSeed<K>(mid, hi);
+}
+
+// the first perfect seed in [lo, hi) or -1, split in halves so
+// the recursion stays shallow however many seeds are tried
+template<class K>
+constexpr int FindSeed(unsigned int lo, unsigned int hi)
+{
+  return hi - lo == 1 ? (Perfect<K>(0, lo) ? (int)lo : -1)
+    : FirstSeed<K>(FindSeed<K>(lo, lo + (hi - lo) / 2),
+                   lo + (hi - lo) / 2, hi);
+}
+
+// the key that hashes to slot, or -1
+template<class K>
+constexpr int KeyInSlot(unsigned int slot, unsigned int seed, int i)
+{
+  return i >= K::COUNT ? -1
+    : HashSlot(K::Key(i), seed, K::BITS) == slot ? i
+    : KeyInSlot<K>(slot, seed, i + 1);
+}
+
+// compile time index lists, built by halves to keep the template
+// recursion shallow
+template<unsigned int... I> struct Indices {};
+
+template<class A, class B> struct JoinIndices;
+template<unsigned int... A, unsigned int... B>
+struct JoinIndices<Indices<A...>, Indices<B...> >
+{
+  typedef Indices<A..., (sizeof...(A) + B)...> type;
+};
+
+template<unsigned int N> struct MakeIndices
+{
+  typedef typename JoinIndices<typename MakeIndices<N / 2>::type,
+                               typename MakeIndices<N - N / 2>::type>::type
+    type;
+};
+template<> struct MakeIndices<0> {typedef Indices<> type;};
+template<> struct MakeIndices<1> {typedef Indices<0> type;};
+
+template<unsigned int N>
+struct SlotTable
+{
+  short key[N];
+};
+
+template<class K, unsigned int... I>
+constexpr SlotTable<sizeof...(I)> BuildSlots(unsigned int seed,
+                                             Indices<I...>)
+{
+  return SlotTable<sizeof...(I)>{{(short)KeyInSlot<K>(I, seed, 0)...}};
+}
+
+// a perfect hash over the keys of K
+template<class K>
+struct PerfectHash
+{
+  static constexpr unsigned int SIZE = 1u << K::BITS;
+  static constexpr int SEED = FindSeed<K>(0, 1u << 16);
+  static_assert(SEED >= 0, "no perfect hash seed, raise BITS");
+  static constexpr SlotTable<SIZE> SLOTS
+    = BuildSlots<K>(SEED, typename MakeIndices<SIZE>::type());
+
+  // returns the row of the name or -1
+  static int Find(const char *s)
+  {
+    int i = SLOTS.key[HashSlot(s, SEED, K::BITS)];
+    return i >= 0 && strcmp(K::Key(i), s) == 0 ? i : -1;
+  }
+
+  // the same for the first length characters of s
+  static int Find(const char *s, size_t length)
+  {
+    int i = SLOTS.key[HashSlot(s, length, SEED, K::BITS)];
+    return i >= 0 && strncmp(K::Key(i), s, length) == 0
+      && K::Key(i)[length] == 0 ? i : -1;
+  }
+};
+
+template<class K>
+constexpr SlotTable<PerfectHash<K>::SIZE> PerfectHash<K>::SLOTS;
+
+// returns the table row for a mnemonic or NULL
+inline const InstrDesc *FindInstruction(const std::string &s)
+{
+  int i = PerfectHash<InstrKeys>::Find(s.c_str());
+  return i >= 0 ? &INSTRUCTIONS[i] : NULL;
+}
+
+inline const InstrDesc *FindInstruction(const char *s, size_t length)
+{
+  int i = PerfectHash<InstrKeys>::Find(s, length);
+  return i >= 0 ? &INSTRUCTIONS[i] : NULL;
+}
+
+// returns the number of a register name or -1
+inline int FindRegister(const std::string &s)
+{
+  int i = PerfectHash<RegKeys>::Find(s.c_str());
+  return i >= 0 ? REGISTERS[i].number : -1;
+}
+
+inline int FindRegister(const char *s, size_t length)
+{
+  int i = PerfectHash<RegKeys>::Find(s, length);
+  return i >= 0 ? REGISTERS[i].number : -1;
+}
+
+#endif
@@ -0,0 +1,321 @@
+/**
+ *	@file 		lexer.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Lexer for the assembler front end.
+ *
+ *	@section 	DESCRIPTION
+ * 	Source reads a whole file into one block of an Arena and
+ *      lexes it once. Each line is cleaned the way CleanLine
+ *      does and cut into Tokens, a pointer and length into the
+ *      block with a kind and a line number, so a token is never
+ *      copied into a string of its own. The tokens of all lines
+ *      sit in one array and each SourceLine names its run of
+ *      them, so both passes walk the same array and lexing a
+ *      line allocates nothing once the arrays have grown.
+ *
+ *      A line is a directive if it starts with '.', a label if
+ *      its first token ends in ':' and a statement otherwise.
+ *      Tokens are split at blanks, commas and parentheses as
+ *      SplitStatement splits them, so hi:label stays whole.
+ **********************************************************/
+
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+
+// bytes an arena takes from the host at once
+const size_t ARENA_CHUNK = 1 << 16;
+
+enum TokenKind
+{
+  TOKEN_NAME,       // mnemonic or label operand
+  TOKEN_NUMBER,     // starts with a digit or a sign
+  TOKEN_REGISTER,   // starts with $
+  TOKEN_DIRECTIVE,  // starts with .
+  TOKEN_LABEL       // a line's first token, ended by ':'
+};
+
+enum LineKind
+{
+  LINE_STATEMENT,
+  LINE_LABEL,
+  LINE_DIRECTIVE
+};
+
+// a piece of source text in a buffer it does not own
+struct Token
+{
+  const char *text;
+  int length;
+  int line;                 // source line, from 1, 0 if none
+  unsigned char kind;       // TokenKind
+};
+
+// one cleaned line of source and its tokens
+struct SourceLine
+{
+  Token text;               // the whole line
+  int first;                // index of its first token
+  int count;                // number of tokens
+  LineKind kind;
+};
+
+// true for the characters that separate the tokens of a statement
+inline bool IsSeparator(char c)
+{
+  return c == ' ' || c == '\t' || c == ',' || c == '(' || c == ')';
+}
+
+inline TokenKind KindOf(const char *s, size_t length)
+{
+  if(!length)
+    return TOKEN_NAME;
+  if(isdigit((unsigned char)s[0]) || s[0] == '-' || s[0] == '+')
+    return TOKEN_NUMBER;
+  if(s[0] == '$')
+    return TOKEN_REGISTER;
+  return s[0] == '.' ? TOKEN_DIRECTIVE : TOKEN_NAME;
+}
+
+inline Token MakeToken(const char *text, size_t length, int line = 0)
+{
+  Token t = {text, (int)length, line, (unsigned char)KindOf(text, length)};
+  return t;
+}
+
+inline Token MakeToken(const std::string &s)
+{
+  return MakeToken(s.data(), s.size());
+}
+
+// true if the token is the null terminated s
+inline bool TokenIs(const Token &t, const char *s)
+{
+  return strncmp(t.text, s, t.length) == 0 && s[t.length] == 0;
+}
+
+inline std::string TokenString(const Token &t)
+{
+  return std::string(t.text, t.length);
+}
+
+inline std::ostream &operator<<(std::ostream &out, const Token &t)
+{
+  return out.write(t.text, t.length);
+}
+
+// appends the tokens of a statement to tok
+inline void LexStatement(const char *s, size_t length, int line,
+                         std::vector<Token> &tok)
+{
+  const char *end = s + length;
+  while(s < end)
+  {
+    while(s < end && IsSeparator(*s))
+      ++s;
+    const char *start = s;
+    while(s < end && !IsSeparator(*s))
+      ++s;
+    if(s > start)
+      tok.push_back(MakeToken(start, s - start, line));
+  }
+}
+
+// length of a line's first token, which ends at a separator or a
+// ':'. The line is a label if a ':' ends it, so hi:label operands
+// further on never make one
+inline size_t FirstTokenLength(const char *s, size_t length)
+{
+  size_t n = 0;
+  while(n < length && !IsSeparator(s[n]) && s[n] != ':')
+    ++n;
+  return n;
+}
+
+// position of the ':' ending the label a cleaned line starts with,
+// or npos if the line does not start with a label
+inline size_t LabelColon(const std::string &line)
+{
+  size_t n = FirstTokenLength(line.data(), line.size());
+  return n < line.size() && line[n] == ':' ? n : std::string::npos;
+}
+
+// character storage handed out from large chunks that never move,
+// so tokens may point into it for as long as the arena lives
+class Arena
+{
+public:
+
+  Arena(): _next(NULL), _free(0), _bytes(0) {}
+
+  ~Arena()
+  {
+    for(size_t i = 0; i < _chunks.size(); ++i)
+      free(_chunks[i]);
+  }
+
+  // bytes of storage, in a chunk of their own if they are more
+  // than a chunk
+  char *Allocate(size_t bytes)
+  {
+    if(bytes > _free)
+    {
+      size_t size = bytes > ARENA_CHUNK ? bytes : ARENA_CHUNK;
+      char *chunk = (char *)malloc(size ? size : 1);
+      if(!chunk)
+        throw std::bad_alloc();
+      _chunks.push_back(chunk);
+      _next = chunk;
+      _free = size;
+    }
+    char *p = _next;
+    _next += bytes;
+    _free -= bytes;
+    _bytes += bytes;
+    return p;
+  }
+
+  char *Copy(const char *s, size_t bytes)
+  {
+    return (char *)memcpy(Allocate(bytes), s, bytes);
+  }
+
+  // bytes handed out so far
+  size_t Bytes() const {return _bytes;}
+
+private:
+  Arena(const Arena &);
+  Arena &operator=(const Arena &);
+
+  std::vector<char *> _chunks;
+  char *_next;
+  size_t _free;             // bytes left in the last chunk
+  size_t _bytes;
+};
+
+class Source
+{
+public:
+
+  Source(): _number(0) {}
+
+  // reads and lexes the rest of a stream, returns false if it
+  // could not be read
+  bool Read(std::istream &in)
+  {
+    std::streampos start = in.tellg();
+    in.seekg(0, std::ios::end);
+    std::streampos end = in.tellg();
+    if(start == std::streampos(-1) || end == std::streampos(-1))
+    {
+      // not seekable, so gather it first
+      in.clear();
+      std::ostringstream gathered;
+      gathered << in.rdbuf();
+      std::string text = gathered.str();
+      Lex(text.data(), text.size());
+      return !in.bad();
+    }
+
+    in.seekg(start);
+    size_t bytes = end - start;
+    char *text = _arena.Allocate(bytes);
+    in.read(text, bytes);
+    LexText(text, in.gcount());
+    return !in.bad();
+  }
+
+  // lexes a copy of the lines of text
+  void Lex(const char *text, size_t bytes)
+  {
+    LexText(_arena.Copy(text, bytes), bytes);
+  }
+
+  // lexes a copy of one line
+  void Add(const std::string &line)
+  {
+    LexText(_arena.Copy(line.data(), line.size()), line.size());
+  }
+
+  size_t Lines() const {return _lines.size();}
+  const SourceLine &Line(size_t i) const {return _lines[i];}
+  const Token *Tokens(const SourceLine &line) const
+  {
+    return _tokens.data() + line.first;
+  }
+  size_t TokenCount() const {return _tokens.size();}
+  // bytes of source held
+  size_t Bytes() const {return _arena.Bytes();}
+
+private:
+  Source(const Source &);
+  Source &operator=(const Source &);
+
+  // lexes text held by the arena line by line
+  void LexText(const char *text, size_t bytes)
+  {
+    const char *end = text + bytes;
+    while(text < end)
+    {
+      const char *newline = (const char *)memchr(text, '\n', end - text);
+      if(!newline)
+        newline = end;
+      LexLine(text, newline);
+      text = newline + 1;
+    }
+  }
+
+  // drops leading blanks, a comment and trailing blanks as
+  // CleanLine does and lexes what is left, if anything
+  void LexLine(const char *s, const char *end)
+  {
+    ++_number;
+    while(s < end && isspace((unsigned char)*s))
+      ++s;
+    const char *hash = s;
+    while(hash < end && *hash != '#')
+      ++hash;
+    end = hash;
+    while(end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+      --end;
+    if(s == end)
+      return;
+
+    SourceLine line;
+    line.text = MakeToken(s, end - s, _number);
+    line.first = _tokens.size();
+    line.kind = *s == '.' ? LINE_DIRECTIVE : LINE_STATEMENT;
+
+    // the first token ends at a ':' too, making it a label
+    const char *p = s + FirstTokenLength(s, end - s);
+    bool label = p < end && *p == ':';
+    if(p > s || label)
+      _tokens.push_back(MakeToken(s, p - s, _number));
+    if(label)
+    {
+      _tokens.back().kind = TOKEN_LABEL;
+      if(line.kind != LINE_DIRECTIVE)
+        line.kind = LINE_LABEL;
+      ++p;
+    }
+    LexStatement(p, end - p, _number, _tokens);
+    line.count = _tokens.size() - line.first;
+    _lines.push_back(line);
+  }
+
+  Arena _arena;
+  std::vector<Token> _tokens;
+  std::vector<SourceLine> _lines;
+  int _number;              // lines read so far
+};
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ *	@file 		linker.cpp
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Object file linker.
+ *
+ *	@section 	DESCRIPTION
+ * 	This program links object files written by proj1 -c
+ *      into one program, written as an object with no
+ *      relocations and optionally as the hex words of a .obj.
+ *
+ *        linker [-o out] [--hex file.obj] file.o ...
+ **********************************************************/
+
+#ifndef LINKER_CPP
+#define LINKER_CPP
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstring>
+#include "object.h"
+
+int main(int argc, char *argv[])
+{
+  std::string outName = "a.out";
+  std::string hexName;
+  std::vector<std::string> names;
+
+  for(int i = 1; i < argc; ++i)
+  {
+    if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+      outName = argv[++i];
+    else if(strcmp(argv[i], "--hex") == 0 && i + 1 < argc)
+      hexName = argv[++i];
+    else
+      names.push_back(argv[i]);
+  }
+  if(names.empty())
+  {
+    std::cerr << "usage: linker [-o out] [--hex file.obj] file.o ..."
+              << std::endl;
+    return 1;
+  }
+
+  std::vector<Object> objs(names.size());
+  for(size_t i = 0; i < names.size(); ++i)
+  {
+    if(!ReadObject(names[i], objs[i]))
+    {
+      std::cerr << "error: '" << names[i] << "' is not an object file"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  Object program;
+  int errors = Link(objs, names, program);
+  if(errors)
+  {
+    std::cerr << errors << " error(s), nothing written" << std::endl;
+    return 1;
+  }
+
+  if(!WriteObject(outName, program))
+  {
+    std::cerr << "error: cannot write '" << outName << "'" << std::endl;
+    return 1;
+  }
+  if(!hexName.empty())
+  {
+    std::ofstream hex(hexName.c_str());
+    for(size_t i = 0; i < program.text.size(); ++i)
+      hex << std::hex << std::setw(8) << std::setfill('0')
+          << program.text[i] << std::endl;
+    for(size_t i = 0; i < program.data.size(); ++i)
+      hex << std::hex << std::setw(8) << std::setfill('0')
+          << program.data[i] << std::endl;
+    for(size_t i = 0; i < program.zeroWords; ++i)
+      hex << "00000000" << std::endl;
+  }
+  return 0;
+}
+
+#endif
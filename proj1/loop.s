@@ -0,0 +1,31 @@
+   .text
+# sums the words of an array over and over, a long running
+# kernel for timing the interpreter
+   lw $s1,rounds($gp)
+   addu $s0,$zero,$zero
+outer:
+   la $t0,array
+   addiu $t1,$zero,64
+inner:
+   lw $t2,0($t0)
+   addu $s0,$s0,$t2
+   slt $t3,$s0,$zero
+   beq $t3,$zero,positive
+   subu $s0,$zero,$s0
+positive:
+   sw $s0,0($t0)
+   addiu $t0,$t0,4
+   addiu $t1,$t1,-1
+   bne $t1,$zero,inner
+   addiu $s1,$s1,-1
+   bgtz $s1,outer
+   addu $a0,$s0,$zero
+   addiu $v0,$zero,1
+   syscall
+   addiu $v0,$zero,10
+   syscall
+
+   .data
+rounds: .word 1000000
+array: .word 3,1,4,1,5,9,2,6,5,3,5,8,9,7,9,3
+rest: .space 48
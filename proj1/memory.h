@@ -0,0 +1,189 @@
+/**
+ *	@file 		memory.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Paged guest memory.
+ *
+ *	@section 	DESCRIPTION
+ * 	GuestMemory is the address space of a running program,
+ *      cut into 4 KB pages that are only allocated when they
+ *      are first written. Every page starts out reading as one
+ *      shared page of zeros, so reserving a huge array costs a
+ *      table entry per page and nothing more until it is used.
+ *      A program's own words need not be copied either: Map
+ *      points the pages they cover straight at them, and the
+ *      first store into such a page copies it.
+ *
+ *      The page tables are kept the way a TLB is, one host
+ *      pointer per page for loads and one for stores, so an
+ *      address is translated with a shift, one indexed load and
+ *      an add. A page not yet written has no store pointer and
+ *      the store takes the slow path through Touch.
+ *
+ *      Touch also notes the page as dirty. TakeDirty hands the
+ *      dirty pages over and takes their store pointers away
+ *      again, so the next store to each is noted once more;
+ *      snapshots (see replay.h) keep just the pages that changed
+ *      since the one before.
+ **********************************************************/
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+
+const int PAGE_BITS = 12;
+const unsigned int PAGE_SIZE = 1u << PAGE_BITS;
+const unsigned int PAGE_MASK = PAGE_SIZE - 1;
+// pages allocated at once, enough that the host hands them over
+// already zeroed
+const size_t PAGE_CHUNK = 64;
+
+class GuestMemory
+{
+public:
+
+  // constructor, bytes of address space rounded up to whole pages,
+  // all zero
+  GuestMemory(size_t bytes)
+    : _size((bytes + PAGE_MASK) & ~(size_t)PAGE_MASK),
+      _read(_size >> PAGE_BITS, ZeroPage()),
+      _write(_size >> PAGE_BITS, (unsigned char *)NULL),
+      _own(_size >> PAGE_BITS, (unsigned char *)NULL),
+      _initial(_size >> PAGE_BITS, ZeroPage()), _free(0), _pages(0)
+  {
+  }
+
+  ~GuestMemory()
+  {
+    for(size_t i = 0; i < _chunks.size(); ++i)
+      free(_chunks[i]);
+  }
+
+  // makes bytes from address on, which must start a page, read
+  // from host where they lie. host must outlive the memory and is
+  // never written; a partly covered last page is copied
+  void Map(unsigned int address, const void *host, size_t bytes)
+  {
+    const unsigned char *from = (const unsigned char *)host;
+    size_t page = address >> PAGE_BITS;
+    for(; bytes >= PAGE_SIZE; bytes -= PAGE_SIZE, from += PAGE_SIZE)
+    {
+      _read[page] = from;
+      _initial[page] = from;
+      _write[page++] = NULL;
+    }
+    if(bytes)
+    {
+      unsigned char *p = Touch(page << PAGE_BITS);
+      memcpy(p, from, bytes);
+      memset(p + bytes, 0, PAGE_SIZE - bytes);
+    }
+  }
+
+  // the host byte behind address, to load from
+  const unsigned char *Read(unsigned int address) const
+  {
+    return _read[address >> PAGE_BITS] + (address & PAGE_MASK);
+  }
+
+  // the host byte behind address, to store to
+  unsigned char *Write(unsigned int address)
+  {
+    unsigned char *p = _write[address >> PAGE_BITS];
+    return p ? p + (address & PAGE_MASK) : Touch(address);
+  }
+
+  // lets the page holding address be stored to, giving it a page
+  // of its own, a copy of what it reads as, if it has none, and
+  // notes it as dirty. Returns the host byte behind address
+  unsigned char *Touch(unsigned int address)
+  {
+    size_t page = address >> PAGE_BITS;
+    if(!_write[page])
+    {
+      if(!_own[page])
+      {
+        _own[page] = Allocate();
+        if(_read[page] != ZeroPage())
+          memcpy(_own[page], _read[page], PAGE_SIZE);
+        _read[page] = _own[page];
+      }
+      _write[page] = _own[page];
+      _dirty.push_back(page);
+    }
+    return _write[page] + (address & PAGE_MASK);
+  }
+
+  // the pages stored to since the last call, which are clean
+  // again once handed over
+  void TakeDirty(std::vector<size_t> &pages)
+  {
+    for(size_t i = 0; i < _dirty.size(); ++i)
+      _write[_dirty[i]] = NULL;
+    pages.swap(_dirty);
+    _dirty.clear();
+  }
+
+  // sets a page to a copy of bytes, clean
+  void Restore(size_t page, const unsigned char *bytes)
+  {
+    if(!_own[page])
+      _own[page] = Allocate();
+    if(bytes != _own[page])
+      memcpy(_own[page], bytes, PAGE_SIZE);
+    _read[page] = _own[page];
+    _write[page] = NULL;
+  }
+
+  // what a page held when the memory was made and mapped
+  const unsigned char *Initial(size_t page) const {return _initial[page];}
+
+  size_t Size() const {return _size;}
+  // pages allocated so far
+  size_t Pages() const {return _pages;}
+
+  // the page tables, indexed by address >> PAGE_BITS. They never
+  // move, so a caller may keep pointers to them
+  const unsigned char *const *Readable() const {return &_read[0];}
+  unsigned char *const *Writable() const {return &_write[0];}
+
+private:
+  GuestMemory(const GuestMemory &);
+  GuestMemory &operator=(const GuestMemory &);
+
+  unsigned char *Allocate()
+  {
+    if(!_free)
+    {
+      void *chunk = calloc(PAGE_CHUNK, PAGE_SIZE);
+      if(!chunk)
+        throw std::bad_alloc();
+      _chunks.push_back((unsigned char *)chunk);
+      _free = PAGE_CHUNK;
+    }
+    ++_pages;
+    return _chunks.back() + (PAGE_CHUNK - _free--) * PAGE_SIZE;
+  }
+
+  static const unsigned char *ZeroPage()
+  {
+    static const unsigned char zero[PAGE_SIZE] = {0};
+    return zero;
+  }
+
+  size_t _size;
+  std::vector<const unsigned char *> _read;
+  std::vector<unsigned char *> _write;
+  std::vector<unsigned char *> _own;
+  std::vector<const unsigned char *> _initial;
+  std::vector<size_t> _dirty;
+  std::vector<unsigned char *> _chunks;
+  size_t _free;             // pages left in the last chunk
+  size_t _pages;
+};
+
+#endif
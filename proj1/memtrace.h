@@ -0,0 +1,122 @@
+/**
+ *	@file 		memtrace.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Memory traces of running programs.
+ *
+ *	@section 	DESCRIPTION
+ * 	RefSinks for the interpreter that join the assembler to
+ *      the cache simulator in ../proj2. TraceWriter writes the
+ *      references of a run as a trace file proj2 reads, in the
+ *      text or binary format of trace.h. CacheSink runs them
+ *      straight through a Cache, and TLBs if given, with no
+ *      file in between, so a program's hit rate is measured as
+ *      it runs however many references it makes. RefTee hands
+ *      the same references to several sinks.
+ **********************************************************/
+
+#ifndef MEMTRACE_H
+#define MEMTRACE_H
+
+#include <cstdio>
+#include <vector>
+#include "interp.h"
+#include "../proj2/cache.h"
+#include "../proj2/tlb.h"
+#include "../proj2/parse.h"
+
+// writes references to a trace file
+class TraceWriter : public RefSink
+{
+public:
+
+  // constructor, the binary format starts with its magic
+  TraceWriter(FILE *file, bool binary): _file(file), _binary(binary)
+  {
+    if(_binary)
+      fwrite(TRACE_MAGIC, 1, TRACE_MAGIC_SIZE, _file);
+  }
+
+  void Refs(const MemRef *refs, size_t count)
+  {
+    _buffer.resize(count * (_binary ? TRACE_RECORD_SIZE : 16));
+    char *out = &_buffer[0];
+    for(size_t i = 0; i < count; ++i)
+    {
+      if(_binary)
+      {
+        EncodeRef(refs[i], (unsigned char *)out);
+        out += TRACE_RECORD_SIZE;
+      }
+      else
+      {
+        out += FormatRef(refs[i], out);
+        *out++ = '\n';
+      }
+    }
+    fwrite(&_buffer[0], 1, out - &_buffer[0], _file);
+  }
+
+private:
+  FILE *_file;
+  bool _binary;
+  std::vector<char> _buffer;
+};
+
+// passes references on to every sink added
+class RefTee : public RefSink
+{
+public:
+  void Add(RefSink *sink) {_sinks.push_back(sink);}
+
+  void Refs(const MemRef *refs, size_t count)
+  {
+    for(size_t i = 0; i < _sinks.size(); ++i)
+      _sinks[i]->Refs(refs, count);
+  }
+
+private:
+  std::vector<RefSink *> _sinks;
+};
+
+// simulates references in a cache, counting reads of the text,
+// which are instruction fetches, apart from data references
+class CacheSink : public RefSink
+{
+public:
+
+  // constructor, mmu may be NULL for no address translation
+  CacheSink(Cache &cache, Mmu *mmu, unsigned int textBytes)
+    : _cache(cache), _mmu(mmu), _textBytes(textBytes), _fetches(0),
+      _loads(0), _stores(0)
+  {
+  }
+
+  void Refs(const MemRef *refs, size_t count)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      SimulateRef(_cache, refs[i], _mmu);
+      if(refs[i].write)
+        ++_stores;
+      else if(refs[i].address < _textBytes)
+        ++_fetches;
+      else
+        ++_loads;
+    }
+  }
+
+  unsigned long long Fetches() const {return _fetches;}
+  unsigned long long Loads() const {return _loads;}
+  unsigned long long Stores() const {return _stores;}
+
+private:
+  Cache &_cache;
+  Mmu *_mmu;
+  unsigned int _textBytes;
+  unsigned long long _fetches;
+  unsigned long long _loads;
+  unsigned long long _stores;
+};
+
+#endif
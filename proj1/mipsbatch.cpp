@@ -0,0 +1,268 @@
+/**
+ *	@file 		mipsbatch.cpp
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Runs many program instances across cores.
+ *
+ *	@section 	DESCRIPTION
+ * 	This program runs every program given once over every
+ *      input listed in --inputs, or once with no input if there
+ *      is no list, on a work stealing pool of -j threads (see
+ *      batch.h). Programs are source files or linked objects as
+ *      mipsrun takes them, named on the command line or one a
+ *      line in --programs. An input is a file a run's syscalls
+ *      read from.
+ *
+ *      A line is printed per instance with how it stopped, its
+ *      exit code, the instructions it ran, its cycles and CPI
+ *      on the pipeline if --pipeline is given, and the size and
+ *      a hash of what it printed, so runs that should agree are
+ *      easy to compare. -o writes what each printed to dir/n.out
+ *      as well. Totals and the throughput of the whole batch
+ *      follow. Returns 1 if any instance faulted.
+ *
+ *        mipsbatch [-j threads] [-n limit] [-m bytes] [--blocks]
+ *                  [--pipeline config] [--inputs list] [--programs list]
+ *                  [-o dir] [program ...]
+ **********************************************************/
+
+#ifndef MIPSBATCH_CPP
+#define MIPSBATCH_CPP
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include "batch.h"
+
+// reads the lines of a list file that are not blank into names,
+// returns false if it cannot be read
+bool ReadList(const char *list, std::vector<std::string> &names)
+{
+  std::ifstream in(list);
+  if(!in)
+    return false;
+  std::string line;
+  while(std::getline(in, line))
+  {
+    if(CleanLine(line))
+      names.push_back(line);
+  }
+  return true;
+}
+
+// 32 bit FNV-1a hash of what an instance printed
+unsigned int OutputHash(const std::string &s)
+{
+  unsigned int h = 2166136261u;
+  for(size_t i = 0; i < s.size(); ++i)
+    h = (h ^ (unsigned char)s[i]) * 16777619u;
+  return h;
+}
+
+const char *StopName(Stop stop)
+{
+  switch(stop)
+  {
+  case STOP_EXIT:
+    return "exit";
+  case STOP_END:
+    return "end";
+  case STOP_LIMIT:
+    return "limit";
+  default:
+    return "fault";
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  BatchOptions options;
+  int threads = std::thread::hardware_concurrency();
+  const char *pipelineName = NULL;
+  const char *inputList = NULL;
+  const char *outDir = NULL;
+  std::vector<std::string> names;
+  bool usage = false;
+  for(int i = 1; i < argc; ++i)
+  {
+    std::string option = argv[i];
+    bool value = i + 1 < argc;
+    if(option == "--blocks")
+      options.blocks = true;
+    else if(value && option == "-j")
+      threads = atoi(argv[++i]);
+    else if(value && option == "-n")
+      options.limit = strtoull(argv[++i], NULL, 0);
+    else if(value && option == "-m")
+      options.memory = strtoull(argv[++i], NULL, 0);
+    else if(value && option == "--pipeline")
+      pipelineName = argv[++i];
+    else if(value && option == "--inputs")
+      inputList = argv[++i];
+    else if(value && option == "-o")
+      outDir = argv[++i];
+    else if(value && option == "--programs")
+    {
+      if(!ReadList(argv[++i], names))
+      {
+        std::cerr << "error: cannot read '" << argv[i] << "'" << std::endl;
+        return 1;
+      }
+    }
+    else if(option[0] == '-')
+      usage = true;
+    else
+      names.push_back(option);
+  }
+  if(usage || names.empty())
+  {
+    std::cerr << "usage: mipsbatch [-j threads] [-n limit] [-m bytes]"
+              << " [--blocks]" << std::endl
+              << "                 [--pipeline config] [--inputs list]"
+              << " [--programs list]" << std::endl
+              << "                 [-o dir] [program ...]" << std::endl;
+    return 1;
+  }
+  if(pipelineName)
+  {
+    if(!ReadPipelineConfig(pipelineName, options.pipeline))
+    {
+      std::cerr << "error: cannot read pipeline config '" << pipelineName
+                << "'" << std::endl;
+      return 1;
+    }
+    options.timed = true;
+  }
+
+  // every input is read once and shared by the runs over it
+  std::vector<std::string> inputNames;
+  std::vector<std::string> inputs;
+  if(inputList && !ReadList(inputList, inputNames))
+  {
+    std::cerr << "error: cannot read '" << inputList << "'" << std::endl;
+    return 1;
+  }
+  for(size_t i = 0; i < inputNames.size(); ++i)
+  {
+    std::ifstream in(inputNames[i].c_str());
+    if(!in)
+    {
+      std::cerr << "error: cannot read '" << inputNames[i] << "'"
+                << std::endl;
+      return 1;
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    inputs.push_back(text.str());
+  }
+
+  std::vector<BatchProgram> programs(names.size());
+  for(size_t i = 0; i < names.size(); ++i)
+  {
+    BatchProgram &p = programs[i];
+    p.name = names[i];
+    if(!LoadProgram(p.name, p.program))
+      return 1;
+    p.image = new Image(p.program);
+    if(options.timed)
+      p.text = p.program.Text();
+  }
+
+  // instances run every program over every input, program by
+  // program
+  size_t perProgram = inputs.empty() ? 1 : inputs.size();
+  std::vector<Instance> runs(programs.size() * perProgram);
+  for(size_t i = 0; i < runs.size(); ++i)
+  {
+    runs[i].program = i / perProgram;
+    runs[i].input = inputs.empty() ? -1 : i % perProgram;
+  }
+
+  StealingPool pool(threads);
+  std::chrono::steady_clock::time_point start
+    = std::chrono::steady_clock::now();
+  pool.Run(runs.size(), [&](size_t i)
+  {
+    Instance &run = runs[i];
+    RunInstance(programs[run.program],
+                run.input < 0 ? std::string() : inputs[run.input], options,
+                run);
+  });
+  std::chrono::steady_clock::time_point end
+    = std::chrono::steady_clock::now();
+
+  unsigned long long instructions = 0;
+  unsigned long long cycles = 0;
+  int faults = 0;
+  std::cout << std::setw(8) << "instance" << "  " << std::left
+            << std::setw(20) << "program" << std::setw(16) << "input"
+            << std::right << std::setw(6) << "stop" << std::setw(6)
+            << "exit" << std::setw(14) << "instructions";
+  if(options.timed)
+    std::cout << std::setw(14) << "cycles" << std::setw(8) << "CPI";
+  std::cout << std::setw(10) << "output" << std::setw(10) << "hash"
+            << std::endl;
+  for(size_t i = 0; i < runs.size(); ++i)
+  {
+    const Instance &run = runs[i];
+    instructions += run.instructions;
+    cycles += run.cycles;
+    std::cout << std::setw(8) << i << "  " << std::left << std::setw(19)
+              << programs[run.program].name << " " << std::setw(15)
+              << (run.input < 0 ? "-" : inputNames[run.input]) << " "
+              << std::right << std::setw(6) << StopName(run.stop)
+              << std::setw(6) << run.exitCode << std::setw(14)
+              << run.instructions;
+    if(options.timed)
+      std::cout << std::setw(14) << run.cycles << std::setw(8) << std::fixed
+                << std::setprecision(3)
+                << (run.instructions ? (double)run.cycles / run.instructions
+                    : 0);
+    std::cout << std::setw(10) << run.output.size() << "  " << std::hex
+              << std::setw(8) << std::setfill('0') << OutputHash(run.output)
+              << std::dec << std::setfill(' ') << std::endl;
+    if(run.stop == STOP_FAULT)
+    {
+      ++faults;
+      std::cerr << "error: instance " << i << ": " << run.fault << std::endl;
+    }
+
+    if(outDir)
+    {
+      std::ostringstream name;
+      name << outDir << "/" << i << ".out";
+      std::ofstream out(name.str().c_str());
+      out << run.output;
+      if(!out)
+      {
+        std::cerr << "error: cannot write '" << name.str() << "'"
+                  << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout << std::endl << runs.size() << " instances of "
+            << programs.size() << " program(s) on " << pool.Threads()
+            << " thread(s), " << pool.Steals() << " steals" << std::endl
+            << instructions << " instructions";
+  if(options.timed)
+    std::cout << ", " << cycles << " cycles, CPI " << std::fixed
+              << std::setprecision(3)
+              << (instructions ? (double)cycles / instructions : 0);
+  std::cout << std::endl << std::fixed << std::setprecision(3) << seconds
+            << " s, " << std::setprecision(1) << runs.size() / seconds
+            << " instances/s, " << instructions / seconds / 1e6
+            << " M instructions/s" << std::endl;
+  if(faults)
+    std::cout << faults << " instance(s) faulted" << std::endl;
+  return faults ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,448 @@
+/**
+ *	@file 		mipsrun.cpp
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Runs assembled programs.
+ *
+ *	@section 	DESCRIPTION
+ * 	This program runs a MIPS program on the interpreter. The
+ *      program is a source file, a linked object or the hex
+ *      words of a .obj, which do not say where text ends, so
+ *      -t gives the number of text words. Syscalls read and
+ *      print on the console; --blocks runs from translated
+ *      basic blocks and --stats reports how many instructions
+ *      ran, how fast and how many memory pages it wrote.
+ *
+ *      --trace writes every instruction fetch, load and store
+ *      as a trace for the cache simulator in ../proj2, in its
+ *      binary format with --binary. --cache runs them through
+ *      the simulator's cache as the program runs instead, with
+ *      TLBs in front if --tlb is given, and reports hit rates.
+ *      --pipeline times the run on a five stage pipeline (see
+ *      pipeline.h) and reports CPI, stalls and hotspots, and
+ *      --ooo on an out of order superscalar core (see ooo.h)
+ *      and reports IPC and what held dispatch back. These may be
+ *      given together.
+ *
+ *      --predict runs branch predictors (see predict.h), a comma
+ *      separated list or all, over the conditional branches and
+ *      reports their accuracy and the CPI their mispredictions
+ *      give, on top of the pipeline's cycles if it is timed and
+ *      one cycle per instruction if not. --penalty sets the
+ *      cycles a misprediction costs. --branch-trace writes the
+ *      branches as a trace that bpsim reads.
+ *
+ *      --profile counts the runs of every pc and reports the
+ *      functions, hottest pcs and basic blocks by label, the
+ *      opcode mix and a memory heat map (see profile.h).
+ *      --callgrind and --folded write the profile for
+ *      KCachegrind and for flamegraph.pl, and profile too.
+ *
+ *      --record writes every value the syscalls read to a log,
+ *      and --replay reads them from one rather than the console,
+ *      so a run can be repeated exactly. --debug runs a script
+ *      of commands on it (see replay.h) that go to any
+ *      instruction count, forward or back, and print registers
+ *      and memory, from snapshots taken every --snapshots
+ *      instructions. Tracing, the timing models, the predictors
+ *      and the profile watch a run going forward only and are
+ *      not taken with it.
+ *
+ *        mipsrun [-n limit] [-m bytes] [-t words] [--blocks] [--stats]
+ *                [--trace file [--binary]] [--cache config [--tlb config]]
+ *                [--pipeline config] [--ooo config]
+ *                [--predict list [--penalty cycles]]
+ *                [--branch-trace file] [--profile] [--callgrind file]
+ *                [--folded file] [--record log] [--replay log]
+ *                [--debug script [--snapshots interval]] file
+ **********************************************************/
+
+#ifndef MIPSRUN_CPP
+#define MIPSRUN_CPP
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include "interp.h"
+#include "memtrace.h"
+#include "pipeline.h"
+#include "ooo.h"
+#include "predict.h"
+#include "profile.h"
+#include "replay.h"
+
+int main(int argc, char *argv[])
+{
+  unsigned long long limit = ULLONG_MAX;
+  size_t memory = DEFAULT_MEMORY;
+  int textWords = -1;
+  bool stats = false;
+  bool blocks = false;
+  bool binary = false;
+  const char *traceName = NULL;
+  const char *cacheName = NULL;
+  const char *tlbName = NULL;
+  const char *pipelineName = NULL;
+  const char *oooName = NULL;
+  const char *predictors = NULL;
+  const char *branchName = NULL;
+  bool profile = false;
+  const char *callgrindName = NULL;
+  const char *foldedName = NULL;
+  const char *recordName = NULL;
+  const char *replayName = NULL;
+  const char *debugName = NULL;
+  unsigned long long interval = DEFAULT_SNAPSHOT_INTERVAL;
+  int penalty = -1;
+  while(argc > 2 && argv[1][0] == '-')
+  {
+    std::string option = argv[1];
+    bool flag = option == "--stats" || option == "--blocks"
+      || option == "--binary" || option == "--profile";
+    if(option == "--stats")
+      stats = true;
+    else if(option == "--blocks")
+      blocks = true;
+    else if(option == "--binary")
+      binary = true;
+    else if(option == "--profile")
+      profile = true;
+    else if(argc > 3 && option == "-n")
+      limit = strtoull(argv[2], NULL, 0);
+    else if(argc > 3 && option == "-m")
+      memory = strtoull(argv[2], NULL, 0);
+    else if(argc > 3 && option == "-t")
+      textWords = atoi(argv[2]);
+    else if(argc > 3 && option == "--trace")
+      traceName = argv[2];
+    else if(argc > 3 && option == "--cache")
+      cacheName = argv[2];
+    else if(argc > 3 && option == "--tlb")
+      tlbName = argv[2];
+    else if(argc > 3 && option == "--pipeline")
+      pipelineName = argv[2];
+    else if(argc > 3 && option == "--ooo")
+      oooName = argv[2];
+    else if(argc > 3 && option == "--predict")
+      predictors = argv[2];
+    else if(argc > 3 && option == "--penalty")
+      penalty = atoi(argv[2]);
+    else if(argc > 3 && option == "--branch-trace")
+      branchName = argv[2];
+    else if(argc > 3 && option == "--callgrind")
+      callgrindName = argv[2];
+    else if(argc > 3 && option == "--folded")
+      foldedName = argv[2];
+    else if(argc > 3 && option == "--record")
+      recordName = argv[2];
+    else if(argc > 3 && option == "--replay")
+      replayName = argv[2];
+    else if(argc > 3 && option == "--debug")
+      debugName = argv[2];
+    else if(argc > 3 && option == "--snapshots")
+      interval = strtoull(argv[2], NULL, 0);
+    if(!flag)
+    {
+      ++argv;
+      --argc;
+    }
+    ++argv;
+    --argc;
+  }
+  profile = profile || callgrindName || foldedName;
+  bool watched = traceName || cacheName || pipelineName || oooName
+    || predictors || branchName || profile;
+  if(argc != 2 || (tlbName && !cacheName) || (debugName && watched))
+  {
+    std::cerr << "usage: mipsrun [-n limit] [-m bytes] [-t words] [--blocks]"
+              << " [--stats]" << std::endl
+              << "               [--trace file [--binary]]"
+              << " [--cache config [--tlb config]]" << std::endl
+              << "               [--pipeline config] [--ooo config]"
+              << std::endl
+              << "               [--predict list [--penalty cycles]]"
+              << " [--branch-trace file]" << std::endl
+              << "               [--profile] [--callgrind file]"
+              << " [--folded file]" << std::endl
+              << "               [--record log] [--replay log]"
+              << std::endl
+              << "               [--debug script [--snapshots interval]]"
+              << " file" << std::endl;
+    return 1;
+  }
+
+  Program program;
+  if(!LoadProgram(argv[1], program, textWords))
+    return 1;
+
+  Image image(program);
+  Interpreter machine(image, memory);
+  std::vector<int> code = program.Text();
+  machine.Translate(blocks);
+
+  // the cache is set up as proj2 does, from set size, line size
+  // and total size
+  FILE *traceFile = NULL;
+  TraceWriter *writer = NULL;
+  Cache *cache = NULL;
+  Mmu *mmu = NULL;
+  CacheSink *simulator = NULL;
+  Pipeline *pipeline = NULL;
+  RefTee sinks;
+  if(traceName)
+  {
+    traceFile = fopen(traceName, binary ? "wb" : "w");
+    if(!traceFile)
+    {
+      std::cerr << "error: cannot write '" << traceName << "'" << std::endl;
+      return 1;
+    }
+    writer = new TraceWriter(traceFile, binary);
+    sinks.Add(writer);
+  }
+  if(cacheName)
+  {
+    std::ifstream config(cacheName);
+    int setSize, lineSize, cacheSize;
+    if(!(config >> setSize >> lineSize >> cacheSize))
+    {
+      std::cerr << "error: cannot read cache config '" << cacheName << "'"
+                << std::endl;
+      return 1;
+    }
+    cache = new Cache(setSize, lineSize, cacheSize);
+    if(tlbName && !(mmu = Mmu::FromFile(tlbName, *cache)))
+    {
+      std::cerr << "error: cannot read TLB config '" << tlbName << "'"
+                << std::endl;
+      return 1;
+    }
+    simulator = new CacheSink(*cache, mmu, machine.TextWords() * 4);
+    sinks.Add(simulator);
+  }
+  if(pipelineName)
+  {
+    PipelineConfig config;
+    if(!ReadPipelineConfig(pipelineName, config))
+    {
+      std::cerr << "error: cannot read pipeline config '" << pipelineName
+                << "'" << std::endl;
+      return 1;
+    }
+    pipeline = new Pipeline(code, machine.TextWords(), config);
+    sinks.Add(pipeline);
+  }
+  OutOfOrder *ooo = NULL;
+  if(oooName)
+  {
+    OutOfOrderConfig config;
+    if(!ReadOutOfOrderConfig(oooName, config))
+    {
+      std::cerr << "error: cannot read out of order config '" << oooName
+                << "'" << std::endl;
+      return 1;
+    }
+    ooo = new OutOfOrder(code, machine.TextWords(), config);
+    sinks.Add(ooo);
+  }
+  Profiler *profiler = NULL;
+  if(profile)
+  {
+    profiler = new Profiler(code, machine.TextWords(), program.labels);
+    sinks.Add(profiler);
+  }
+  if(traceName || cacheName || pipelineName || ooo || profile)
+    machine.Trace(&sinks);
+
+  BranchPredictors predicting;
+  BranchTee branchSinks;
+  FILE *branchFile = NULL;
+  BranchWriter *branchWriter = NULL;
+  if(predictors)
+  {
+    if(!predicting.AddList(predictors))
+    {
+      std::cerr << "error: unknown predictor in '" << predictors << "'"
+                << std::endl;
+      return 1;
+    }
+    branchSinks.Add(&predicting);
+  }
+  if(branchName)
+  {
+    if(!(branchFile = fopen(branchName, "w")))
+    {
+      std::cerr << "error: cannot write '" << branchName << "'" << std::endl;
+      return 1;
+    }
+    branchWriter = new BranchWriter(branchFile);
+    branchSinks.Add(branchWriter);
+  }
+  if(predictors || branchName)
+    machine.WatchBranches(&branchSinks);
+
+  std::vector<int> inputs;
+  if(replayName && !ReadInputLog(replayName, inputs))
+  {
+    std::cerr << "error: cannot read input log '" << replayName << "'"
+              << std::endl;
+    return 1;
+  }
+  if(recordName || replayName)
+    machine.LogInput(&inputs);
+  std::ifstream script;
+  if(debugName && !(script.open(debugName), script))
+  {
+    std::cerr << "error: cannot read '" << debugName << "'" << std::endl;
+    return 1;
+  }
+
+  std::chrono::steady_clock::time_point start
+    = std::chrono::steady_clock::now();
+  Stop stop;
+  TimeMachine *travel = NULL;
+  int badCommands = 0;
+  if(debugName)
+  {
+    travel = new TimeMachine(machine, std::cin, std::cout, inputs, interval);
+    badCommands = Debug(*travel, machine, script, std::cout);
+    stop = travel->Stopped();
+  }
+  else
+    stop = machine.Run(limit);
+  std::chrono::steady_clock::time_point end
+    = std::chrono::steady_clock::now();
+  std::cout.flush();
+
+  if(stats)
+  {
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cerr << machine.Executed() << " instructions in " << std::fixed
+              << std::setprecision(3) << seconds << " s, "
+              << std::setprecision(1) << machine.Executed() / seconds / 1e6
+              << " M instructions/s, " << machine.PagesTouched()
+              << " pages written" << std::endl;
+    if(blocks)
+      std::cerr << machine.Blocks() << " blocks translated, "
+                << machine.ChainHits() << " chained branches, "
+                << machine.Lookups() << " lookups, " << machine.Flushes()
+                << " flushes" << std::endl;
+    if(travel)
+      std::cerr << travel->Snapshots() << " snapshots of "
+                << travel->SnapshotPages() << " pages, "
+                << travel->Restores() << " restores, " << travel->Replayed()
+                << " instructions replayed" << std::endl;
+  }
+  delete travel;
+  if(recordName && !WriteInputLog(recordName, inputs))
+  {
+    std::cerr << "error: cannot write '" << recordName << "'" << std::endl;
+    return 1;
+  }
+  if(traceFile)
+  {
+    delete writer;
+    if(fclose(traceFile) != 0)
+    {
+      std::cerr << "error: cannot write '" << traceName << "'" << std::endl;
+      return 1;
+    }
+  }
+  if(simulator)
+  {
+    // the rate is over what the cache counted, as proj2's is
+    long long refs = cache->GetHits() + cache->GetMisses();
+    std::cout << std::endl;
+    cache->PrintConfig();
+    std::cout << std::endl << "Fetches:\t" << simulator->Fetches()
+              << std::endl << "Loads:\t\t" << simulator->Loads()
+              << std::endl << "Stores:\t\t" << simulator->Stores()
+              << std::endl << "Total Hits:\t" << cache->GetHits()
+              << std::endl << "Total Misses:\t" << cache->GetMisses()
+              << std::endl << "Hit Rate:\t" << std::setprecision(5)
+              << (refs ? (double)cache->GetHits() / refs : 0) << std::endl;
+    if(mmu)
+      mmu->PrintSummary();
+    delete simulator;
+    delete mmu;
+    delete cache;
+  }
+  if(pipeline)
+  {
+    std::cout << std::endl;
+    pipeline->Report(std::cout, code);
+  }
+  if(ooo)
+  {
+    std::cout << std::endl;
+    ooo->Report(std::cout);
+    delete ooo;
+  }
+  if(predictors)
+  {
+    // the pipeline's cycles without its not taken guesses, or an
+    // ideal one instruction a cycle
+    double base = machine.Executed();
+    if(pipeline)
+      base = pipeline->Cycles() - pipeline->BranchFlushes();
+    if(penalty < 0)
+      penalty = pipeline ? pipeline->BranchPenalty() : 2;
+    std::cout << std::endl;
+    predicting.Report(std::cout, machine.Executed(), base, penalty, &code);
+  }
+  delete pipeline;
+  if(profiler)
+  {
+    std::cout << std::endl;
+    profiler->Report(std::cout);
+    if(callgrindName)
+    {
+      std::ofstream out(callgrindName);
+      profiler->WriteCallgrind(out, argv[1]);
+      if(!out)
+      {
+        std::cerr << "error: cannot write '" << callgrindName << "'"
+                  << std::endl;
+        return 1;
+      }
+    }
+    if(foldedName)
+    {
+      std::ofstream out(foldedName);
+      profiler->WriteFolded(out);
+      if(!out)
+      {
+        std::cerr << "error: cannot write '" << foldedName << "'"
+                  << std::endl;
+        return 1;
+      }
+    }
+    delete profiler;
+  }
+  if(branchFile)
+  {
+    delete branchWriter;
+    if(fclose(branchFile) != 0)
+    {
+      std::cerr << "error: cannot write '" << branchName << "'" << std::endl;
+      return 1;
+    }
+  }
+  if(stop == STOP_FAULT)
+  {
+    std::cerr << "error: " << machine.Fault() << std::endl;
+    return 1;
+  }
+  if(stop == STOP_LIMIT)
+    std::cerr << "stopped after " << machine.Executed() << " instructions"
+              << std::endl;
+  if(badCommands)
+    return 1;
+  return machine.ExitCode();
+}
+
+#endif
@@ -0,0 +1,415 @@
+/**
+ *	@file 		object.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Binary object files.
+ *
+ *	@section 	DESCRIPTION
+ * 	An object file holds the text and data words of one
+ *      source file with its symbols and relocations, so files
+ *      can be assembled on their own and linked. All numbers
+ *      are 32 bit little endian:
+ *
+ *        magic "MIPSOBJ2"
+ *        text words, data words, zero words, symbols,
+ *          relocations and string table bytes
+ *        text words, then data words
+ *        symbols: name offset, section, value, flags
+ *        relocations: text word, symbol, label use
+ *        string table of null terminated names
+ *
+ *      Symbol values are word offsets into their section. The
+ *      words are encoded as if the file were linked alone, text
+ *      at 0 and data after it, and a relocation says how to
+ *      refill its field once the real addresses are known. A
+ *      linked program is an object with no relocations. The
+ *      zero words follow the data but are not stored, so an
+ *      array reserved with .space takes no room in the file.
+ *      Files of the older "MIPSOBJ1" format, with no zero
+ *      words, are still read.
+ *
+ *      Files are read through a private read only mapping
+ *      (MappedObject), which a loader can run a program's
+ *      words from where they lie without copying them.
+ **********************************************************/
+
+#ifndef OBJECT_H
+#define OBJECT_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "onepass.h"
+
+const char OBJECT_MAGIC[] = "MIPSOBJ2";
+const char OBJECT_MAGIC_V1[] = "MIPSOBJ1";
+const int OBJECT_MAGIC_SIZE = 8;
+
+// where a symbol is defined
+enum Section
+{
+  SECTION_UNDEFINED,
+  SECTION_TEXT,
+  SECTION_DATA
+};
+
+struct ObjSymbol
+{
+  std::string name;
+  Section section;
+  int value;                // word offset into the section
+  bool global;
+};
+
+struct Relocation
+{
+  int offset;               // text word to refill
+  int symbol;               // index into the symbols
+  LabelUse use;
+};
+
+struct Object
+{
+  Object(): zeroWords(0) {}
+
+  std::vector<int> text;
+  std::vector<int> data;
+  size_t zeroWords;         // zeros after the data, not stored
+  std::vector<ObjSymbol> symbols;
+  std::vector<Relocation> relocations;
+};
+
+// makes an object from a finished relocatable assembly. Branches
+// to labels in the same file need no relocation since their
+// offsets do not change when the text moves
+inline void ObjectFromAssembly(OnePass &assembler, Object &obj)
+{
+  SymbolTable &table = assembler.Symbols();
+  const std::vector<int> &code = assembler.Code();
+  int dataStart = table.DataStart();
+
+  obj.text.assign(code.begin(), code.begin() + dataStart);
+  obj.data.assign(code.begin() + dataStart, code.end());
+  obj.zeroWords = assembler.ZeroWords();
+
+  obj.symbols.resize(table.Size());
+  for(int i = 0; i < table.Size(); ++i)
+  {
+    ObjSymbol &sym = obj.symbols[i];
+    sym.name = table.Name(i);
+    sym.global = table[i].global;
+    sym.section = !table[i].defined ? SECTION_UNDEFINED
+      : table[i].inData ? SECTION_DATA : SECTION_TEXT;
+    sym.value = table[i].address
+      - (sym.section == SECTION_DATA ? dataStart : 0);
+  }
+
+  obj.relocations.clear();
+  const std::vector<Fixup> &fixups = assembler.Fixups();
+  for(size_t i = 0; i < fixups.size(); ++i)
+  {
+    if(fixups[i].use == USE_BRANCH && table[fixups[i].symbol].defined)
+      continue;
+    Relocation r = {fixups[i].pc, fixups[i].symbol, fixups[i].use};
+    obj.relocations.push_back(r);
+  }
+}
+
+inline void PutWord(std::vector<char> &out, unsigned int w)
+{
+  for(int i = 0; i < 4; ++i)
+    out.push_back((char)((w >> (8 * i)) & 0xFF));
+}
+
+inline unsigned int GetWord(const char *p)
+{
+  const unsigned char *u = (const unsigned char *)p;
+  return u[0] | (u[1] << 8) | (u[2] << 16) | ((unsigned int)u[3] << 24);
+}
+
+// writes an object file, returns false if it could not be written
+inline bool WriteObject(const std::string &name, const Object &obj)
+{
+  std::vector<char> strings;
+  std::vector<char> out(OBJECT_MAGIC, OBJECT_MAGIC + OBJECT_MAGIC_SIZE);
+
+  for(size_t i = 0; i < obj.symbols.size(); ++i)
+    strings.insert(strings.end(), obj.symbols[i].name.c_str(),
+                   obj.symbols[i].name.c_str()
+                   + obj.symbols[i].name.size() + 1);
+
+  PutWord(out, obj.text.size());
+  PutWord(out, obj.data.size());
+  PutWord(out, obj.zeroWords);
+  PutWord(out, obj.symbols.size());
+  PutWord(out, obj.relocations.size());
+  PutWord(out, strings.size());
+  for(size_t i = 0; i < obj.text.size(); ++i)
+    PutWord(out, obj.text[i]);
+  for(size_t i = 0; i < obj.data.size(); ++i)
+    PutWord(out, obj.data[i]);
+
+  unsigned int offset = 0;
+  for(size_t i = 0; i < obj.symbols.size(); ++i)
+  {
+    PutWord(out, offset);
+    PutWord(out, obj.symbols[i].section);
+    PutWord(out, obj.symbols[i].value);
+    PutWord(out, obj.symbols[i].global ? 1 : 0);
+    offset += obj.symbols[i].name.size() + 1;
+  }
+  for(size_t i = 0; i < obj.relocations.size(); ++i)
+  {
+    PutWord(out, obj.relocations[i].offset);
+    PutWord(out, obj.relocations[i].symbol);
+    PutWord(out, obj.relocations[i].use);
+  }
+  out.insert(out.end(), strings.begin(), strings.end());
+
+  std::ofstream f(name.c_str(), std::ios::binary);
+  f.write(&out[0], out.size());
+  return (bool)f;
+}
+
+// the counts at the start of an object file
+struct ObjectHeader
+{
+  size_t bytes;             // of the header
+  size_t textWords;
+  size_t dataWords;
+  size_t zeroWords;
+  size_t symbols;
+  size_t relocations;
+  size_t stringBytes;
+};
+
+// reads the header of an object file of size bytes, returns false
+// if it is not one or its counts do not add up to its size
+inline bool ReadObjectHeader(const char *in, size_t size, ObjectHeader &h)
+{
+  bool v1 = size >= OBJECT_MAGIC_SIZE
+    && memcmp(in, OBJECT_MAGIC_V1, OBJECT_MAGIC_SIZE) == 0;
+  h.bytes = OBJECT_MAGIC_SIZE + (v1 ? 5 : 6) * 4;
+  if(size < h.bytes
+     || (!v1 && memcmp(in, OBJECT_MAGIC, OBJECT_MAGIC_SIZE) != 0))
+    return false;
+
+  const char *p = in + OBJECT_MAGIC_SIZE;
+  h.textWords = GetWord(p);
+  h.dataWords = GetWord(p + 4);
+  h.zeroWords = v1 ? 0 : GetWord(p + 8);
+  p += v1 ? 8 : 12;
+  h.symbols = GetWord(p);
+  h.relocations = GetWord(p + 4);
+  h.stringBytes = GetWord(p + 8);
+  unsigned long long total = h.bytes + 4ull * h.textWords
+    + 4ull * h.dataWords + 16ull * h.symbols + 12ull * h.relocations
+    + h.stringBytes;
+  return total == size;
+}
+
+// an object file mapped read only into memory. The mapping is
+// private, so the file changing underneath does not change it
+class MappedObject
+{
+public:
+  MappedObject(): _file(NULL), _size(0) {}
+  ~MappedObject() {Unmap();}
+
+  // maps a file, returns false if it cannot be read or is not an
+  // object file
+  bool Map(const std::string &name)
+  {
+    Unmap();
+    int fd = open(name.c_str(), O_RDONLY);
+    if(fd < 0)
+      return false;
+    struct stat st;
+    void *p = MAP_FAILED;
+    if(fstat(fd, &st) == 0 && st.st_size > 0)
+      p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED)
+      return false;
+    _file = (const char *)p;
+    _size = st.st_size;
+    if(ReadObjectHeader(_file, _size, _header))
+      return true;
+    Unmap();
+    return false;
+  }
+
+  void Unmap()
+  {
+    if(_file)
+      munmap((void *)_file, _size);
+    _file = NULL;
+    _size = 0;
+  }
+
+  bool Mapped() const {return _file != NULL;}
+  const char *File() const {return _file;}
+  size_t Size() const {return _size;}
+  const ObjectHeader &Header() const {return _header;}
+  // the text words then the data words, in place
+  const char *Words() const {return _file + _header.bytes;}
+
+private:
+  MappedObject(const MappedObject &);
+  MappedObject &operator=(const MappedObject &);
+
+  const char *_file;
+  size_t _size;
+  ObjectHeader _header;
+};
+
+// reads an object file, returns false if it cannot be read or is
+// not a well formed object
+inline bool ReadObject(const std::string &name, Object &obj)
+{
+  MappedObject file;
+  if(!file.Map(name))
+    return false;
+  const ObjectHeader &h = file.Header();
+  const char *p = file.Words();
+  const char *strings = file.File() + file.Size() - h.stringBytes;
+  obj.text.resize(h.textWords);
+  for(size_t i = 0; i < h.textWords; ++i, p += 4)
+    obj.text[i] = GetWord(p);
+  obj.data.resize(h.dataWords);
+  for(size_t i = 0; i < h.dataWords; ++i, p += 4)
+    obj.data[i] = GetWord(p);
+  obj.zeroWords = h.zeroWords;
+
+  obj.symbols.resize(h.symbols);
+  for(size_t i = 0; i < h.symbols; ++i, p += 16)
+  {
+    size_t offset = GetWord(p);
+    unsigned int section = GetWord(p + 4);
+    if(offset >= h.stringBytes || section > SECTION_DATA
+       || !memchr(strings + offset, 0, h.stringBytes - offset))
+      return false;
+    obj.symbols[i].name = strings + offset;
+    obj.symbols[i].section = (Section)section;
+    obj.symbols[i].value = GetWord(p + 8);
+    obj.symbols[i].global = GetWord(p + 12) & 1;
+  }
+
+  obj.relocations.resize(h.relocations);
+  for(size_t i = 0; i < h.relocations; ++i, p += 12)
+  {
+    Relocation &r = obj.relocations[i];
+    r.offset = GetWord(p);
+    r.symbol = GetWord(p + 4);
+    unsigned int use = GetWord(p + 8);
+    if((size_t)r.offset >= h.textWords || (size_t)r.symbol >= h.symbols
+       || use > USE_LO)
+      return false;
+    r.use = (LabelUse)use;
+  }
+  return true;
+}
+
+// links objects into one program: every text section in order, then
+// every data section. The zeros after each data section but the
+// last are filled in, the last one's stay zero words. Each
+// relocation is refilled with its symbol's final address, looked
+// up in its own file first and among the global symbols of all
+// files if it is undefined there. Returns the number of errors
+// found
+inline int Link(const std::vector<Object> &objs,
+                const std::vector<std::string> &names, Object &out)
+{
+  std::vector<int> textBase(objs.size());
+  std::vector<int> dataBase(objs.size());
+  int textWords = 0;
+  int dataWords = 0;
+  for(size_t i = 0; i < objs.size(); ++i)
+  {
+    textBase[i] = textWords;
+    textWords += objs[i].text.size();
+  }
+  for(size_t i = 0; i < objs.size(); ++i)
+  {
+    dataBase[i] = textWords + dataWords;
+    dataWords += objs[i].data.size() + objs[i].zeroWords;
+  }
+
+  // final addresses of every defined symbol, and the global ones
+  // by name
+  int errors = 0;
+  SymbolTable globals;
+  std::vector<std::vector<int> > address(objs.size());
+  out = Object();
+  for(size_t i = 0; i < objs.size(); ++i)
+  {
+    address[i].resize(objs[i].symbols.size(), -1);
+    for(size_t k = 0; k < objs[i].symbols.size(); ++k)
+    {
+      const ObjSymbol &sym = objs[i].symbols[k];
+      if(sym.section == SECTION_UNDEFINED)
+        continue;
+      address[i][k] = sym.value
+        + (sym.section == SECTION_TEXT ? textBase[i] : dataBase[i]);
+
+      ObjSymbol linked = sym;
+      linked.value = address[i][k]
+        - (sym.section == SECTION_DATA ? textWords : 0);
+      out.symbols.push_back(linked);
+
+      if(sym.global && !globals.Define(sym.name, address[i][k], names[i]))
+      {
+        std::cerr << "error: symbol '" << sym.name << "' defined in both '"
+                  << globals[globals.Intern(sym.name)].definedBy
+                  << "' and '" << names[i] << "'" << std::endl;
+        ++errors;
+      }
+    }
+    out.text.insert(out.text.end(), objs[i].text.begin(),
+                    objs[i].text.end());
+  }
+  for(size_t i = 0; i < objs.size(); ++i)
+  {
+    out.data.resize(out.data.size() + out.zeroWords, 0);
+    out.data.insert(out.data.end(), objs[i].data.begin(),
+                    objs[i].data.end());
+    out.zeroWords = objs[i].zeroWords;
+  }
+
+  for(size_t i = 0; i < objs.size(); ++i)
+  {
+    for(size_t k = 0; k < objs[i].relocations.size(); ++k)
+    {
+      const Relocation &r = objs[i].relocations[k];
+      const std::string &name = objs[i].symbols[r.symbol].name;
+      int target = address[i][r.symbol];
+      if(target < 0)
+      {
+        int id = globals.Use(name, names[i]);
+        if(id >= 0)
+          target = globals[id].address;
+      }
+      if(target < 0)
+        continue;
+
+      int pc = textBase[i] + r.offset;
+      bool inRange;
+      int bits = LabelValue(r.use, target, pc, textWords, inRange);
+      out.text[pc] = (out.text[pc] & ~LabelMask(r.use)) | bits;
+      if(!inRange)
+      {
+        std::cerr << "error: symbol '" << name << "' out of range in '"
+                  << names[i] << "'" << std::endl;
+        ++errors;
+      }
+    }
+  }
+  return errors + globals.ReportUndefined(std::cerr);
+}
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ *	@file 		onepass.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Single pass assembler.
+ *
+ *	@section 	DESCRIPTION
+ * 	OnePass takes the source a line at a time as it is read
+ *      and encodes it straight into one growable array of
+ *      words, text first and data after it. A label used
+ *      before it is defined leaves its field zero and a fixup
+ *      that Finish patches, so nothing of the source is kept
+ *      and memory grows with the output, not the input. Uses
+ *      of a label's address are always patched by Finish, so
+ *      a relocatable assembler keeps its fixups afterwards as
+ *      the relocations of an object file (see object.h).
+ *
+ *      Zero words reserved by .space are only counted until
+ *      more data follows them, so the zeros at the end of the
+ *      data, usually the big arrays, are never held at all.
+ **********************************************************/
+
+#ifndef ONEPASS_H
+#define ONEPASS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "passes.h"
+
+class OnePass
+{
+public:
+
+  // constructor. A relocatable assembler allows labels defined in
+  // other files and keeps its fixups
+  OnePass(bool relocatable = false)
+    : _relocatable(relocatable), _inData(false), _errors(0), _zeroWords(0)
+  {
+  }
+
+  // assembles one cleaned source line
+  void Line(const std::string &line)
+  {
+    SplitStatement(line, _tok);
+    if(_tok.empty())
+      return;
+
+    if(_tok[0] == ".data")
+    {
+      _inData = true;
+      _addressTable.SetDataStart(_code.size());
+      return;
+    }
+    if(_tok[0] == ".globl" || _tok[0] == ".global")
+    {
+      for(size_t i = 1; i < _tok.size(); ++i)
+        _addressTable.Export(_tok[i]);
+      return;
+    }
+    if(_tok[0] == ".text")
+    {
+      if(_inData)
+      {
+        std::cerr << "error: .text after .data in '" << line << "'"
+                  << std::endl;
+        ++_errors;
+      }
+      return;
+    }
+
+    if(_inData)
+      Data(line);
+    else
+      Text(line);
+  }
+
+  // patches every fixup and reports labels that were never
+  // defined, returns the number of errors found. A relocatable
+  // assembler leaves undefined labels for the linker
+  int Finish()
+  {
+    if(_addressTable.DataStart() < 0)
+      _addressTable.SetDataStart(_code.size());
+
+    for(size_t i = 0; i < _fixups.size(); ++i)
+    {
+      const Fixup &f = _fixups[i];
+      const Symbol &sym = _addressTable[f.symbol];
+      if(!sym.defined)
+        continue;
+      bool inRange;
+      _code[f.pc] |= LabelValue(f.use, sym.address, f.pc,
+                                _addressTable.DataStart(), inRange);
+      if(!inRange)
+      {
+        std::cerr << "error: label '" << _addressTable.Name(f.symbol)
+                  << "' out of range in '" << f.stmt << "'" << std::endl;
+        ++_errors;
+      }
+    }
+    if(_relocatable)
+      return _errors;
+    std::vector<Fixup>().swap(_fixups);
+    return _errors + _addressTable.ReportUndefined(std::cerr);
+  }
+
+  // text words followed by data words, then ZeroWords zero words
+  // that are not held
+  const std::vector<int> &Code() const {return _code;}
+  size_t ZeroWords() const {return _zeroWords;}
+  SymbolTable &Symbols() {return _addressTable;}
+  const std::vector<Fixup> &Fixups() const {return _fixups;}
+
+private:
+  // a label, or an instruction and whatever it expands to
+  void Text(const std::string &line)
+  {
+    size_t colon = LabelColon(line);
+    if(colon != std::string::npos)
+    {
+      _errors += DefineLabel(_addressTable, line.substr(0, colon),
+                             _code.size(), line);
+      return;
+    }
+    if(_tok[0][0] == '.')
+      return;
+
+    if(ExpandStatement(_tok, line, _expanded, _errors))
+    {
+      for(size_t i = 0; i < _expanded.size(); ++i)
+      {
+        SplitStatement(_expanded[i], _sub);
+        _code.push_back(EncodeStatement(_sub, _addressTable, _code.size(),
+                                        line, _errors, &_fixups));
+      }
+    }
+    else
+      _code.push_back(EncodeStatement(_tok, _addressTable, _code.size(),
+                                      line, _errors, &_fixups));
+  }
+
+  // label: .word n, ... or label: .space n
+  void Data(const std::string &line)
+  {
+    size_t colon = LabelColon(line);
+    if(_tok[0][0] == '.' && colon == std::string::npos)
+      return;
+
+    std::string label = line.substr(0, colon);
+    _errors += DefineLabel(_addressTable, label, _code.size() + _zeroWords,
+                           line);
+    _addressTable[_addressTable.Intern(label)].inData = true;
+
+    // the directive follows the colon
+    std::string rest = line.substr(colon + 1);
+    SplitStatement(rest, _tok);
+    if(_tok.empty() || !DataValuesOk(_tok, line, _errors))
+      return;
+    if(_tok[0] == ".word")
+    {
+      // zeros reserved before are held once words follow them
+      _code.resize(_code.size() + _zeroWords, 0);
+      _zeroWords = 0;
+      for(size_t i = 1; i < _tok.size(); ++i)
+        _code.push_back(NumberValue(_tok[i]));
+    }
+    else if(_tok[0] == ".space" && _tok.size() > 1)
+      _zeroWords += NumberValue(_tok[1]);
+  }
+
+  bool _relocatable;
+  bool _inData;
+  int _errors;
+  size_t _zeroWords;        // .space words past the end of _code
+  SymbolTable _addressTable;
+  std::vector<int> _code;
+  std::vector<Fixup> _fixups;
+  std::vector<std::string> _tok;
+  std::vector<std::string> _expanded;
+  std::vector<std::string> _sub;
+};
+
+#endif
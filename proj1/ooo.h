@@ -0,0 +1,577 @@
+/**
+ *	@file 		ooo.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Out of order superscalar timing model.
+ *
+ *	@section 	DESCRIPTION
+ * 	OutOfOrder estimates the cycles a program takes on a wide
+ *      out of order core. Like Pipeline it is a RefSink that
+ *      times the instructions the interpreter runs, in the
+ *      order they run, from their fetches, and a load or store
+ *      is timed once its data reference gives its address.
+ *
+ *      Nothing is polled cycle by cycle. Each instruction is
+ *      scheduled once, in program order, from the events it
+ *      waits on: its fetch cycle, which a fetch group of fetch
+ *      width, a taken jump or a mispredicted branch ends; its
+ *      dispatch, held back by a full ROB, reservation stations
+ *      or load/store queue until the entry it needs is freed;
+ *      its issue, the first cycle its operands are ready with a
+ *      free issue slot, memory port or multiply/divide unit; its
+ *      completion after its latency; and its commit, in order,
+ *      commit width a cycle. Registers are renamed, so only
+ *      true dependences wait, through one ready cycle per
+ *      architectural register and one for HI/LO. The ROB and
+ *      load/store queue are rings of commit cycles, the
+ *      reservation stations a heap of issue cycles, and issue
+ *      slots a calendar of the cycles ahead, so each
+ *      instruction costs a few table updates however wide the
+ *      core and 10^8 instructions take a minute or so.
+ *
+ *      Conditional branches are predicted by gshare (see
+ *      predict.h), returns by a return address stack; any other
+ *      jr is mispredicted. A mispredicted branch fetches again
+ *      the redirect penalty after it completes. Loads take the
+ *      hit or miss latency of the cache simulator's Cache, or
+ *      a cycle when an older store to the same word has not
+ *      committed and forwards its data. The config file holds,
+ *      as whitespace separated numbers:
+ *
+ *        fetch width, issue width, commit width
+ *        ROB, reservation station and load/store queue entries
+ *        memory ports
+ *        frontend depth (fetch to dispatch), redirect penalty
+ *        load hit, miss, mult and div latencies in cycles
+ *        gshare table bits
+ *        cache set size, line size and total size, as in proj2
+ **********************************************************/
+
+#ifndef OOO_H
+#define OOO_H
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include "interp.h"
+#include "predict.h"
+#include "../proj2/cache.h"
+
+struct OutOfOrderConfig
+{
+  int fetchWidth;
+  int issueWidth;
+  int commitWidth;
+  int robEntries;
+  int rsEntries;
+  int lsqEntries;
+  int memPorts;
+  int frontendDepth;
+  int redirectPenalty;
+  int hitLatency;
+  int missLatency;
+  int multLatency;
+  int divLatency;
+  int predictorBits;
+  int cacheSetSize;
+  int cacheLineSize;
+  int cacheSize;
+};
+
+// reads an out of order config file, false if it is not one
+inline bool ReadOutOfOrderConfig(const char *name, OutOfOrderConfig &c)
+{
+  std::ifstream in(name);
+  if(!(in >> c.fetchWidth >> c.issueWidth >> c.commitWidth >> c.robEntries
+       >> c.rsEntries >> c.lsqEntries >> c.memPorts >> c.frontendDepth
+       >> c.redirectPenalty >> c.hitLatency >> c.missLatency
+       >> c.multLatency >> c.divLatency >> c.predictorBits
+       >> c.cacheSetSize >> c.cacheLineSize >> c.cacheSize))
+    return false;
+  int line = c.cacheLineSize;
+  return c.fetchWidth > 0 && c.issueWidth > 0 && c.issueWidth < 256
+    && c.commitWidth > 0 && c.robEntries > 0 && c.rsEntries > 0
+    && c.lsqEntries > 0 && c.memPorts > 0 && c.memPorts < 256
+    && c.frontendDepth >= 0 && c.redirectPenalty >= 0
+    && c.hitLatency > 0 && c.missLatency >= c.hitLatency
+    && c.multLatency > 0 && c.divLatency > 0
+    && c.predictorBits > 0 && c.predictorBits <= 24
+    && c.cacheSetSize > 0 && (line == 4 || line == 8 || line == 16
+                              || line == 32)
+    && c.cacheSize >= c.cacheSetSize * line
+    && c.cacheSize % (c.cacheSetSize * line) == 0;
+}
+
+// why dispatch waited
+enum DispatchStall
+{
+  DISPATCH_ROB,             // the ROB was full
+  DISPATCH_RS,              // every reservation station was taken
+  DISPATCH_LSQ,             // the load/store queue was full
+  DISPATCH_STALLS
+};
+
+const char *const DISPATCH_STALL_NAMES[DISPATCH_STALLS] =
+{
+  "ROB full", "RS full", "LSQ full"
+};
+
+// entries of the return address stack
+const int RETURN_STACK = 16;
+// in flight stores remembered for forwarding, by word address
+const int STORE_TABLE_BITS = 12;
+
+class OutOfOrder : public RefSink
+{
+public:
+
+  // constructor, times the text of a loaded program
+  OutOfOrder(const std::vector<int> &code, int textWords,
+             const OutOfOrderConfig &config)
+    : _config(config), _info(textWords), _predictor(config.predictorBits),
+      _cache(config.cacheSetSize, config.cacheLineSize, config.cacheSize),
+      _robCommit(config.robEntries, 0), _lsqCommit(config.lsqEntries, 0),
+      _stores(1u << STORE_TABLE_BITS), _last(-1), _dataNext(false),
+      _pending(0), _lastComplete(0), _fetchCycle(0), _fetched(0),
+      _dispatchCycle(0), _dispatched(0), _commitCycle(0), _committed(0),
+      _instructions(0), _memOps(0), _branches(0), _mispredicts(0), _returns(0),
+      _returnMisses(0), _loads(0), _forwarded(0), _misses(0)
+  {
+    for(int pc = 0; pc < textWords; ++pc)
+      _info[pc] = Classify(DecodeWord(code[pc], pc, textWords));
+    for(int r = 0; r < REG_HILO + 1; ++r)
+      _ready[r] = 0;
+    for(int k = 0; k < DISPATCH_STALLS; ++k)
+      _stalls[k] = 0;
+    StoreEntry none = {0, 0, 0};
+    std::fill(_stores.begin(), _stores.end(), none);
+
+    // the calendar reaches as far past dispatch as a ROB of
+    // dependent misses and divides can issue
+    int longest = std::max(config.missLatency, config.divLatency);
+    size_t reach = (size_t)(config.robEntries + config.fetchWidth)
+      * (longest + 2) * 4;
+    size_t slots = 1024;
+    while(slots < reach)
+      slots <<= 1;
+    Slot free = {-1, 0, 0, false};
+    _calendar.assign(slots, free);
+  }
+
+  void Refs(const MemRef *refs, size_t count)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      // a load or store's data reference follows its fetch
+      if(_dataNext)
+      {
+        _dataNext = false;
+        Schedule(_pending, refs[i].address);
+      }
+      else
+      {
+        int pc = refs[i].address / 4;
+        if(pc < 0 || pc >= (int)_info.size())
+          continue;
+        int kind = _info[pc].kind;
+        if(kind == KIND_LOAD || kind == KIND_STORE)
+        {
+          _dataNext = true;
+          _pending = pc;
+        }
+        else
+          Schedule(pc, 0);
+      }
+    }
+  }
+
+  unsigned long long Instructions() const {return _instructions;}
+  // cycles until the last instruction commits
+  unsigned long long Cycles() const {return _commitCycle;}
+
+  void Report(std::ostream &out) const
+  {
+    const OutOfOrderConfig &c = _config;
+    out << "Width:\t\t" << c.fetchWidth << " fetch, " << c.issueWidth
+        << " issue, " << c.commitWidth << " commit" << std::endl
+        << "Window:\t\t" << c.robEntries << " ROB, " << c.rsEntries
+        << " RS, " << c.lsqEntries << " LSQ, " << c.memPorts
+        << " memory ports" << std::endl
+        << "Instructions:\t" << _instructions << std::endl
+        << "Cycles:\t\t" << Cycles() << std::endl << "IPC:\t\t"
+        << std::fixed << std::setprecision(3)
+        << (Cycles() ? (double)_instructions / Cycles() : 0) << std::endl
+        << "Dispatch stalls:" << std::endl;
+    for(int k = 0; k < DISPATCH_STALLS; ++k)
+      out << "  " << std::left << std::setw(14) << DISPATCH_STALL_NAMES[k]
+          << std::right << _stalls[k] << std::endl;
+    out << "Branches:\t" << _branches << ", " << _mispredicts
+        << " mispredicted (" << std::setprecision(2)
+        << (_branches ? 100.0 * _mispredicts / _branches : 0) << "%)"
+        << std::endl << "Returns:\t" << _returns << ", " << _returnMisses
+        << " mispredicted" << std::endl << "Loads:\t\t" << _loads << ", "
+        << _forwarded << " forwarded, " << _misses << " cache misses"
+        << std::endl;
+  }
+
+private:
+  OutOfOrder(const OutOfOrder &);
+  OutOfOrder &operator=(const OutOfOrder &);
+
+  enum Kind
+  {
+    KIND_ALU,
+    KIND_LOAD,
+    KIND_STORE,
+    KIND_BRANCH,            // conditional, predicted
+    KIND_JUMP,              // j and jal, always found
+    KIND_JUMP_REG,          // jr and jalr
+    KIND_MULT,              // mult and div family, writes HI/LO
+    KIND_DIV,
+    KIND_MUL                // mul, writes a register
+  };
+
+  // HI and LO renamed together, past the sink
+  enum {REG_HILO = REG_SINK + 1};
+
+  struct Info
+  {
+    unsigned char kind;
+    unsigned char src1;     // registers read, REG_SINK for none
+    unsigned char src2;
+    unsigned char src3;     // REG_HILO if HI/LO is read
+    unsigned char dest;     // register written, REG_SINK for none
+    bool links;             // writes the return address
+    bool returns;           // jr $ra
+  };
+
+  // what issued in one cycle
+  struct Slot
+  {
+    long long cycle;
+    unsigned char issued;
+    unsigned char memory;
+    bool unit;              // the multiply/divide unit is taken
+  };
+
+  struct StoreEntry
+  {
+    unsigned int address;
+    long long ready;        // when its data can be forwarded
+    long long commit;       // when it leaves the store queue
+  };
+
+  Info Classify(const Decoded &d) const
+  {
+    Info info = {KIND_ALU, REG_SINK, REG_SINK, REG_SINK, d.rd, false,
+                 false};
+    if(d.op >= OP_END)
+      return info;
+    const InstrDesc &desc = INSTRUCTIONS[d.op];
+    bool store = (desc.opcode >= 40 && desc.opcode <= 46)
+      || desc.opcode == 56;
+    for(int k = 0; k < 3; ++k)
+    {
+      if(desc.operands[k] == RS || desc.operands[k] == MEM)
+        info.src1 = d.rs ? d.rs : (unsigned char)REG_SINK;
+      if(desc.operands[k] == RT && (k > 0 || store))
+        info.src2 = d.rt ? d.rt : (unsigned char)REG_SINK;
+    }
+
+    std::string name = desc.name;
+    int target;
+    if(store)
+      info.kind = KIND_STORE;
+    else if((desc.opcode >= 32 && desc.opcode <= 38) || desc.opcode == 48)
+      info.kind = KIND_LOAD;
+    else if(name == "jr" || name == "jalr")
+    {
+      info.kind = KIND_JUMP_REG;
+      info.returns = name == "jr" && d.rs == REG_RA;
+    }
+    else if(LabelTarget(desc, 0, 0, target))
+      info.kind = desc.format == J_TYPE ? KIND_JUMP : KIND_BRANCH;
+    else if(name == "mfhi" || name == "mflo")
+      info.src3 = REG_HILO;
+    else if(name == "mthi" || name == "mtlo")
+      info.dest = REG_HILO;
+    else if(name == "mul")
+      info.kind = KIND_MUL;
+    else if(name == "mult" || name == "multu" || name == "madd"
+            || name == "maddu" || name == "msub" || name == "msubu")
+    {
+      info.kind = KIND_MULT;
+      info.dest = REG_HILO;
+      if(name[0] == 'm' && name[1] != 'u')
+        info.src3 = REG_HILO;
+    }
+    else if(name == "div" || name == "divu")
+    {
+      info.kind = KIND_DIV;
+      info.dest = REG_HILO;
+    }
+    if(name == "jal" || name == "jalr" || name.find("zal") != std::string::npos)
+    {
+      info.links = true;
+      if(name != "jalr")
+        info.dest = REG_RA;
+    }
+    return info;
+  }
+
+  // the calendar slot of a cycle, cleared if it last held an
+  // older one
+  Slot &At(long long cycle)
+  {
+    Slot &s = _calendar[cycle & (_calendar.size() - 1)];
+    if(s.cycle != cycle)
+    {
+      s.cycle = cycle;
+      s.issued = 0;
+      s.memory = 0;
+      s.unit = false;
+    }
+    return s;
+  }
+
+  // the first cycle from ready that an instruction of a kind can
+  // issue in, taken for it
+  long long Issue(long long ready, int kind)
+  {
+    bool memory = kind == KIND_LOAD || kind == KIND_STORE;
+    bool unit = kind == KIND_MULT || kind == KIND_DIV || kind == KIND_MUL;
+    // a divide holds the unit for its latency, the rest are
+    // pipelined
+    int busy = kind == KIND_DIV ? _config.divLatency : 1;
+    for(long long cycle = ready; ; ++cycle)
+    {
+      Slot &s = At(cycle);
+      if(s.issued >= _config.issueWidth
+         || (memory && s.memory >= _config.memPorts))
+        continue;
+      if(unit)
+      {
+        int k = 0;
+        while(k < busy && !At(cycle + k).unit)
+          ++k;
+        if(k < busy)
+          continue;
+        for(k = 0; k < busy; ++k)
+          At(cycle + k).unit = true;
+      }
+      Slot &taken = At(cycle);
+      ++taken.issued;
+      taken.memory += memory;
+      return cycle;
+    }
+  }
+
+  // how the instruction before pc left it: true if the fetch of
+  // pc had to wait for it to resolve, and whether it ended its
+  // fetch group
+  bool Resolve(int pc, bool &endsGroup)
+  {
+    endsGroup = false;
+    if(_last < 0)
+      return false;
+    const Info &prev = _info[_last];
+    bool taken = pc != _last + 1;
+    if(prev.links && taken)
+    {
+      if(_returnStack.size() == (size_t)RETURN_STACK)
+        _returnStack.erase(_returnStack.begin());
+      _returnStack.push_back(_last + 1);
+    }
+
+    if(prev.kind == KIND_BRANCH)
+    {
+      BranchOutcome b = {(unsigned int)_last * 4, (unsigned int)pc * 4,
+                         taken};
+      bool guess = _predictor.Predict(b);
+      _predictor.Update(b, guess);
+      ++_branches;
+      endsGroup = taken;
+      if(guess != taken)
+      {
+        ++_mispredicts;
+        return true;
+      }
+    }
+    else if(prev.kind == KIND_JUMP)
+      endsGroup = true;
+    else if(prev.kind == KIND_JUMP_REG)
+    {
+      endsGroup = true;
+      if(!prev.returns)
+        return true;
+      ++_returns;
+      int guess = -1;
+      if(!_returnStack.empty())
+      {
+        guess = _returnStack.back();
+        _returnStack.pop_back();
+      }
+      if(guess != pc)
+      {
+        ++_returnMisses;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // times one instruction at pc, address is its data reference
+  void Schedule(int pc, unsigned int address)
+  {
+    const Info &info = _info[pc];
+    const OutOfOrderConfig &c = _config;
+
+    // fetch
+    bool endsGroup;
+    long long fetch = _fetchCycle;
+    if(Resolve(pc, endsGroup))
+      fetch = std::max(_fetchCycle + 1, _lastComplete + c.redirectPenalty);
+    else if(endsGroup || _fetched == c.fetchWidth)
+      fetch = _fetchCycle + 1;
+    if(fetch != _fetchCycle)
+    {
+      _fetchCycle = fetch;
+      _fetched = 0;
+    }
+    ++_fetched;
+
+    // dispatch, in order, into the ROB, a reservation station and
+    // for loads and stores the load/store queue
+    bool memory = info.kind == KIND_LOAD || info.kind == KIND_STORE;
+    long long dispatch = std::max(fetch + c.frontendDepth, _dispatchCycle);
+    if(dispatch == _dispatchCycle && _dispatched == c.fetchWidth)
+      ++dispatch;
+    Wait(dispatch, _robCommit[_instructions % c.robEntries], DISPATCH_ROB);
+    if(memory)
+      Wait(dispatch, _lsqCommit[_memOps % c.lsqEntries], DISPATCH_LSQ);
+    while(!_rs.empty() && _rs.top() < dispatch)
+      _rs.pop();
+    if(_rs.size() >= (size_t)c.rsEntries)
+    {
+      Wait(dispatch, _rs.top() + 1, DISPATCH_RS);
+      while(!_rs.empty() && _rs.top() < dispatch)
+        _rs.pop();
+    }
+    if(dispatch != _dispatchCycle)
+    {
+      _dispatchCycle = dispatch;
+      _dispatched = 0;
+    }
+    ++_dispatched;
+
+    // issue once the renamed operands are ready
+    long long ready = std::max(dispatch + 1,
+                               std::max(_ready[info.src1], _ready[info.src2]));
+    ready = std::max(ready, _ready[info.src3]);
+    int latency = 1;
+    StoreEntry &older = _stores[(address >> 2) & ((1u << STORE_TABLE_BITS)
+                                                  - 1)];
+    if(info.kind == KIND_LOAD)
+    {
+      ++_loads;
+      if(older.commit > ready && older.address >> 2 == address >> 2)
+      {
+        ++_forwarded;
+        ready = std::max(ready, older.ready);
+      }
+      else if(_cache.Read(_cache.GetIndex(address),
+                          _cache.GetTag(address))[0] == 'H')
+        latency = c.hitLatency;
+      else
+      {
+        ++_misses;
+        latency = c.missLatency;
+      }
+    }
+    else if(info.kind == KIND_MULT || info.kind == KIND_MUL)
+      latency = c.multLatency;
+    else if(info.kind == KIND_DIV)
+      latency = c.divLatency;
+    long long issue = Issue(ready, info.kind);
+    long long complete = issue + latency;
+    _rs.push(issue);
+    if(info.dest != REG_SINK)
+      _ready[info.dest] = complete;
+
+    // commit, in order
+    long long commit = std::max(complete + 1, _commitCycle);
+    if(commit == _commitCycle && _committed == c.commitWidth)
+      ++commit;
+    if(commit != _commitCycle)
+    {
+      _commitCycle = commit;
+      _committed = 0;
+    }
+    ++_committed;
+
+    _robCommit[_instructions % c.robEntries] = commit;
+    if(memory)
+      _lsqCommit[_memOps++ % c.lsqEntries] = commit;
+    if(info.kind == KIND_STORE)
+    {
+      _cache.Write(_cache.GetIndex(address), _cache.GetTag(address));
+      older.address = address;
+      older.ready = complete;
+      older.commit = commit;
+    }
+    _lastComplete = complete;
+    _last = pc;
+    ++_instructions;
+  }
+
+  // moves cycle up to free if it is later, counting the wait
+  void Wait(long long &cycle, long long free, DispatchStall why)
+  {
+    if(free > cycle)
+    {
+      _stalls[why] += free - cycle;
+      cycle = free;
+    }
+  }
+
+  OutOfOrderConfig _config;
+  std::vector<Info> _info;
+  Gshare _predictor;
+  Cache _cache;
+  std::vector<int> _returnStack;
+  long long _ready[REG_HILO + 1];   // per renamed register
+  std::vector<long long> _robCommit;
+  std::vector<long long> _lsqCommit;
+  // issue cycles of the instructions in reservation stations
+  std::priority_queue<long long, std::vector<long long>,
+                      std::greater<long long> > _rs;
+  std::vector<Slot> _calendar;
+  std::vector<StoreEntry> _stores;
+  int _last;
+  bool _dataNext;
+  int _pending;             // load or store waiting for its address
+  long long _lastComplete;
+  long long _fetchCycle;
+  int _fetched;             // in the fetch cycle so far
+  long long _dispatchCycle;
+  int _dispatched;
+  long long _commitCycle;
+  int _committed;
+  unsigned long long _instructions;
+  unsigned long long _memOps;
+  unsigned long long _stalls[DISPATCH_STALLS];
+  unsigned long long _branches;
+  unsigned long long _mispredicts;
+  unsigned long long _returns;
+  unsigned long long _returnMisses;
+  unsigned long long _loads;
+  unsigned long long _forwarded;
+  unsigned long long _misses;
+};
+
+#endif
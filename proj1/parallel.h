@@ -0,0 +1,178 @@
+/**
+ *	@file 		parallel.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Pass two on several threads.
+ *
+ *	@section 	DESCRIPTION
+ * 	Once PassOne has placed every label, each statement
+ *      encodes on its own. PassTwoParallel splits the text
+ *      statements into chunks and has a pool of threads size
+ *      them, to find where each chunk's words start, then
+ *      encode them into their slots of one preallocated array.
+ *      The symbol table is frozen while the threads read it.
+ *      The words are the same as PassTwo's; if any statement
+ *      has an error the pass is redone by PassTwo so errors
+ *      are reported in source order.
+ **********************************************************/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include "passes.h"
+
+// token buffers each thread reuses from statement to statement
+struct Scratch
+{
+  std::string expanded;
+  std::vector<Token> sub;
+};
+
+class ParallelPassTwo
+{
+public:
+
+  // constructor, gathers the statements that make text words
+  ParallelPassTwo(const Source &source, SymbolTable &addressTable,
+                  int threads)
+    : _source(source), _addressTable(addressTable), _threads(threads)
+  {
+    for(size_t n = 0; n < source.Lines(); ++n)
+    {
+      if(source.Line(n).kind == LINE_STATEMENT)
+        _lines.push_back(&source.Line(n));
+    }
+
+    // a few chunks per thread so a slow chunk does not hold
+    // the others up
+    size_t chunks = threads * 8;
+    if(chunks > _lines.size())
+      chunks = _lines.size() ? _lines.size() : 1;
+    for(size_t c = 0; c <= chunks; ++c)
+      _bounds.push_back(_lines.size() * c / chunks);
+    _start.resize(chunks + 1);
+    _errors.resize(chunks);
+  }
+
+  // encodes every statement, returns the number of errors
+  int Run(std::vector<int> &words)
+  {
+    _addressTable.Freeze(true);
+    Spread(&ParallelPassTwo::Size);
+    for(size_t c = 0; c + 1 < _start.size(); ++c)
+      _start[c + 1] += _start[c];
+    _words.assign(_start.back(), 0);
+    Spread(&ParallelPassTwo::Encode);
+    _addressTable.Freeze(false);
+
+    int errors = 0;
+    for(size_t c = 0; c < _errors.size(); ++c)
+      errors += _errors[c];
+    words.swap(_words);
+    return errors;
+  }
+
+private:
+  // runs a chunk job on every thread until all chunks are done
+  void Spread(void (ParallelPassTwo::*job)(size_t, Scratch &))
+  {
+    _next = 0;
+    std::vector<std::thread> pool;
+    for(int i = 0; i < _threads; ++i)
+      pool.push_back(std::thread(&ParallelPassTwo::Work, this, job));
+    for(size_t i = 0; i < pool.size(); ++i)
+      pool[i].join();
+  }
+
+  // thread body, errors go to a buffer nobody reads since the
+  // serial pass prints them if there are any
+  void Work(void (ParallelPassTwo::*job)(size_t, Scratch &))
+  {
+    Scratch scratch;
+    std::ostringstream ignored;
+    ErrorStream(&ignored);
+    for(size_t c; (c = _next++) < _errors.size(); )
+      (this->*job)(c, scratch);
+  }
+
+  // counts the words of a chunk into the slot after its own, so
+  // a running sum turns the counts into start addresses
+  void Size(size_t c, Scratch &)
+  {
+    int words = 0;
+    for(size_t i = _bounds[c]; i < _bounds[c + 1]; ++i)
+      words += StatementSize(_source.Tokens(*_lines[i]), _lines[i]->count);
+    _start[c + 1] = words;
+  }
+
+  // encodes a chunk into its words
+  void Encode(size_t c, Scratch &s)
+  {
+    int globalPointer = _start[c];
+    int errors = 0;
+    for(size_t i = _bounds[c]; i < _bounds[c + 1]; ++i)
+    {
+      const SourceLine &line = *_lines[i];
+      const Token *tok = _source.Tokens(line);
+      if(ExpandStatement(tok, line.count, line.text, s.expanded, errors))
+      {
+        for(size_t at = 0; NextStatement(s.expanded, at, s.sub); )
+        {
+          _words[globalPointer] = EncodeStatement(s.sub.data(), s.sub.size(),
+                                                  _addressTable,
+                                                  globalPointer, line.text,
+                                                  errors);
+          ++globalPointer;
+        }
+      }
+      else
+      {
+        _words[globalPointer] = EncodeStatement(tok, line.count,
+                                                _addressTable, globalPointer,
+                                                line.text, errors);
+        ++globalPointer;
+      }
+    }
+    _errors[c] = errors;
+  }
+
+  const Source &_source;
+  SymbolTable &_addressTable;
+  int _threads;
+  std::vector<const SourceLine *> _lines;
+  std::vector<size_t> _bounds;
+  std::vector<int> _start;
+  std::vector<int> _errors;
+  std::vector<int> _words;
+  std::atomic<size_t> _next;
+};
+
+// pass two on the given number of threads, the same words and
+// errors as PassTwo
+inline int PassTwoParallel(const Source &source, SymbolTable &addressTable,
+                           std::vector<machine> &machineCode, int threads)
+{
+  if(threads <= 1)
+    return PassTwo(source, addressTable, machineCode);
+
+  std::vector<int> words;
+  ParallelPassTwo pass(source, addressTable, threads);
+  if(pass.Run(words))
+    return PassTwo(source, addressTable, machineCode);
+
+  std::vector<machine> text(words.size());
+  for(size_t i = 0; i < words.size(); ++i)
+  {
+    text[i].address = i + 1;
+    text[i].machineCode = words[i];
+  }
+  machineCode.insert(machineCode.begin(), text.begin(), text.end());
+  return 0;
+}
+
+#endif
@@ -0,0 +1,531 @@
+/**
+ *	@file 		passes.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		The two passes of the assembler.
+ *
+ *	@section 	DESCRIPTION
+ * 	PassOne, PassTwo and their helpers, pulled out of
+ *      wbe14b.pr01.cpp so other tools can assemble too. Both
+ *      passes walk the tokens of one lexed Source (see lexer.h)
+ *      and encode straight from them; the overloads that take
+ *      strings are for the front ends that still split lines.
+ **********************************************************/
+
+#ifndef PASSES_H
+#define PASSES_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <climits>
+#include "symtab.h"
+#include "isa.h"
+#include "pseudo.h"
+
+// used for setting up machine code
+struct machine
+{
+  int address;
+  int machineCode;
+};
+
+// the ways a label can be used as an operand
+enum LabelUse
+{
+  USE_BRANCH,       // word offset from pc + 1
+  USE_TARGET,       // 26 bit word address
+  USE_GP,           // byte offset from the data section, off $gp
+  USE_ABS16,        // byte address, must fit in 16 bits
+  USE_HI,           // upper half of the byte address
+  USE_HA,           // upper half rounded for a signed lower half
+  USE_LO            // lower half of the byte address
+};
+
+// a label operand whose value was not known when its word was
+// encoded, patched once the label is defined
+struct Fixup
+{
+  int pc;                   // word address of the instruction
+  int symbol;               // label id in the address table
+  LabelUse use;
+  std::string stmt;         // statement, for errors
+};
+
+int EncodeStatement(const Token *, int, SymbolTable &, int, const Token &,
+                    int &, std::vector<Fixup> * = NULL);
+
+// puts a label in the address table, reporting it and
+// returning 1 if it was already there
+inline int DefineLabel(SymbolTable &addressTable, const Token &name,
+                       int address, const Token &stmt)
+{
+  if(addressTable.Define(name.text, name.length, address, stmt.text,
+                         stmt.length))
+    return 0;
+  std::cerr << "error: duplicate label '" << name << "' in '" << stmt
+            << "', first defined by '"
+            << addressTable[addressTable.Intern(name.text, name.length)]
+               .definedBy << "'" << std::endl;
+  return 1;
+}
+
+inline int DefineLabel(SymbolTable &addressTable, const std::string &name,
+                       int address, const std::string &stmt)
+{
+  return DefineLabel(addressTable, MakeToken(name), address,
+                     MakeToken(stmt));
+}
+
+// checks the values of a .word or the count of a .space, the
+// count tokens of tok starting at the directive, reporting any that
+// is not a number or does not fit a word. Returns false if the line
+// should be skipped
+inline bool DataValuesOk(const Token *tok, int count, const Token &stmt,
+                         int &errors)
+{
+  bool space = TokenIs(tok[0], ".space");
+  bool ok = true;
+  for(int i = 1; i < count && (i == 1 || !space); ++i)
+  {
+    long long v;
+    if(ParseNumber(tok[i], v)
+       && (space ? v >= 0 && v <= INT_MAX : v >= INT_MIN && v <= UINT_MAX))
+      continue;
+    ErrorStream() << "error: bad " << (space ? ".space count" : ".word value")
+                  << " '" << tok[i] << "' in '" << stmt << "'" << std::endl;
+    ++errors;
+    ok = false;
+  }
+  return ok;
+}
+
+inline bool DataValuesOk(const std::vector<std::string> &tok,
+                         const std::string &stmt, int &errors)
+{
+  return DataValuesOk(TokensOf(tok), tok.size(), MakeToken(stmt), errors);
+}
+
+// in pass one we will find all the labels and 
+// assign any data to their places in memory, returns
+// the number of errors found
+inline int PassOne(const Source &source, SymbolTable &addressTable,
+                   std::vector<machine> &machineCode)
+{
+  int globalPointer = 0;
+  int errors = 0;
+  machine mc;
+	 
+  // in the .text section we will iterate through each line of 
+  // code and see if it is a label, if so put it in the 
+  // label table, otherwise count the words it assembles to
+  size_t n = 0;
+  for(; n < source.Lines(); ++n)
+  {
+    const SourceLine &line = source.Line(n);
+    const Token *tok = source.Tokens(line);
+
+    // .text and other directives take no space
+    if(line.kind == LINE_DIRECTIVE)
+    {
+      if(line.count == 1 && TokenIs(tok[0], ".data"))
+        break;
+      continue;
+    }
+		
+    // a label goes into the address table
+    if(line.kind == LINE_LABEL)
+    {
+      errors += DefineLabel(addressTable, tok[0], globalPointer, line.text);
+      continue;
+    }
+    globalPointer += StatementSize(tok, line.count);
+  }
+  addressTable.SetDataStart(globalPointer);
+
+  // we will iterate through the .data section and place 
+  // labels in the address table and the words we want placed 
+  // in memory will be put into the machine code
+  for(; n < source.Lines(); ++n)
+  {
+    const SourceLine &line = source.Line(n);
+    const Token *tok = source.Tokens(line);
+
+    // if the line is .data or another directive move to the
+    // next line of code
+    if(line.kind == LINE_DIRECTIVE || !line.count)
+      continue;
+		
+    // put the label name and address in the label table
+    errors += DefineLabel(addressTable, tok[0], globalPointer, line.text);
+    addressTable[addressTable.Intern(tok[0].text, tok[0].length)].inData
+      = true;
+    if(line.count < 2
+       || !DataValuesOk(tok + 1, line.count - 1, line.text, errors))
+      continue;
+    
+    // if .word we will put the next items into memory at the 
+    // current address, we have given the option to list words
+    // in 1 line
+    if(TokenIs(tok[1], ".word"))
+    {
+      for(int t = 2; t < line.count; ++t)
+      {
+        mc.address = globalPointer;
+        mc.machineCode = NumberValue(tok[t]);
+        machineCode.push_back(mc);
+        ++globalPointer;
+      }
+    }
+    
+    // if the word is .space we will place n sets of 0 on the 
+    // back of the machine code
+    else if(TokenIs(tok[1], ".space") && line.count > 2)
+    {
+      for(int x = NumberValue(tok[2]); x > 0; --x)
+      {
+        mc.address = globalPointer;
+        mc.machineCode = 0;
+        machineCode.push_back(mc);
+        ++globalPointer;
+      }
+    }
+  }
+  return errors;
+}
+ 
+// in pass two we will generate the machine code for every 
+// line of code, ahead of the data pass one left, and returns
+// the number of errors found
+inline int PassTwo(const Source &source, SymbolTable &addressTable,
+                   std::vector<machine> &machineCode)
+{
+  int globalPointer = 0;
+  int errors = 0;
+  std::vector<machine> text;
+  std::string expanded;
+  std::vector<Token> sub;
+
+  // begin stepping through code
+  for(size_t n = 0; n < source.Lines(); ++n)
+  {
+    const SourceLine &line = source.Line(n);
+    machine code;
+    
+    // skip .text, .data, other directives and labels
+    if(line.kind != LINE_STATEMENT)
+      continue;
+
+    // a pseudo-instruction becomes one word per real statement
+    // it expands to, anything else is one word
+    const Token *tok = source.Tokens(line);
+    if(ExpandStatement(tok, line.count, line.text, expanded, errors))
+    {
+      for(size_t at = 0; NextStatement(expanded, at, sub); )
+      {
+        code.machineCode = EncodeStatement(sub.data(), sub.size(),
+                                           addressTable, globalPointer,
+                                           line.text, errors);
+        code.address = ++globalPointer;
+        text.push_back(code);
+      }
+    }
+    else
+    {
+      code.machineCode = EncodeStatement(tok, line.count, addressTable,
+                                         globalPointer, line.text, errors);
+      code.address = ++globalPointer;
+      text.push_back(code);
+    }
+  }
+  machineCode.insert(machineCode.begin(), text.begin(), text.end());
+
+  // any label that was used but never defined is an error
+  return errors + addressTable.ReportUndefined(std::cerr);
+}
+ 
+// reads a register operand, reporting it if it is not one
+inline int OperandRegister(const Token &s, const Token &stmt, int &errors)
+{
+  int r = FindRegister(s.text, s.length);
+  if(r >= 0)
+    return r;
+  ErrorStream() << "error: unknown register '" << s << "' in '" << stmt
+                << "'" << std::endl;
+  ++errors;
+  return 0;
+}
+
+// the bits a label use puts in an instruction, inRange is
+// cleared if the value does not fit its field
+inline int LabelValue(LabelUse use, int address, int pc, int dataStart,
+                      bool &inRange)
+{
+  int bytes = address * 4;
+  inRange = true;
+  switch(use)
+  {
+  case USE_BRANCH:
+    inRange = address - pc - 1 >= -32768 && address - pc - 1 <= 32767;
+    // masking the first 16 bits in case of negative offset
+    return 0xFFFF & (address - pc - 1);
+  case USE_TARGET:
+    return address & 0x3FFFFFF;
+  case USE_GP:
+    bytes = (address - dataStart) * 4;
+    // fall through
+  case USE_ABS16:
+    inRange = bytes >= -32768 && bytes <= 32767;
+    return 0xFFFF & bytes;
+  case USE_HI:
+    return (unsigned int)bytes >> 16;
+  case USE_HA:
+    return ((unsigned int)bytes + 0x8000) >> 16;
+  default:
+    return 0xFFFF & bytes;
+  }
+}
+
+// the bits of an instruction a label use fills in
+inline int LabelMask(LabelUse use)
+{
+  return use == USE_TARGET ? 0x3FFFFFF : 0xFFFF;
+}
+
+// the bits for a label operand. With a fixup list only a branch
+// to a label already defined is filled in, since its offset does
+// not depend on where the code ends up; every other use is left
+// as zero and added to fixups. Without one a label that is not
+// defined is an undefined label
+inline int LabelField(const Token &label, LabelUse use,
+                      SymbolTable &addressTable, int globalPointer,
+                      const Token &stmt, int &errors,
+                      std::vector<Fixup> *fixups)
+{
+  int id = addressTable.Use(label.text, label.length, stmt.text,
+                            stmt.length);
+  if(fixups && (id < 0 || use != USE_BRANCH))
+  {
+    Fixup f = {globalPointer, addressTable.Intern(label.text, label.length),
+               use, TokenString(stmt)};
+    fixups->push_back(f);
+    return 0;
+  }
+  if(id < 0)
+  {
+    // a frozen table cannot remember the use for the report at
+    // the end, so it is counted here
+    if(addressTable.Frozen())
+      ++errors;
+    return 0;
+  }
+
+  bool inRange;
+  int bits = LabelValue(use, addressTable[id].address, globalPointer,
+                        addressTable.DataStart(), inRange);
+  if(!inRange)
+  {
+    ErrorStream() << "error: label '" << label << "' out of range in '"
+                  << stmt << "'" << std::endl;
+    ++errors;
+  }
+  return bits;
+}
+
+// the use named by a hi:, ha: or lo: prefix on a label, with
+// the prefix stripped from label, or fallback if there is none
+inline LabelUse PrefixedUse(Token &label, LabelUse fallback)
+{
+  if(label.length < 4 || label.text[2] != ':')
+    return fallback;
+  LabelUse use = fallback;
+  if(strncmp(label.text, "hi", 2) == 0)
+    use = USE_HI;
+  else if(strncmp(label.text, "ha", 2) == 0)
+    use = USE_HA;
+  else if(strncmp(label.text, "lo", 2) == 0)
+    use = USE_LO;
+  else
+    return fallback;
+  label.text += 3;
+  label.length -= 3;
+  return use;
+}
+
+// reads a number operand for a field of bits bits, a signed one
+// taking -2^(bits-1) to 2^(bits-1)-1 and an unsigned one 0 to
+// 2^bits-1, and returns its bits. One that is not a number or does
+// not fit is reported and gives 0
+inline int NumberField(const Token &t, int bits, bool isSigned,
+                       const Token &stmt, int &errors)
+{
+  long long v;
+  long long low = isSigned ? -(1LL << (bits - 1)) : 0;
+  long long high = isSigned ? (1LL << (bits - 1)) - 1 : (1LL << bits) - 1;
+  bool number = ParseNumber(t, v);
+  if(number && v >= low && v <= high)
+    return (int)(v & ((1LL << bits) - 1));
+  ErrorStream() << "error: " << (number ? "number '" : "bad number '") << t
+                << (number ? "' out of range in '" : "' in '") << stmt << "'"
+                << std::endl;
+  ++errors;
+  return 0;
+}
+
+// true for the logical immediates and lui, whose 16 bits are not
+// sign extended
+inline bool ZeroExtends(const InstrDesc &desc)
+{
+  return desc.opcode >= 12 && desc.opcode <= 15;
+}
+
+// encodes one instruction from its table row, the count tokens
+// of tok hold the mnemonic and the operands as written
+inline int EncodeInstruction(const InstrDesc &desc, const Token *tok,
+                             int count, SymbolTable &addressTable,
+                             int globalPointer, const Token &stmt,
+                             int &errors, std::vector<Fixup> *fixups = NULL)
+{
+  int mc = (desc.opcode << 26) | (desc.rt << 16) | desc.funct;
+  int t = 1;
+
+  for(int k = 0; k < 3 && desc.operands[k] != NONE; ++k, ++t)
+  {
+    if(t >= count)
+    {
+      ErrorStream() << "error: missing operand in '" << stmt << "'"
+                    << std::endl;
+      ++errors;
+      return mc;
+    }
+
+    switch(desc.operands[k])
+    {
+    case RD:
+      mc |= OperandRegister(tok[t], stmt, errors) << 11;
+      break;
+    case RS:
+      mc |= OperandRegister(tok[t], stmt, errors) << 21;
+      break;
+    case RT:
+      mc |= OperandRegister(tok[t], stmt, errors) << 16;
+      break;
+    case RDT:
+    {
+      int r = OperandRegister(tok[t], stmt, errors);
+      mc |= (r << 11) | (r << 16);
+      break;
+    }
+    case SA:
+      mc |= NumberField(tok[t], 5, false, stmt, errors) << 6;
+      break;
+    case HINT:
+      mc |= NumberField(tok[t], 5, false, stmt, errors) << 16;
+      break;
+    case IMM:
+    {
+      // a number, or half of a label's address
+      if(isNumber(tok[t]))
+      {
+        mc |= NumberField(tok[t], 16, !ZeroExtends(desc), stmt, errors);
+        break;
+      }
+      Token label = tok[t];
+      LabelUse use = PrefixedUse(label, USE_ABS16);
+      mc |= LabelField(label, use, addressTable, globalPointer, stmt,
+                       errors, fixups);
+      break;
+    }
+    case BRANCH:
+      mc |= LabelField(tok[t], USE_BRANCH, addressTable, globalPointer,
+                       stmt, errors, fixups);
+      break;
+    case MEM:
+    {
+      // (base) alone is a zero offset
+      int base = FindRegister(tok[t].text, tok[t].length);
+      if(base >= 0)
+      {
+        mc |= base << 21;
+        break;
+      }
+      if(t + 1 >= count)
+      {
+        ErrorStream() << "error: missing base register in '" << stmt
+                      << "'" << std::endl;
+        ++errors;
+        return mc;
+      }
+      base = OperandRegister(tok[t + 1], stmt, errors);
+      mc |= base << 21;
+
+      // a number is used as is, a label off $gp is its byte
+      // offset into the data section and off any other base
+      // its byte address
+      if(isNumber(tok[t]))
+        mc |= NumberField(tok[t], 16, true, stmt, errors);
+      else
+      {
+        Token label = tok[t];
+        LabelUse use = PrefixedUse(label, base == 28 ? USE_GP : USE_ABS16);
+        mc |= LabelField(label, use, addressTable, globalPointer, stmt,
+                         errors, fixups);
+      }
+      ++t;
+      break;
+    }
+    case TARGET:
+      mc |= LabelField(tok[t], USE_TARGET, addressTable, globalPointer,
+                       stmt, errors, fixups);
+      break;
+    default:
+      break;
+    }
+  }
+
+  if(t < count)
+  {
+    ErrorStream() << "error: too many operands in '" << stmt << "'"
+                  << std::endl;
+    ++errors;
+  }
+  return mc;
+}
+
+// looks a statement's instruction up once and lets its table row
+// drive the encoding
+inline int EncodeStatement(const Token *tok, int count,
+                           SymbolTable &addressTable, int globalPointer,
+                           const Token &stmt, int &errors,
+                           std::vector<Fixup> *fixups)
+{
+  const InstrDesc *desc = FindInstruction(tok[0].text, tok[0].length);
+  if(desc)
+    return EncodeInstruction(*desc, tok, count, addressTable, globalPointer,
+                             stmt, errors, fixups);
+  ErrorStream() << "error: unknown instruction '" << tok[0] << "' in '"
+                << stmt << "'" << std::endl;
+  ++errors;
+  return 0;
+}
+
+inline int EncodeStatement(const std::vector<std::string> &tok,
+                           SymbolTable &addressTable, int globalPointer,
+                           const std::string &stmt, int &errors,
+                           std::vector<Fixup> *fixups = NULL)
+{
+  return EncodeStatement(TokensOf(tok), tok.size(), addressTable,
+                         globalPointer, MakeToken(stmt), errors, fixups);
+}
+
+// drops a comment and trailing blanks from a source line, returns
+// false if nothing is left
+inline bool CleanLine(std::string &line)
+{
+  line = line.substr(0, line.find('#'));
+  line.erase(line.find_last_not_of(" \t\r") + 1);
+  return !line.empty();
+}
+
+#endif
@@ -0,0 +1,383 @@
+/**
+ *	@file 		pipeline.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Five stage pipeline timing model.
+ *
+ *	@section 	DESCRIPTION
+ * 	Pipeline estimates how many cycles a program takes on the
+ *      classic IF ID EX MEM WB pipeline. It is a RefSink, so it
+ *      times the instructions the interpreter actually runs,
+ *      reading each one's pc from its fetch, and it keeps no
+ *      pipeline state beyond one number per register: the first
+ *      cycle a later instruction may be in EX and still get
+ *      that register's value. Each instruction's EX cycle is
+ *      then the one after the last instruction's, pushed back
+ *      by the registers it reads, the HI/LO unit and a taken
+ *      branch, and the difference is counted as stalls of that
+ *      kind against its pc.
+ *
+ *      Branches are predicted not taken and resolve in ID or
+ *      EX; a taken one flushes the instructions fetched after
+ *      it. Jumps resolve in ID. mult and div keep the HI/LO
+ *      unit busy for their latency. The config file holds, as
+ *      whitespace separated numbers:
+ *
+ *        forwarding      0 none, 1 MEM/WB only, 2 EX/MEM and MEM/WB
+ *        branch stage    2 ID, 3 EX
+ *        mult latency, div latency in cycles
+ **********************************************************/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "interp.h"
+
+enum Forwarding
+{
+  FORWARD_NONE,
+  FORWARD_MEM,              // from MEM/WB only
+  FORWARD_FULL              // from EX/MEM and MEM/WB
+};
+
+const int STAGE_ID = 2;
+const int STAGE_EX = 3;
+
+struct PipelineConfig
+{
+  int forwarding;
+  int branchStage;
+  int multLatency;
+  int divLatency;
+};
+
+// reads a pipeline config file, false if it is not one
+inline bool ReadPipelineConfig(const char *name, PipelineConfig &config)
+{
+  std::ifstream in(name);
+  return (bool)(in >> config.forwarding >> config.branchStage
+                >> config.multLatency >> config.divLatency)
+    && config.forwarding >= FORWARD_NONE && config.forwarding <= FORWARD_FULL
+    && (config.branchStage == STAGE_ID || config.branchStage == STAGE_EX)
+    && config.multLatency > 0 && config.divLatency > 0;
+}
+
+// what stalled an instruction
+enum StallKind
+{
+  STALL_LOAD_USE,           // waited for a load
+  STALL_DATA,               // waited for any other result
+  STALL_BRANCH_DATA,        // a branch or jr waited for its operands
+  STALL_HILO,               // waited for the HI/LO unit
+  STALL_CONTROL,            // fetched after a taken branch or jump
+  STALL_KINDS
+};
+
+const char *const STALL_NAMES[STALL_KINDS] =
+{
+  "load-use", "data", "branch data", "hi/lo", "control"
+};
+
+class Pipeline : public RefSink
+{
+public:
+
+  // constructor, times the text of a loaded program
+  Pipeline(const std::vector<int> &code, int textWords,
+           const PipelineConfig &config)
+    : _config(config), _info(textWords), _runs(textWords, 0),
+      _pcStalls(textWords, 0), _ex(STAGE_EX - 1), _hiloReady(0),
+      _unitFree(0), _last(-1), _dataNext(false), _instructions(0),
+      _branchFlushes(0)
+  {
+    for(int pc = 0; pc < textWords; ++pc)
+      _info[pc] = Classify(DecodeWord(code[pc], pc, textWords));
+    for(int r = 0; r < REG_SINK + 1; ++r)
+    {
+      _readyEx[r] = _readyId[r] = 0;
+      _loaded[r] = false;
+    }
+    for(int k = 0; k < STALL_KINDS; ++k)
+      _stalls[k] = 0;
+  }
+
+  void Refs(const MemRef *refs, size_t count)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      // a load or store's data reference follows its fetch
+      if(_dataNext)
+        _dataNext = false;
+      else
+        Issue(refs[i].address / 4);
+    }
+  }
+
+  unsigned long long Instructions() const {return _instructions;}
+  // cycles until the last instruction leaves WB
+  unsigned long long Cycles() const
+  {
+    return _instructions ? _ex + 2 : 0;
+  }
+  unsigned long long Stalls(StallKind kind) const {return _stalls[kind];}
+  // control stalls of taken conditional branches, which a branch
+  // predictor would replace with its own
+  unsigned long long BranchFlushes() const {return _branchFlushes;}
+  // cycles lost when a branch goes the way it was not predicted
+  int BranchPenalty() const {return _config.branchStage - 1;}
+
+  // prints CPI, the stalls by kind and the pcs that stalled most
+  void Report(std::ostream &out, const std::vector<int> &code,
+              int hotspots = 10) const
+  {
+    static const char *const forwarding[] = {"none", "MEM/WB", "full"};
+    out << "Forwarding:\t" << forwarding[_config.forwarding] << std::endl
+        << "Branches in:\t" << (_config.branchStage == STAGE_ID ? "ID" : "EX")
+        << std::endl << "Mult/div:\t" << _config.multLatency << "/"
+        << _config.divLatency << " cycles" << std::endl
+        << "Instructions:\t" << _instructions << std::endl
+        << "Cycles:\t\t" << Cycles() << std::endl << "CPI:\t\t"
+        << std::fixed << std::setprecision(3)
+        << (_instructions ? (double)Cycles() / _instructions : 0)
+        << std::endl;
+    for(int k = 0; k < STALL_KINDS; ++k)
+      out << "  " << std::left << std::setw(14) << STALL_NAMES[k]
+          << std::right << _stalls[k] << std::endl;
+
+    std::vector<int> pcs;
+    for(size_t pc = 0; pc < _pcStalls.size(); ++pc)
+    {
+      if(_pcStalls[pc])
+        pcs.push_back(pc);
+    }
+    std::sort(pcs.begin(), pcs.end(), HotterThan(_pcStalls));
+    if(pcs.size() > (size_t)hotspots)
+      pcs.resize(hotspots);
+    if(pcs.empty())
+      return;
+    out << "Hotspots:" << std::endl << "  " << std::left << std::setw(8)
+        << "pc" << std::setw(12) << "runs" << std::setw(12) << "stalls"
+        << "statement" << std::right << std::endl;
+    std::string text;
+    for(size_t i = 0; i < pcs.size(); ++i)
+    {
+      Disassemble(code[pcs[i]], pcs[i], text);
+      out << "  " << std::left << std::setw(8) << pcs[i] * 4
+          << std::setw(12) << _runs[pcs[i]] << std::setw(12)
+          << _pcStalls[pcs[i]] << text << std::right << std::endl;
+    }
+  }
+
+private:
+  enum Kind
+  {
+    KIND_ALU,
+    KIND_LOAD,
+    KIND_STORE,
+    KIND_BRANCH,            // conditional, may fall through
+    KIND_JUMP,              // j and jal
+    KIND_JUMP_REG,          // jr and jalr
+    KIND_MULDIV,            // starts the HI/LO unit
+    KIND_MUL,               // mul, a register after the mult latency
+    KIND_HILO_READ          // mfhi and mflo
+  };
+
+  // what the model needs of an instruction
+  struct Info
+  {
+    unsigned char kind;
+    unsigned char src1;     // registers read, REG_SINK for none
+    unsigned char src2;
+    unsigned char dest;     // register written, REG_SINK for none
+    int latency;            // cycles the HI/LO unit is busy
+    bool readsHilo;
+  };
+
+  // orders pcs by most stalls
+  struct HotterThan
+  {
+    HotterThan(const std::vector<unsigned long long> &s): stalls(s) {}
+    bool operator()(int a, int b) const
+    {
+      return stalls[a] != stalls[b] ? stalls[a] > stalls[b] : a < b;
+    }
+    const std::vector<unsigned long long> &stalls;
+  };
+
+  Info Classify(const Decoded &d) const
+  {
+    Info info = {KIND_ALU, REG_SINK, REG_SINK, d.rd, 0, false};
+    if(d.op >= OP_END)
+      return info;
+    const InstrDesc &desc = INSTRUCTIONS[d.op];
+    bool store = (desc.opcode >= 40 && desc.opcode <= 46)
+      || desc.opcode == 56;
+    for(int k = 0; k < 3; ++k)
+    {
+      if(desc.operands[k] == RS || desc.operands[k] == MEM)
+        info.src1 = d.rs ? d.rs : (unsigned char)REG_SINK;
+      // a leading rt is written, unless it is stored
+      if(desc.operands[k] == RT && (k > 0 || store))
+        info.src2 = d.rt ? d.rt : (unsigned char)REG_SINK;
+    }
+
+    std::string name = desc.name;
+    int target;
+    if(store)
+      info.kind = KIND_STORE;
+    else if((desc.opcode >= 32 && desc.opcode <= 38) || desc.opcode == 48)
+      info.kind = KIND_LOAD;
+    else if(name == "jr" || name == "jalr")
+      info.kind = KIND_JUMP_REG;
+    else if(LabelTarget(desc, 0, 0, target))
+      info.kind = desc.format == J_TYPE ? KIND_JUMP : KIND_BRANCH;
+    else if(name == "mfhi" || name == "mflo")
+    {
+      info.kind = KIND_HILO_READ;
+      info.readsHilo = true;
+    }
+    else if(name == "mul")
+    {
+      info.kind = KIND_MUL;
+      info.latency = _config.multLatency;
+    }
+    else if(name == "mult" || name == "multu" || name == "madd"
+            || name == "maddu" || name == "msub" || name == "msubu")
+    {
+      info.kind = KIND_MULDIV;
+      info.latency = _config.multLatency;
+      info.readsHilo = name[0] == 'm' && name[1] != 'u';
+    }
+    else if(name == "div" || name == "divu")
+    {
+      info.kind = KIND_MULDIV;
+      info.latency = _config.divLatency;
+    }
+    else if(name == "mthi" || name == "mtlo")
+    {
+      info.kind = KIND_MULDIV;
+      info.latency = 1;
+    }
+    // jal and the linking branches write $ra
+    if(name == "jal" || name.find("zal") != std::string::npos)
+      info.dest = REG_RA;
+    return info;
+  }
+
+  // times one instruction at pc
+  void Issue(int pc)
+  {
+    if(pc < 0 || pc >= (int)_info.size())
+      return;
+    const Info &info = _info[pc];
+    _dataNext = info.kind == KIND_LOAD || info.kind == KIND_STORE;
+
+    // instructions fetched after a taken branch or jump were
+    // flushed, a branch resolving in stage s costs s - 1 cycles
+    long long earliest = _ex + 1;
+    if(_last >= 0)
+    {
+      int kind = _info[_last].kind;
+      int penalty = kind == KIND_JUMP || kind == KIND_JUMP_REG
+        ? STAGE_ID - 1
+        : kind == KIND_BRANCH && pc != _last + 1
+        ? _config.branchStage - 1 : 0;
+      if(penalty)
+      {
+        earliest += penalty;
+        Stall(STALL_CONTROL, _last, penalty);
+        if(kind == KIND_BRANCH)
+          _branchFlushes += penalty;
+      }
+    }
+
+    // operands read in ID when branches resolve there
+    bool early = _config.branchStage == STAGE_ID
+      && (info.kind == KIND_BRANCH || info.kind == KIND_JUMP_REG);
+    const long long *ready = early ? _readyId : _readyEx;
+    long long at = earliest;
+    StallKind why = STALL_DATA;
+    const unsigned char src[2] = {info.src1, info.src2};
+    for(int k = 0; k < 2; ++k)
+    {
+      if(ready[src[k]] > at)
+      {
+        at = ready[src[k]];
+        why = early ? STALL_BRANCH_DATA
+          : _loaded[src[k]] ? STALL_LOAD_USE : STALL_DATA;
+      }
+    }
+    long long unit = info.readsHilo ? _hiloReady : 0;
+    if(info.kind == KIND_MULDIV || info.kind == KIND_MUL)
+      unit = std::max(unit, _unitFree);
+    if(unit > at)
+    {
+      at = unit;
+      why = STALL_HILO;
+    }
+    if(at > earliest)
+      Stall(why, pc, at - earliest);
+
+    // when a later instruction may use what this one writes
+    long long e = at;
+    int fast = _config.forwarding == FORWARD_FULL;
+    int none = _config.forwarding == FORWARD_NONE;
+    long long ex = info.kind == KIND_LOAD ? e + 2 + none
+      : e + 1 + !fast + none;
+    long long id = e + (info.kind != KIND_LOAD && fast ? 2 : 3);
+    if(info.kind == KIND_MUL)
+    {
+      ex += info.latency - 1;
+      id += info.latency - 1;
+    }
+    if(info.kind == KIND_MULDIV || info.kind == KIND_MUL)
+    {
+      _unitFree = e + info.latency;
+      if(info.kind == KIND_MULDIV)
+        _hiloReady = _unitFree;
+    }
+    if(info.dest != REG_SINK)
+    {
+      _readyEx[info.dest] = ex;
+      _readyId[info.dest] = id;
+      _loaded[info.dest] = info.kind == KIND_LOAD;
+    }
+
+    _ex = e;
+    _last = pc;
+    ++_runs[pc];
+    ++_instructions;
+  }
+
+  void Stall(StallKind kind, int pc, long long cycles)
+  {
+    _stalls[kind] += cycles;
+    _pcStalls[pc] += cycles;
+  }
+
+  PipelineConfig _config;
+  std::vector<Info> _info;
+  std::vector<unsigned long long> _runs;
+  std::vector<unsigned long long> _pcStalls;
+  // per register the first cycle a reader may be in EX, for
+  // readers in EX and readers in ID, and if a load wrote it
+  long long _readyEx[REG_SINK + 1];
+  long long _readyId[REG_SINK + 1];
+  bool _loaded[REG_SINK + 1];
+  long long _ex;            // EX cycle of the last instruction
+  long long _hiloReady;
+  long long _unitFree;
+  int _last;
+  bool _dataNext;
+  unsigned long long _instructions;
+  unsigned long long _stalls[STALL_KINDS];
+  unsigned long long _branchFlushes;
+};
+
+#endif
@@ -0,0 +1,556 @@
+/**
+ *	@file 		predict.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Branch predictors.
+ *
+ *	@section 	DESCRIPTION
+ * 	Predictors for the conditional branches of a run, fed by
+ *      the interpreter as a BranchSink or from a branch trace
+ *      file. A predictor is a class with Predict and Update and
+ *      nothing virtual, so BranchPredictors runs each over a
+ *      whole batch of branches in one tight loop:
+ *
+ *        taken, nottaken   always the same guess
+ *        btfn              backward taken, forward not taken
+ *        bimodal           a table of 2 bit counters by pc
+ *        gshare            the same indexed by pc xor history
+ *        tage              a bimodal base and four tagged tables
+ *                          of longer and longer global history
+ *
+ *      A branch trace has one line per branch, "T:pc:target"
+ *      when it was taken and "N:pc:target" when not, with hex
+ *      byte addresses as in the memory traces of ../proj2.
+ **********************************************************/
+
+#ifndef PREDICT_H
+#define PREDICT_H
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdio>
+#include "interp.h"
+#include "disasm.h"
+
+// moves a 2 bit counter toward a direction
+inline void Train(unsigned char &counter, bool taken)
+{
+  if(taken)
+  {
+    if(counter < 3)
+      ++counter;
+  }
+  else if(counter > 0)
+    --counter;
+}
+
+// always guesses the same way, or backward taken forward not
+class StaticPredictor
+{
+public:
+  enum Kind {TAKEN, NOT_TAKEN, BTFN};
+
+  StaticPredictor(Kind kind): _kind(kind) {}
+
+  bool Predict(const BranchOutcome &b) const
+  {
+    return _kind == BTFN ? b.target <= b.pc : _kind == TAKEN;
+  }
+  void Update(const BranchOutcome &, bool) {}
+
+private:
+  Kind _kind;
+};
+
+// a 2 bit counter per branch, by the low bits of its pc
+class Bimodal
+{
+public:
+  Bimodal(int bits): _table(1u << bits, 1), _mask((1u << bits) - 1) {}
+
+  bool Predict(const BranchOutcome &b)
+  {
+    return _table[(b.pc >> 2) & _mask] >= 2;
+  }
+  void Update(const BranchOutcome &b, bool)
+  {
+    Train(_table[(b.pc >> 2) & _mask], b.taken);
+  }
+
+private:
+  std::vector<unsigned char> _table;
+  unsigned int _mask;
+};
+
+// 2 bit counters indexed by the pc xor the last branches' directions
+class Gshare
+{
+public:
+  Gshare(int bits): _table(1u << bits, 1), _mask((1u << bits) - 1),
+                    _history(0)
+  {
+  }
+
+  bool Predict(const BranchOutcome &b)
+  {
+    return _table[((b.pc >> 2) ^ _history) & _mask] >= 2;
+  }
+  void Update(const BranchOutcome &b, bool)
+  {
+    Train(_table[((b.pc >> 2) ^ _history) & _mask], b.taken);
+    _history = ((_history << 1) | b.taken) & _mask;
+  }
+
+private:
+  std::vector<unsigned char> _table;
+  unsigned int _mask;
+  unsigned int _history;
+};
+
+// a small TAGE: tagged tables of global history 5, 12, 27 and 60
+// branches long in front of a bimodal base. The longest matching
+// table predicts; a wrong prediction takes an entry in a longer
+// table whose useful bits are clear
+const int TAGE_TABLES = 4;
+const int TAGE_LENGTHS[TAGE_TABLES] = {5, 12, 27, 60};
+const int TAGE_TAG_BITS = 9;
+const unsigned int TAGE_RESET = 1u << 18;
+
+class TageLite
+{
+public:
+  TageLite(int bits): _bits(bits), _base(1u << (bits + 2), 1),
+                      _history(0), _branches(0)
+  {
+    // tags are narrower than the field, so an empty entry matches
+    // nothing
+    Entry empty = {0xFFFF, 0, 0};
+    for(int t = 0; t < TAGE_TABLES; ++t)
+    {
+      _table[t].assign(1u << bits, empty);
+      _foldIndex[t] = _foldTag[t] = _foldTag2[t] = 0;
+      _indexShift[t] = TAGE_LENGTHS[t] % bits;
+      _tagShift[t] = TAGE_LENGTHS[t] % TAGE_TAG_BITS;
+      _tag2Shift[t] = TAGE_LENGTHS[t] % (TAGE_TAG_BITS - 1);
+    }
+  }
+
+  bool Predict(const BranchOutcome &b)
+  {
+    unsigned int pc = b.pc >> 2;
+    _provider = _alt = -1;
+    for(int t = TAGE_TABLES - 1; t >= 0; --t)
+    {
+      _index[t] = (pc ^ (pc >> _bits) ^ _foldIndex[t]) & ((1u << _bits) - 1);
+      _tag[t] = (pc ^ _foldTag[t] ^ (_foldTag2[t] << 1))
+        & ((1u << TAGE_TAG_BITS) - 1);
+      if(_table[t][_index[t]].tag == _tag[t])
+      {
+        if(_provider < 0)
+          _provider = t;
+        else if(_alt < 0)
+          _alt = t;
+      }
+    }
+    bool base = _base[pc & (_base.size() - 1)] >= 2;
+    _altPred = _alt >= 0 ? _table[_alt][_index[_alt]].counter >= 0 : base;
+    _pred = _altPred;
+    if(_provider >= 0)
+    {
+      // a newly taken entry is weak and not yet useful, its
+      // alternative is usually the better guess
+      const Entry &e = _table[_provider][_index[_provider]];
+      if(e.useful || (e.counter != 0 && e.counter != -1))
+        _pred = e.counter >= 0;
+    }
+    return _pred;
+  }
+
+  void Update(const BranchOutcome &b, bool)
+  {
+    bool taken = b.taken;
+    if(_provider >= 0)
+    {
+      Entry &e = _table[_provider][_index[_provider]];
+      if(_pred != _altPred)
+      {
+        if(_pred == taken && e.useful < 3)
+          ++e.useful;
+        else if(_pred != taken && e.useful > 0)
+          --e.useful;
+      }
+      if(taken && e.counter < 3)
+        ++e.counter;
+      else if(!taken && e.counter > -4)
+        --e.counter;
+    }
+    else
+      Train(_base[(b.pc >> 2) & (_base.size() - 1)], taken);
+
+    if(_pred != taken && _provider < TAGE_TABLES - 1)
+      Allocate(taken);
+    if(++_branches % TAGE_RESET == 0)
+    {
+      for(int t = 0; t < TAGE_TABLES; ++t)
+      {
+        for(size_t i = 0; i < _table[t].size(); ++i)
+          _table[t][i].useful >>= 1;
+      }
+    }
+
+    for(int t = 0; t < TAGE_TABLES; ++t)
+    {
+      bool out = (_history >> (TAGE_LENGTHS[t] - 1)) & 1;
+      _foldIndex[t] = Fold(_foldIndex[t], _bits, _indexShift[t], taken, out);
+      _foldTag[t] = Fold(_foldTag[t], TAGE_TAG_BITS, _tagShift[t], taken, out);
+      _foldTag2[t] = Fold(_foldTag2[t], TAGE_TAG_BITS - 1, _tag2Shift[t],
+                          taken, out);
+    }
+    _history = (_history << 1) | taken;
+  }
+
+private:
+  struct Entry
+  {
+    unsigned short tag;
+    signed char counter;    // -4 to 3, taken if not negative
+    unsigned char useful;
+  };
+
+  // takes an entry in the first longer table that is not useful,
+  // or makes them all a little less useful
+  void Allocate(bool taken)
+  {
+    for(int t = _provider + 1; t < TAGE_TABLES; ++t)
+    {
+      Entry &e = _table[t][_index[t]];
+      if(e.useful == 0)
+      {
+        e.tag = _tag[t];
+        e.counter = taken ? 0 : -1;
+        return;
+      }
+    }
+    for(int t = _provider + 1; t < TAGE_TABLES; ++t)
+      --_table[t][_index[t]].useful;
+  }
+
+  // a table's history folded into width bits, shifting in the
+  // newest direction and taking out the one that left it, which
+  // lands at shift, the history length mod width
+  static unsigned int Fold(unsigned int fold, int width, int shift, bool in,
+                           bool out)
+  {
+    fold = (fold << 1) | in;
+    fold ^= (unsigned int)out << shift;
+    fold ^= fold >> width;
+    return fold & ((1u << width) - 1);
+  }
+
+  int _bits;
+  std::vector<unsigned char> _base;
+  std::vector<Entry> _table[TAGE_TABLES];
+  unsigned int _foldIndex[TAGE_TABLES];
+  unsigned int _foldTag[TAGE_TABLES];
+  unsigned int _foldTag2[TAGE_TABLES];
+  int _indexShift[TAGE_TABLES];
+  int _tagShift[TAGE_TABLES];
+  int _tag2Shift[TAGE_TABLES];
+  unsigned long long _history;
+  unsigned int _branches;
+
+  // the last prediction, kept for its update
+  unsigned int _index[TAGE_TABLES];
+  unsigned int _tag[TAGE_TABLES];
+  int _provider;
+  int _alt;
+  bool _pred;
+  bool _altPred;
+};
+
+// one predictor's results, slot is a branch's place in the
+// per branch counts of BranchPredictors
+class PredictorRun
+{
+public:
+  PredictorRun(const std::string &name): name(name), mispredicts(0) {}
+  virtual ~PredictorRun() {}
+  virtual void Run(const BranchOutcome *b, const unsigned int *slots,
+                   size_t count) = 0;
+
+  std::string name;
+  unsigned long long mispredicts;
+  std::vector<unsigned long long> perSlot;
+};
+
+template<class P>
+class Predicting : public PredictorRun
+{
+public:
+  Predicting(const std::string &name, const P &p)
+    : PredictorRun(name), _p(p)
+  {
+  }
+
+  void Run(const BranchOutcome *b, const unsigned int *slots, size_t count)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      bool guess = _p.Predict(b[i]);
+      _p.Update(b[i], guess);
+      if(guess != b[i].taken)
+      {
+        ++mispredicts;
+        ++perSlot[slots[i]];
+      }
+    }
+  }
+
+private:
+  P _p;
+};
+
+// branches below this byte address find their counts through a
+// table by pc / 4, the rest, which only come from branch traces,
+// through a map
+const unsigned int DIRECT_BRANCH_PCS = 1u << 24;
+
+// runs several predictors over the same branches and counts how
+// often each branch ran and was taken
+class BranchPredictors : public BranchSink
+{
+public:
+  BranchPredictors(): _branches(0), _taken(0) {}
+
+  ~BranchPredictors()
+  {
+    for(size_t i = 0; i < _runs.size(); ++i)
+      delete _runs[i];
+  }
+
+  // adds the named predictor, false if there is none by that name
+  bool Add(const std::string &name)
+  {
+    PredictorRun *p = name == "taken"
+      ? new Predicting<StaticPredictor>(name, StaticPredictor(
+                                          StaticPredictor::TAKEN))
+      : name == "nottaken"
+      ? new Predicting<StaticPredictor>(name, StaticPredictor(
+                                          StaticPredictor::NOT_TAKEN))
+      : name == "btfn"
+      ? new Predicting<StaticPredictor>(name, StaticPredictor(
+                                          StaticPredictor::BTFN))
+      : name == "bimodal" ? new Predicting<Bimodal>(name, Bimodal(12))
+      : name == "gshare" ? new Predicting<Gshare>(name, Gshare(12))
+      : name == "tage" ? new Predicting<TageLite>(name, TageLite(12))
+      : (PredictorRun *)NULL;
+    if(!p)
+      return false;
+    p->perSlot.resize(_pcs.size(), 0);
+    _runs.push_back(p);
+    return true;
+  }
+
+  // adds a comma separated list of predictors, or all of them
+  bool AddList(const std::string &list)
+  {
+    std::string names = list == "all"
+      ? "nottaken,btfn,bimodal,gshare,tage" : list;
+    size_t start = 0;
+    while(start <= names.size())
+    {
+      size_t comma = names.find(',', start);
+      if(comma == std::string::npos)
+        comma = names.size();
+      if(!Add(names.substr(start, comma - start)))
+        return false;
+      start = comma + 1;
+    }
+    return true;
+  }
+
+  void Branches(const BranchOutcome *b, size_t count)
+  {
+    _slots.resize(count);
+    for(size_t i = 0; i < count; ++i)
+    {
+      unsigned int slot = Slot(b[i].pc);
+      _slots[i] = slot;
+      ++_runsAt[slot];
+      _takenAt[slot] += b[i].taken;
+      _taken += b[i].taken;
+    }
+    _branches += count;
+    for(size_t i = 0; i < _runs.size(); ++i)
+      _runs[i]->Run(b, &_slots[0], count);
+  }
+
+  unsigned long long Count() const {return _branches;}
+
+  // prints each predictor's accuracy, mispredictions per thousand
+  // instructions and the CPI its mispredictions give on top of
+  // baseCycles, then the branches that ran most. instructions may
+  // be 0 if unknown and code NULL if there is no program
+  void Report(std::ostream &out, unsigned long long instructions,
+              double baseCycles, int penalty, const std::vector<int> *code,
+              int hotspots = 10) const
+  {
+    out << "Branches:\t" << _branches << " (" << std::fixed
+        << std::setprecision(1)
+        << (_branches ? 100.0 * _taken / _branches : 0) << "% taken)"
+        << std::endl << "Penalty:\t" << penalty << " cycles" << std::endl
+        << "  " << std::left << std::setw(12) << "predictor"
+        << std::setw(14) << "mispredicts" << std::setw(11) << "accuracy"
+        << std::setw(9) << "MPKI" << "CPI" << std::right << std::endl;
+    for(size_t i = 0; i < _runs.size(); ++i)
+    {
+      const PredictorRun &p = *_runs[i];
+      out << "  " << std::left << std::setw(12) << p.name << std::setw(14)
+          << p.mispredicts << std::setprecision(2) << std::setw(11)
+          << (_branches ? 100.0 * (_branches - p.mispredicts) / _branches
+              : 100.0);
+      if(instructions)
+        out << std::setprecision(3) << std::setw(9)
+            << 1000.0 * p.mispredicts / instructions
+            << (baseCycles + (double)p.mispredicts * penalty) / instructions;
+      out << std::right << std::endl;
+    }
+
+    std::vector<unsigned int> slots;
+    for(size_t s = 0; s < _runsAt.size(); ++s)
+    {
+      if(_runsAt[s])
+        slots.push_back(s);
+    }
+    std::sort(slots.begin(), slots.end(), MoreRuns(_runsAt));
+    if(slots.size() > (size_t)hotspots)
+      slots.resize(hotspots);
+    if(slots.empty())
+      return;
+    out << "Branches by runs, mispredicts per predictor:" << std::endl
+        << "  " << std::left << std::setw(10) << "pc" << std::setw(12)
+        << "runs" << std::setw(8) << "taken";
+    for(size_t i = 0; i < _runs.size(); ++i)
+      out << std::setw(11) << _runs[i]->name;
+    out << (code ? "statement" : "") << std::right << std::endl;
+    std::string text;
+    for(size_t k = 0; k < slots.size(); ++k)
+    {
+      unsigned int s = slots[k];
+      char pc[16];
+      snprintf(pc, sizeof(pc), "%x", _pcs[s]);
+      out << "  " << std::left << std::setw(10) << pc << std::setw(12)
+          << _runsAt[s] << std::setprecision(0) << std::setw(8)
+          << (100.0 * _takenAt[s] / _runsAt[s]);
+      for(size_t i = 0; i < _runs.size(); ++i)
+        out << std::setw(11) << _runs[i]->perSlot[s];
+      if(code && _pcs[s] / 4 < code->size())
+      {
+        Disassemble((*code)[_pcs[s] / 4], _pcs[s] / 4, text);
+        out << text;
+      }
+      out << std::right << std::endl;
+    }
+  }
+
+private:
+  // orders slots by most runs
+  struct MoreRuns
+  {
+    MoreRuns(const std::vector<unsigned long long> &r): runs(r) {}
+    bool operator()(unsigned int a, unsigned int b) const
+    {
+      return runs[a] != runs[b] ? runs[a] > runs[b] : a < b;
+    }
+    const std::vector<unsigned long long> &runs;
+  };
+
+  // the counting slot of a branch, made on its first run
+  unsigned int Slot(unsigned int pc)
+  {
+    if(pc < DIRECT_BRANCH_PCS)
+    {
+      unsigned int i = pc / 4;
+      if(i >= _direct.size())
+        _direct.resize(i + 1, 0);
+      if(!_direct[i])
+        _direct[i] = NewSlot(pc) + 1;
+      return _direct[i] - 1;
+    }
+    std::unordered_map<unsigned int, unsigned int>::iterator it
+      = _far.find(pc);
+    if(it != _far.end())
+      return it->second;
+    return _far[pc] = NewSlot(pc);
+  }
+
+  unsigned int NewSlot(unsigned int pc)
+  {
+    _pcs.push_back(pc);
+    _runsAt.push_back(0);
+    _takenAt.push_back(0);
+    for(size_t i = 0; i < _runs.size(); ++i)
+      _runs[i]->perSlot.push_back(0);
+    return _pcs.size() - 1;
+  }
+
+  std::vector<PredictorRun *> _runs;
+  std::vector<unsigned int> _slots;
+  std::vector<unsigned int> _direct;   // slot + 1 by pc / 4, 0 for none
+  std::vector<unsigned int> _pcs;
+  std::vector<unsigned long long> _runsAt;
+  std::vector<unsigned long long> _takenAt;
+  std::unordered_map<unsigned int, unsigned int> _far;
+  unsigned long long _branches;
+  unsigned long long _taken;
+};
+
+// writes branches as a branch trace
+class BranchWriter : public BranchSink
+{
+public:
+  BranchWriter(FILE *file): _file(file) {}
+
+  void Branches(const BranchOutcome *b, size_t count)
+  {
+    for(size_t i = 0; i < count; ++i)
+      fprintf(_file, "%c:%x:%x\n", b[i].taken ? 'T' : 'N', b[i].pc,
+              b[i].target);
+  }
+
+private:
+  FILE *_file;
+};
+
+// passes branches on to every sink added
+class BranchTee : public BranchSink
+{
+public:
+  void Add(BranchSink *sink) {_sinks.push_back(sink);}
+
+  void Branches(const BranchOutcome *b, size_t count)
+  {
+    for(size_t i = 0; i < _sinks.size(); ++i)
+      _sinks[i]->Branches(b, count);
+  }
+
+private:
+  std::vector<BranchSink *> _sinks;
+};
+
+// parses one branch trace line, false if it is not a branch
+inline bool ParseBranch(const char *line, BranchOutcome &b)
+{
+  char direction;
+  if(sscanf(line, "%c:%x:%x", &direction, &b.pc, &b.target) != 3
+     || (direction != 'T' && direction != 'N'))
+    return false;
+  b.taken = direction == 'T';
+  return true;
+}
+
+#endif
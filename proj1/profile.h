@@ -0,0 +1,695 @@
+/**
+ *	@file 		profile.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Execution profile of a running program.
+ *
+ *	@section 	DESCRIPTION
+ * 	Profiler is a RefSink: it counts every instruction the
+ *      interpreter runs from its fetch and every load and store
+ *      from the data reference after it, so it only costs
+ *      anything on a traced run. A run with no sink never
+ *      leaves the plain dispatch loop, so profiling that is off
+ *      is free.
+ *
+ *      Besides a count per pc it keeps a call tree. A jal,
+ *      jalr or linking branch that goes somewhere other than
+ *      the next word enters a node under the current one for
+ *      that call site and target, and a jr to the word after
+ *      the call site of the current node, or of one above it,
+ *      leaves back to its parent. Each node holds what ran in
+ *      it, as the events Ir (instructions), Dr (loads) and Dw
+ *      (stores).
+ *
+ *      Functions start at pc 0 and at every call target, and
+ *      are named after the text labels the assembler's address
+ *      table gave them (see TextLabel). Report prints the
+ *      functions, the hottest pcs as label+offset, the hottest
+ *      basic blocks, the opcode mix and how often each page of
+ *      memory was read and written. WriteCallgrind writes the
+ *      profile for callgrind_annotate and KCachegrind, and
+ *      WriteFolded the folded stacks flamegraph.pl draws.
+ **********************************************************/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include "interp.h"
+
+enum ProfileEvent
+{
+  EVENT_IR,                 // instructions run
+  EVENT_DR,                 // loads
+  EVENT_DW,                 // stores
+  PROFILE_EVENTS
+};
+
+class Profiler : public RefSink
+{
+public:
+
+  // constructor, profiles the text of a loaded program
+  Profiler(const std::vector<int> &code, int textWords,
+           const std::vector<TextLabel> &labels)
+    : _code(code), _labels(labels), _info(textWords),
+      _runs(textWords, 0), _node(0), _last(-1), _dataNext(false),
+      _instructions(0)
+  {
+    for(int pc = 0; pc < textWords; ++pc)
+      _info[pc] = Classify(code[pc], pc);
+    _nodes.push_back(Node(0, -1, -1));
+  }
+
+  void Refs(const MemRef *refs, size_t count)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      // a load or store's data reference follows its fetch
+      if(_dataNext)
+      {
+        _dataNext = false;
+        Data(refs[i]);
+      }
+      else
+        Fetch(refs[i].address / 4);
+    }
+  }
+
+  unsigned long long Instructions() const {return _instructions;}
+  // times the instruction at pc ran
+  unsigned long long Runs(int pc) const {return _runs[pc];}
+
+  // prints the functions, the hottest pcs and blocks, the opcode
+  // mix and the memory heat map, top entries of each
+  void Report(std::ostream &out, int top = 10) const
+  {
+    std::vector<int> starts;
+    Functions(starts);
+    std::vector<Totals> totals;
+    Sum(starts, totals);
+    out << "Instructions:\t" << _instructions << std::endl;
+    if(!_instructions)
+      return;
+
+    std::vector<int> order;
+    for(size_t f = 0; f < starts.size(); ++f)
+    {
+      if(totals[f].inclusive[EVENT_IR])
+        order.push_back(f);
+    }
+    std::sort(order.begin(), order.end(), ByInclusive(totals));
+    out << "Functions:" << std::endl << "  " << std::left << std::setw(24)
+        << "function" << std::right << std::setw(14) << "self"
+        << std::setw(8) << "%" << std::setw(14) << "inclusive"
+        << std::setw(8) << "%" << std::setw(10) << "calls" << std::endl;
+    for(size_t i = 0; i < order.size() && i < (size_t)top; ++i)
+    {
+      const Totals &t = totals[order[i]];
+      out << "  " << std::left << std::setw(23) << Locate(starts[order[i]])
+          << std::right << " " << std::setw(14) << t.self[EVENT_IR]
+          << std::setw(8) << Percent(t.self[EVENT_IR]) << std::setw(14)
+          << t.inclusive[EVENT_IR] << std::setw(8)
+          << Percent(t.inclusive[EVENT_IR]) << std::setw(10) << t.calls
+          << std::endl;
+    }
+
+    std::vector<int> pcs;
+    for(size_t pc = 0; pc < _runs.size(); ++pc)
+    {
+      if(_runs[pc])
+        pcs.push_back(pc);
+    }
+    std::sort(pcs.begin(), pcs.end(), ByCount(_runs));
+    out << "Hotspots:" << std::endl << "  " << std::left << std::setw(8)
+        << "pc" << std::setw(24) << "location" << std::right
+        << std::setw(14) << "runs" << std::setw(8) << "%" << "  "
+        << "statement" << std::endl;
+    std::string text;
+    for(size_t i = 0; i < pcs.size() && i < (size_t)top; ++i)
+    {
+      Disassemble(_code[pcs[i]], pcs[i], text);
+      out << "  " << std::left << std::setw(8) << pcs[i] * 4
+          << std::setw(23) << Locate(pcs[i]) << std::right << " "
+          << std::setw(14) << _runs[pcs[i]] << std::setw(8)
+          << Percent(_runs[pcs[i]]) << "  " << text << std::endl;
+    }
+
+    // a block is counted by the runs of its first instruction
+    std::vector<int> leaders;
+    Leaders(leaders);
+    std::vector<unsigned long long> weight(_runs.size(), 0);
+    std::vector<int> blocks;
+    for(size_t i = 0; i + 1 < leaders.size(); ++i)
+    {
+      int pc = leaders[i];
+      if(_runs[pc])
+      {
+        weight[pc] = _runs[pc] * (leaders[i + 1] - pc);
+        blocks.push_back(pc);
+      }
+    }
+    std::sort(blocks.begin(), blocks.end(), ByCount(weight));
+    out << "Blocks:" << std::endl << "  " << std::left << std::setw(8)
+        << "pc" << std::setw(24) << "location" << std::right
+        << std::setw(8) << "length" << std::setw(14) << "runs"
+        << std::setw(14) << "instructions" << std::setw(8) << "%"
+        << std::endl;
+    for(size_t i = 0; i < blocks.size() && i < (size_t)top; ++i)
+    {
+      int pc = blocks[i];
+      out << "  " << std::left << std::setw(8) << pc * 4 << std::setw(23)
+          << Locate(pc) << std::right << " " << std::setw(8)
+          << weight[pc] / _runs[pc] << std::setw(14) << _runs[pc]
+          << std::setw(14) << weight[pc] << std::setw(8)
+          << Percent(weight[pc]) << std::endl;
+    }
+
+    // instructions run by row of INSTRUCTIONS
+    std::vector<unsigned long long> mix(OP_END + 1, 0);
+    for(size_t pc = 0; pc < _runs.size(); ++pc)
+      mix[_info[pc].op] += _runs[pc];
+    std::vector<int> ops;
+    for(int op = 0; op <= OP_END; ++op)
+    {
+      if(mix[op])
+        ops.push_back(op);
+    }
+    std::sort(ops.begin(), ops.end(), ByCount(mix));
+    out << "Opcode mix:" << std::endl;
+    for(size_t i = 0; i < ops.size(); ++i)
+      out << "  " << std::left << std::setw(10)
+          << (ops[i] < OP_END ? INSTRUCTIONS[ops[i]].name : "invalid")
+          << std::right << std::setw(14) << mix[ops[i]] << std::setw(8)
+          << Percent(mix[ops[i]]) << std::endl;
+
+    HeatMap(out, top * 2);
+  }
+
+  // writes the profile in callgrind's format, positions are byte
+  // addresses and calls carry the inclusive cost of the callee
+  void WriteCallgrind(std::ostream &out, const std::string &command) const
+  {
+    std::vector<int> starts;
+    Functions(starts);
+    std::vector<Totals> totals;
+    Sum(starts, totals);
+    unsigned long long sum[PROFILE_EVENTS] = {0, 0, 0};
+    for(size_t f = 0; f < totals.size(); ++f)
+    {
+      for(int e = 0; e < PROFILE_EVENTS; ++e)
+        sum[e] += totals[f].self[e];
+    }
+
+    out << "# callgrind format" << std::endl << "version: 1" << std::endl
+        << "creator: mipsrun" << std::endl << "cmd: " << command
+        << std::endl << "positions: instr" << std::endl
+        << "events: Ir Dr Dw" << std::endl << "summary: " << sum[EVENT_IR]
+        << " " << sum[EVENT_DR] << " " << sum[EVENT_DW] << std::endl
+        << std::hex;
+    for(size_t f = 0; f < starts.size(); ++f)
+    {
+      const Totals &t = totals[f];
+      if(!t.self[EVENT_IR] && t.edges.empty())
+        continue;
+      int end = f + 1 < starts.size() ? starts[f + 1] : _runs.size();
+      out << std::endl << "fn=" << Locate(starts[f]) << std::endl;
+      for(int pc = starts[f]; pc < end; ++pc)
+      {
+        if(!_runs[pc])
+          continue;
+        int kind = _info[pc].kind;
+        out << "0x" << pc * 4 << std::dec << " " << _runs[pc] << " "
+            << (kind == KIND_LOAD ? _runs[pc] : 0) << " "
+            << (kind == KIND_STORE ? _runs[pc] : 0) << std::hex
+            << std::endl;
+      }
+      for(size_t i = 0; i < t.edges.size(); ++i)
+      {
+        const Edge &e = t.edges[i];
+        out << "cfn=" << Locate(starts[e.callee]) << std::endl
+            << "calls=" << std::dec << e.calls << std::hex << " 0x"
+            << starts[e.callee] * 4 << std::endl << "0x" << e.site * 4
+            << std::dec;
+        for(int k = 0; k < PROFILE_EVENTS; ++k)
+          out << " " << e.inclusive[k];
+        out << std::hex << std::endl;
+      }
+    }
+    out << std::dec;
+  }
+
+  // writes one line per call path that ran instructions: the
+  // functions from the first down, separated by ';', and a count.
+  // Calls from different sites of a function share a line
+  void WriteFolded(std::ostream &out) const
+  {
+    std::map<std::string, unsigned long long> paths;
+    std::vector<int> starts;
+    Functions(starts);
+    std::vector<std::string> names(starts.size());
+    for(size_t f = 0; f < starts.size(); ++f)
+      names[f] = Locate(starts[f]);
+
+    // depth first, with the path to the node in path
+    std::string path;
+    std::vector<std::pair<int, size_t> > stack;
+    stack.push_back(std::make_pair(0, 0));
+    std::vector<size_t> lengths;
+    lengths.push_back(0);
+    path = names[FunctionOf(starts, 0)];
+    while(!stack.empty())
+    {
+      int n = stack.back().first;
+      size_t child = stack.back().second++;
+      const Node &node = _nodes[n];
+      if(child == 0 && node.cost[EVENT_IR])
+        paths[path] += node.cost[EVENT_IR];
+      if(child < node.children.size())
+      {
+        int c = node.children[child];
+        lengths.push_back(path.size());
+        path += ";" + names[FunctionOf(starts, _nodes[c].entry)];
+        stack.push_back(std::make_pair(c, 0));
+      }
+      else
+      {
+        stack.pop_back();
+        path.resize(lengths.back());
+        lengths.pop_back();
+      }
+    }
+    std::map<std::string, unsigned long long>::const_iterator it;
+    for(it = paths.begin(); it != paths.end(); ++it)
+      out << it->first << " " << it->second << "\n";
+    out.flush();
+  }
+
+private:
+  Profiler(const Profiler &);
+  Profiler &operator=(const Profiler &);
+
+  enum Kind
+  {
+    KIND_OTHER,
+    KIND_LOAD,
+    KIND_STORE,
+    KIND_BRANCH,            // ends a block, target is static
+    KIND_CALL,              // jal, jalr and the linking branches
+    KIND_RETURN             // jr
+  };
+
+  struct Info
+  {
+    unsigned char kind;
+    unsigned char op;       // row of INSTRUCTIONS, OP_END if none
+    int target;             // word address, -1 if not known
+  };
+
+  // a place in the call tree: one call site and target under its
+  // parent, with what ran there
+  struct Node
+  {
+    Node(int e, int p, int site)
+      : entry(e), parent(p), callSite(site), calls(0)
+    {
+      for(int k = 0; k < PROFILE_EVENTS; ++k)
+        cost[k] = 0;
+    }
+
+    int entry;
+    int parent;
+    int callSite;           // -1 for the root
+    unsigned long long calls;
+    unsigned long long cost[PROFILE_EVENTS];
+    std::vector<int> children;
+  };
+
+  // calls from one call site to one function
+  struct Edge
+  {
+    int site;
+    int callee;
+    unsigned long long calls;
+    unsigned long long inclusive[PROFILE_EVENTS];
+  };
+
+  // what a function ran itself and with its callees, and who
+  // it called
+  struct Totals
+  {
+    Totals(): calls(0)
+    {
+      for(int k = 0; k < PROFILE_EVENTS; ++k)
+        self[k] = inclusive[k] = 0;
+    }
+
+    unsigned long long calls;
+    unsigned long long self[PROFILE_EVENTS];
+    unsigned long long inclusive[PROFILE_EVENTS];
+    std::vector<Edge> edges;
+  };
+
+  // orders indexes by most counted
+  struct ByCount
+  {
+    ByCount(const std::vector<unsigned long long> &c): count(c) {}
+    bool operator()(int a, int b) const
+    {
+      return count[a] != count[b] ? count[a] > count[b] : a < b;
+    }
+    const std::vector<unsigned long long> &count;
+  };
+
+  struct ByInclusive
+  {
+    ByInclusive(const std::vector<Totals> &t): totals(t) {}
+    bool operator()(int a, int b) const
+    {
+      unsigned long long x = totals[a].inclusive[EVENT_IR];
+      unsigned long long y = totals[b].inclusive[EVENT_IR];
+      return x != y ? x > y : a < b;
+    }
+    const std::vector<Totals> &totals;
+  };
+
+  // reads and writes of one page
+  struct Heat
+  {
+    unsigned long long reads;
+    unsigned long long writes;
+  };
+
+  Info Classify(unsigned int word, int pc) const
+  {
+    Info info = {KIND_OTHER, OP_END, -1};
+    const InstrDesc *desc = DecodeInstruction(word);
+    if(!desc)
+      return info;
+    info.op = desc - INSTRUCTIONS;
+    std::string name = desc->name;
+    int target;
+    if((desc->opcode >= 40 && desc->opcode <= 46) || desc->opcode == 56)
+      info.kind = KIND_STORE;
+    else if((desc->opcode >= 32 && desc->opcode <= 38)
+            || desc->opcode == 48)
+      info.kind = KIND_LOAD;
+    else if(name == "jr")
+      info.kind = KIND_RETURN;
+    else if(name == "jalr")
+      info.kind = KIND_CALL;
+    else if(LabelTarget(*desc, word, pc, target))
+    {
+      info.kind = name == "jal" || name.find("zal") != std::string::npos
+        ? KIND_CALL : KIND_BRANCH;
+      if(target >= 0 && target < (int)_info.size())
+        info.target = target;
+    }
+    return info;
+  }
+
+  void Fetch(int pc)
+  {
+    if(pc < 0 || pc >= (int)_info.size())
+      return;
+    if(_last >= 0)
+    {
+      int kind = _info[_last].kind;
+      if(kind == KIND_CALL && pc != _last + 1)
+        Call(_last, pc);
+      else if(kind == KIND_RETURN)
+        Return(pc);
+    }
+    int kind = _info[pc].kind;
+    _dataNext = kind == KIND_LOAD || kind == KIND_STORE;
+    ++_runs[pc];
+    ++_nodes[_node].cost[EVENT_IR];
+    ++_instructions;
+    _last = pc;
+  }
+
+  void Data(const MemRef &r)
+  {
+    ++_nodes[_node].cost[r.write ? EVENT_DW : EVENT_DR];
+    size_t page = r.address >> PAGE_BITS;
+    if(page >= _heat.size())
+    {
+      Heat cold = {0, 0};
+      _heat.resize(page + 1, cold);
+    }
+    ++(r.write ? _heat[page].writes : _heat[page].reads);
+  }
+
+  // enters the node for a call from site to pc
+  void Call(int site, int pc)
+  {
+    const std::vector<int> &children = _nodes[_node].children;
+    for(size_t i = 0; i < children.size(); ++i)
+    {
+      Node &c = _nodes[children[i]];
+      if(c.callSite == site && c.entry == pc)
+      {
+        ++c.calls;
+        _node = children[i];
+        return;
+      }
+    }
+    int child = _nodes.size();
+    _nodes.push_back(Node(pc, _node, site));
+    _nodes[_node].children.push_back(child);
+    _nodes[child].calls = 1;
+    _node = child;
+  }
+
+  // leaves the innermost call that returns to pc, if any
+  void Return(int pc)
+  {
+    for(int n = _node; n > 0; n = _nodes[n].parent)
+    {
+      if(_nodes[n].callSite + 1 == pc)
+      {
+        _node = _nodes[n].parent;
+        return;
+      }
+    }
+  }
+
+  // the first pc of every function in order: 0, the static
+  // targets of calls and every target a call reached
+  void Functions(std::vector<int> &starts) const
+  {
+    starts.assign(1, 0);
+    for(size_t pc = 0; pc < _info.size(); ++pc)
+    {
+      if(_info[pc].kind == KIND_CALL && _info[pc].target >= 0)
+        starts.push_back(_info[pc].target);
+    }
+    for(size_t n = 1; n < _nodes.size(); ++n)
+      starts.push_back(_nodes[n].entry);
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+  }
+
+  static int FunctionOf(const std::vector<int> &starts, int pc)
+  {
+    return std::upper_bound(starts.begin(), starts.end(), pc)
+      - starts.begin() - 1;
+  }
+
+  // sums the pcs and the call tree into functions. A function's
+  // inclusive cost counts only the outermost of a recursion, so
+  // no instruction is counted twice; a call's counts all of the
+  // callee's, as callgrind's do
+  void Sum(const std::vector<int> &starts, std::vector<Totals> &totals) const
+  {
+    totals.assign(starts.size(), Totals());
+    for(size_t pc = 0; pc < _runs.size(); ++pc)
+    {
+      Totals &t = totals[FunctionOf(starts, pc)];
+      t.self[EVENT_IR] += _runs[pc];
+      if(_info[pc].kind == KIND_LOAD)
+        t.self[EVENT_DR] += _runs[pc];
+      else if(_info[pc].kind == KIND_STORE)
+        t.self[EVENT_DW] += _runs[pc];
+    }
+
+    // children come after their parents, so one pass back up sums
+    // every subtree
+    std::vector<unsigned long long> below(_nodes.size() * PROFILE_EVENTS);
+    for(size_t n = 0; n < _nodes.size(); ++n)
+    {
+      for(int k = 0; k < PROFILE_EVENTS; ++k)
+        below[n * PROFILE_EVENTS + k] = _nodes[n].cost[k];
+    }
+    for(size_t n = _nodes.size(); n-- > 1; )
+    {
+      for(int k = 0; k < PROFILE_EVENTS; ++k)
+        below[_nodes[n].parent * PROFILE_EVENTS + k]
+          += below[n * PROFILE_EVENTS + k];
+    }
+
+    // depth first, counting how many times each function is on
+    // the path to the node
+    std::vector<int> active(starts.size(), 0);
+    std::vector<std::pair<int, size_t> > stack;
+    stack.push_back(std::make_pair(0, 0));
+    while(!stack.empty())
+    {
+      int n = stack.back().first;
+      size_t child = stack.back().second++;
+      const Node &node = _nodes[n];
+      int f = FunctionOf(starts, node.entry);
+      if(child == 0)
+      {
+        Totals &t = totals[f];
+        t.calls += node.calls;
+        if(!active[f]++)
+        {
+          for(int k = 0; k < PROFILE_EVENTS; ++k)
+            t.inclusive[k] += below[n * PROFILE_EVENTS + k];
+        }
+        if(n > 0)
+          AddEdge(totals[FunctionOf(starts, node.callSite)], node.callSite,
+                  f, node.calls, &below[n * PROFILE_EVENTS]);
+      }
+      if(child < node.children.size())
+        stack.push_back(std::make_pair(node.children[child], 0));
+      else
+      {
+        --active[f];
+        stack.pop_back();
+      }
+    }
+  }
+
+  static void AddEdge(Totals &caller, int site, int callee,
+                      unsigned long long calls,
+                      const unsigned long long *inclusive)
+  {
+    size_t i = 0;
+    while(i < caller.edges.size() && (caller.edges[i].site != site
+                                      || caller.edges[i].callee != callee))
+      ++i;
+    if(i == caller.edges.size())
+    {
+      Edge e = {site, callee, 0, {0, 0, 0}};
+      caller.edges.push_back(e);
+    }
+    Edge &e = caller.edges[i];
+    e.calls += calls;
+    for(int k = 0; k < PROFILE_EVENTS; ++k)
+      e.inclusive[k] += inclusive[k];
+  }
+
+  // the first pc of every basic block, and the end of the text:
+  // 0, labels, branch targets, the words after anything that
+  // jumps, and pcs run a different number of times than the one
+  // before, where a jr must have landed
+  void Leaders(std::vector<int> &leaders) const
+  {
+    int size = _info.size();
+    leaders.assign(1, 0);
+    leaders.push_back(size);
+    for(size_t i = 0; i < _labels.size(); ++i)
+      leaders.push_back(_labels[i].pc);
+    for(int pc = 0; pc < size; ++pc)
+    {
+      const Info &info = _info[pc];
+      if(info.kind == KIND_BRANCH || info.kind == KIND_CALL
+         || info.kind == KIND_RETURN)
+        leaders.push_back(pc + 1);
+      if(info.target >= 0)
+        leaders.push_back(info.target);
+      if(pc > 0 && _runs[pc] != _runs[pc - 1])
+        leaders.push_back(pc);
+    }
+    std::sort(leaders.begin(), leaders.end());
+    leaders.erase(std::unique(leaders.begin(), leaders.end()),
+                  leaders.end());
+    while(leaders.back() > size)
+      leaders.pop_back();
+  }
+
+  // pc as the label at or before it and a byte offset, or as a
+  // byte address if there is no label before it
+  std::string Locate(int pc) const
+  {
+    TextLabel key = {pc + 1, ""};
+    std::vector<TextLabel>::const_iterator it
+      = std::lower_bound(_labels.begin(), _labels.end(), key);
+    char buf[16];
+    if(it == _labels.begin())
+    {
+      snprintf(buf, sizeof(buf), "0x%x", pc * 4);
+      return buf;
+    }
+    // the first of the labels on that pc
+    int at = (--it)->pc;
+    while(it != _labels.begin() && (it - 1)->pc == at)
+      --it;
+    if(at == pc)
+      return it->name;
+    snprintf(buf, sizeof(buf), "+%d", (pc - at) * 4);
+    return it->name + buf;
+  }
+
+  std::string Percent(unsigned long long count) const
+  {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%.2f", 100.0 * count / _instructions);
+    return buf;
+  }
+
+  // prints the most used pages in address order, each with a bar
+  // as long as its share of the most used one
+  void HeatMap(std::ostream &out, int top) const
+  {
+    std::vector<unsigned long long> used(_heat.size());
+    std::vector<int> pages;
+    for(size_t p = 0; p < _heat.size(); ++p)
+    {
+      used[p] = _heat[p].reads + _heat[p].writes;
+      if(used[p])
+        pages.push_back(p);
+    }
+    if(pages.empty())
+      return;
+    std::sort(pages.begin(), pages.end(), ByCount(used));
+    if(pages.size() > (size_t)top)
+      pages.resize(top);
+    unsigned long long most = used[pages[0]];
+    std::sort(pages.begin(), pages.end());
+
+    const int BAR = 32;
+    out << "Memory heat (" << PAGE_SIZE << " byte pages):" << std::endl
+        << "  " << std::left << std::setw(12) << "page" << std::right
+        << std::setw(14) << "reads" << std::setw(14) << "writes" << std::endl;
+    for(size_t i = 0; i < pages.size(); ++i)
+    {
+      const Heat &h = _heat[pages[i]];
+      int bar = (used[pages[i]] * BAR + most - 1) / most;
+      out << "  0x" << std::hex << std::setw(8) << std::setfill('0')
+          << ((unsigned int)pages[i] << PAGE_BITS) << std::setfill(' ')
+          << std::dec << std::setw(14) << h.reads << std::setw(14)
+          << h.writes << "  " << std::string(bar, '#') << std::endl;
+    }
+  }
+
+  std::vector<int> _code;
+  std::vector<TextLabel> _labels;
+  std::vector<Info> _info;
+  std::vector<unsigned long long> _runs;
+  std::vector<Node> _nodes;
+  int _node;                // where the run is in the call tree
+  std::vector<Heat> _heat;  // by address >> PAGE_BITS
+  int _last;
+  bool _dataNext;
+  unsigned long long _instructions;
+};
+
+#endif
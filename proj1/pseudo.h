@@ -0,0 +1,412 @@
+/**
+ *	@file 		pseudo.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Pseudo-instructions.
+ *
+ *	@section 	DESCRIPTION
+ * 	Pseudo-instructions are rows of PSEUDOS holding the real
+ *      statements they expand to, with %N standing for operand
+ *      N as written and %N+ for operand N plus one. li, la and
+ *      loads or stores from a bare label are expanded in code
+ *      since their words depend on the operand. Expansion needs
+ *      no label to be defined yet, so it works the same in one
+ *      pass or two. StatementSize is what pass one counts, so
+ *      labels after a pseudo-op land where pass two puts them.
+ *
+ *      All of it works on Tokens (see lexer.h), and a statement
+ *      is expanded into one reused string of lines, so nothing
+ *      is allocated per statement. Front ends that split into
+ *      strings still can, through the overloads that take them.
+ **********************************************************/
+
+#ifndef PSEUDO_H
+#define PSEUDO_H
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <iostream>
+#include "isa.h"
+#include "lexer.h"
+
+// where errors found while expanding and encoding a statement are
+// printed. Each thread has its own, so a worker can keep its
+// messages out of the way
+inline std::ostream &ErrorStream(std::ostream *to = NULL)
+{
+  static thread_local std::ostream *stream = &std::cerr;
+  if(to)
+    stream = to;
+  return *stream;
+}
+
+// how a pseudo-instruction is expanded
+enum PseudoKind
+{
+  TEMPLATE,         // from the rows' statements
+  LOAD_IMMEDIATE,   // li, one or two words by value
+  LOAD_ADDRESS      // la, lui and ori of a label's byte address
+};
+
+// one row of the pseudo-instruction table
+struct PseudoDesc
+{
+  const char *name;
+  PseudoKind kind;
+  int operands;             // operand count that makes it a pseudo-op
+  const char *expand[3];    // real statements, NULL ends the list
+  const char *immExpand[3]; // used when operand 1 is a number
+};
+
+constexpr PseudoDesc PSEUDOS[] =
+{
+  {"nop",  TEMPLATE, 0, {"sll $zero,$zero,0"}, {NULL}},
+  {"move", TEMPLATE, 2, {"addu %0,%1,$zero"}, {NULL}},
+  {"neg",  TEMPLATE, 2, {"sub %0,$zero,%1"}, {NULL}},
+  {"negu", TEMPLATE, 2, {"subu %0,$zero,%1"}, {NULL}},
+  {"not",  TEMPLATE, 2, {"nor %0,%1,$zero"}, {NULL}},
+  {"abs",  TEMPLATE, 2,
+   {"sra $at,%1,31", "xor %0,%1,$at", "subu %0,%0,$at"}, {NULL}},
+  {"li",   LOAD_IMMEDIATE, 2, {NULL}, {NULL}},
+  {"la",   LOAD_ADDRESS, 2, {NULL}, {NULL}},
+
+  // branches
+  {"b",    TEMPLATE, 1, {"beq $zero,$zero,%0"}, {NULL}},
+  {"bal",  TEMPLATE, 1, {"bgezal $zero,%0"}, {NULL}},
+  {"beqz", TEMPLATE, 2, {"beq %0,$zero,%1"}, {NULL}},
+  {"bnez", TEMPLATE, 2, {"bne %0,$zero,%1"}, {NULL}},
+  {"blt",  TEMPLATE, 3, {"slt $at,%0,%1", "bne $at,$zero,%2"},
+   {"slti $at,%0,%1", "bne $at,$zero,%2"}},
+  {"bge",  TEMPLATE, 3, {"slt $at,%0,%1", "beq $at,$zero,%2"},
+   {"slti $at,%0,%1", "beq $at,$zero,%2"}},
+  {"bgt",  TEMPLATE, 3, {"slt $at,%1,%0", "bne $at,$zero,%2"},
+   {"slti $at,%0,%1+", "beq $at,$zero,%2"}},
+  {"ble",  TEMPLATE, 3, {"slt $at,%1,%0", "beq $at,$zero,%2"},
+   {"slti $at,%0,%1+", "bne $at,$zero,%2"}},
+  {"bltu", TEMPLATE, 3, {"sltu $at,%0,%1", "bne $at,$zero,%2"},
+   {"sltiu $at,%0,%1", "bne $at,$zero,%2"}},
+  {"bgeu", TEMPLATE, 3, {"sltu $at,%0,%1", "beq $at,$zero,%2"},
+   {"sltiu $at,%0,%1", "beq $at,$zero,%2"}},
+  {"bgtu", TEMPLATE, 3, {"sltu $at,%1,%0", "bne $at,$zero,%2"},
+   {"sltiu $at,%0,%1+", "beq $at,$zero,%2"}},
+  {"bleu", TEMPLATE, 3, {"sltu $at,%1,%0", "beq $at,$zero,%2"},
+   {"sltiu $at,%0,%1+", "bne $at,$zero,%2"}},
+
+  // comparisons
+  {"sgt",  TEMPLATE, 3, {"slt %0,%2,%1"}, {NULL}},
+  {"sgtu", TEMPLATE, 3, {"sltu %0,%2,%1"}, {NULL}},
+  {"sge",  TEMPLATE, 3, {"slt %0,%1,%2", "xori %0,%0,1"}, {NULL}},
+  {"sgeu", TEMPLATE, 3, {"sltu %0,%1,%2", "xori %0,%0,1"}, {NULL}},
+  {"sle",  TEMPLATE, 3, {"slt %0,%2,%1", "xori %0,%0,1"}, {NULL}},
+  {"sleu", TEMPLATE, 3, {"sltu %0,%2,%1", "xori %0,%0,1"}, {NULL}},
+  {"seq",  TEMPLATE, 3, {"subu %0,%1,%2", "sltiu %0,%0,1"}, {NULL}},
+  {"sne",  TEMPLATE, 3, {"subu %0,%1,%2", "sltu %0,$zero,%0"}, {NULL}},
+
+  // three operand forms of real instructions
+  {"div",  TEMPLATE, 3, {"div %1,%2", "mflo %0"}, {NULL}},
+  {"divu", TEMPLATE, 3, {"divu %1,%2", "mflo %0"}, {NULL}},
+  {"rem",  TEMPLATE, 3, {"div %1,%2", "mfhi %0"}, {NULL}},
+  {"remu", TEMPLATE, 3, {"divu %1,%2", "mfhi %0"}, {NULL}},
+  {"jalr", TEMPLATE, 1, {"jalr $ra,%0"}, {NULL}},
+};
+
+struct PseudoKeys
+{
+  static constexpr int COUNT = sizeof(PSEUDOS) / sizeof(PSEUDOS[0]);
+  static constexpr unsigned int BITS = 9;
+  static constexpr const char *Key(int i){return PSEUDOS[i].name;}
+};
+
+// splits a statement into mnemonic and operands
+inline void SplitStatement(const std::string &s,
+                           std::vector<std::string> &tok)
+{
+  tok.clear();
+  size_t i = 0;
+  while(i < s.size())
+  {
+    while(i < s.size() && IsSeparator(s[i]))
+      ++i;
+    size_t start = i;
+    while(i < s.size() && !IsSeparator(s[i]))
+      ++i;
+    if(i > start)
+      tok.push_back(s.substr(start, i - start));
+  }
+}
+
+// tokens over the strings of a split statement, in an array each
+// thread reuses, so only one may be held at a time
+inline const Token *TokensOf(const std::vector<std::string> &tok)
+{
+  static thread_local std::vector<Token> tokens;
+  tokens.clear();
+  for(size_t i = 0; i < tok.size(); ++i)
+    tokens.push_back(MakeToken(tok[i]));
+  return tokens.data();
+}
+
+// true if the operand is a number rather than a label
+inline bool isNumber(const Token &t)
+{
+  return t.kind == TOKEN_NUMBER;
+}
+
+inline bool isNumber(const std::string &s)
+{
+  return !s.empty() && (isdigit(s[0]) || s[0] == '-' || s[0] == '+');
+}
+
+// the value of a number operand, decimal or 0x hex
+inline int NumberValue(const Token &t)
+{
+  char buffer[32];
+  int length = t.length < 31 ? t.length : 31;
+  memcpy(buffer, t.text, length);
+  buffer[length] = 0;
+  return (int)strtoll(buffer, NULL, 0);
+}
+
+inline int NumberValue(const std::string &s)
+{
+  return (int)strtoll(s.c_str(), NULL, 0);
+}
+
+// reads a number operand, decimal or 0x hex, returns false if the
+// whole token is not one
+inline bool ParseNumber(const Token &t, long long &value)
+{
+  char buffer[32];
+  if(t.length <= 0 || t.length > 31)
+    return false;
+  memcpy(buffer, t.text, t.length);
+  buffer[t.length] = 0;
+  char *end;
+  errno = 0;
+  value = strtoll(buffer, &end, 0);
+  return *end == 0 && errno == 0;
+}
+
+// returns the pseudo-instruction row a statement uses or NULL
+// when it is a real instruction. div, divu and jalr are only
+// pseudo-ops with the operand count of their row
+inline const PseudoDesc *FindPseudo(const Token *tok, int count)
+{
+  int i = PerfectHash<PseudoKeys>::Find(tok[0].text, tok[0].length);
+  if(i < 0 || (FindInstruction(tok[0].text, tok[0].length)
+               && count - 1 != PSEUDOS[i].operands))
+    return NULL;
+  return &PSEUDOS[i];
+}
+
+// true for a load or store from a bare label, lw $t0,label,
+// which needs the upper half of the address in $at first
+inline bool IsAbsoluteMemory(const Token *tok, int count)
+{
+  if(count != 3)
+    return false;
+  const InstrDesc *desc = FindInstruction(tok[0].text, tok[0].length);
+  return desc && desc->operands[1] == MEM && !isNumber(tok[2])
+    && FindRegister(tok[2].text, tok[2].length) < 0;
+}
+
+// number of words li takes for a value
+inline int LoadImmediateSize(int v)
+{
+  return (v >= -32768 && v <= 65535) || (v & 0xFFFF) == 0 ? 1 : 2;
+}
+
+// number of words a text statement assembles to
+inline int StatementSize(const Token *tok, int count)
+{
+  const PseudoDesc *p = FindPseudo(tok, count);
+  if(!p)
+    return IsAbsoluteMemory(tok, count) ? 2 : 1;
+
+  switch(p->kind)
+  {
+  case LOAD_IMMEDIATE:
+    return count == 3 && isNumber(tok[2])
+      ? LoadImmediateSize(NumberValue(tok[2])) : 1;
+  case LOAD_ADDRESS:
+    return count == 3 && isNumber(tok[2])
+      ? LoadImmediateSize(NumberValue(tok[2])) : 2;
+  default:
+  {
+    const char *const *lines = count > 2 && isNumber(tok[2])
+      && p->immExpand[0] ? p->immExpand : p->expand;
+    int n = 0;
+    while(n < 3 && lines[n])
+      ++n;
+    return n;
+  }
+  }
+}
+
+inline int StatementSize(const std::vector<std::string> &tok)
+{
+  return StatementSize(TokensOf(tok), tok.size());
+}
+
+// appends one template statement with its operands filled in
+inline void FillTemplate(const char *t, const Token *tok, std::string &out)
+{
+  for(; *t; ++t)
+  {
+    if(*t != '%')
+    {
+      out += *t;
+      continue;
+    }
+    const Token &operand = tok[*++t - '0' + 1];
+    if(t[1] == '+')
+    {
+      char buffer[16];
+      snprintf(buffer, sizeof(buffer), "%d", NumberValue(operand) + 1);
+      out += buffer;
+      ++t;
+    }
+    else
+      out.append(operand.text, operand.length);
+  }
+  out += '\n';
+}
+
+// appends the statements of li for a value
+inline void ExpandLoadImmediate(const Token &rt, int v, std::string &out)
+{
+  char buffer[64];
+  if(v >= -32768 && v <= 32767)
+    snprintf(buffer, sizeof(buffer), "addiu %.*s,$zero,%d\n", rt.length,
+             rt.text, v);
+  else if(v >= 0 && v <= 65535)
+    snprintf(buffer, sizeof(buffer), "ori %.*s,$zero,%d\n", rt.length,
+             rt.text, v);
+  else
+  {
+    snprintf(buffer, sizeof(buffer), "lui %.*s,%d\n", rt.length, rt.text,
+             (unsigned int)v >> 16);
+    out += buffer;
+    if((v & 0xFFFF) == 0)
+      return;
+    snprintf(buffer, sizeof(buffer), "ori %.*s,%.*s,%d\n", rt.length,
+             rt.text, rt.length, rt.text, v & 0xFFFF);
+  }
+  out += buffer;
+}
+
+// expands a pseudo-instruction or a load or store from a bare
+// label into real statements, one a line in out, and returns
+// false if the statement is already a real instruction. Halves
+// of a label's byte address are written hi:label, ha:label
+// (rounded up for a signed low half) and lo:label and filled in
+// when the statement is encoded
+inline bool ExpandStatement(const Token *tok, int count, const Token &stmt,
+                            std::string &out, int &errors)
+{
+  out.clear();
+  const PseudoDesc *p = FindPseudo(tok, count);
+  if(!p && !IsAbsoluteMemory(tok, count))
+    return false;
+
+  if(p && count - 1 != p->operands)
+  {
+    ErrorStream() << "error: '" << tok[0] << "' takes " << p->operands
+                  << " operand(s) in '" << stmt << "'" << std::endl;
+    ++errors;
+    for(int i = StatementSize(tok, count); i > 0; --i)
+      out += "sll $zero,$zero,0\n";
+    return true;
+  }
+
+  if(!p)
+  {
+    out += "lui $at,ha:";
+    out.append(tok[2].text, tok[2].length);
+    out += '\n';
+    out.append(tok[0].text, tok[0].length);
+    out += ' ';
+    out.append(tok[1].text, tok[1].length);
+    out += ",lo:";
+    out.append(tok[2].text, tok[2].length);
+    out += "($at)\n";
+    return true;
+  }
+
+  switch(p->kind)
+  {
+  case LOAD_IMMEDIATE:
+    if(!isNumber(tok[2]))
+    {
+      ErrorStream() << "error: li needs a number in '" << stmt << "'"
+                    << std::endl;
+      ++errors;
+      out += "sll $zero,$zero,0\n";
+    }
+    else
+      ExpandLoadImmediate(tok[1], NumberValue(tok[2]), out);
+    break;
+  case LOAD_ADDRESS:
+    if(isNumber(tok[2]))
+      ExpandLoadImmediate(tok[1], NumberValue(tok[2]), out);
+    else
+    {
+      out += "lui ";
+      out.append(tok[1].text, tok[1].length);
+      out += ",hi:";
+      out.append(tok[2].text, tok[2].length);
+      out += "\nori ";
+      out.append(tok[1].text, tok[1].length);
+      out += ',';
+      out.append(tok[1].text, tok[1].length);
+      out += ",lo:";
+      out.append(tok[2].text, tok[2].length);
+      out += '\n';
+    }
+    break;
+  default:
+  {
+    const char *const *lines = count > 2 && isNumber(tok[2])
+      && p->immExpand[0] ? p->immExpand : p->expand;
+    for(int i = 0; i < 3 && lines[i]; ++i)
+      FillTemplate(lines[i], tok, out);
+  }
+  }
+  return true;
+}
+
+// lexes the statement of an expansion starting at at into tok and
+// moves at past it, returns false when there are none left
+inline bool NextStatement(const std::string &expanded, size_t &at,
+                          std::vector<Token> &tok)
+{
+  if(at >= expanded.size())
+    return false;
+  size_t end = expanded.find('\n', at);
+  tok.clear();
+  LexStatement(expanded.data() + at, end - at, 0, tok);
+  at = end + 1;
+  return true;
+}
+
+inline bool ExpandStatement(const std::vector<std::string> &tok,
+                            const std::string &stmt,
+                            std::vector<std::string> &out, int &errors)
+{
+  static thread_local std::string expanded;
+  out.clear();
+  if(!ExpandStatement(TokensOf(tok), tok.size(), MakeToken(stmt), expanded,
+                      errors))
+    return false;
+  for(size_t at = 0, end; at < expanded.size(); at = end + 1)
+  {
+    end = expanded.find('\n', at);
+    out.push_back(expanded.substr(at, end - at));
+  }
+  return true;
+}
+
+#endif
@@ -0,0 +1,377 @@
+/**
+ *	@file 		replay.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Record, replay and snapshots of a run.
+ *
+ *	@section 	DESCRIPTION
+ * 	A run of the interpreter depends only on its program and
+ *      the values its syscalls read, so with those logged (see
+ *      Interpreter::LogInput) it can be repeated exactly, to
+ *      any instruction count. TimeMachine takes a snapshot of
+ *      the registers, HI, LO, pc and counts every interval
+ *      instructions as the run first goes forward, with only the
+ *      memory pages stored to since the snapshot before. Going
+ *      to instruction n restores the last snapshot at or before
+ *      n and runs on from there, so a step back is a restore
+ *      and a short replay, never a run from the start.
+ *
+ *      A restore puts back only the pages that changed between
+ *      where the run is and the snapshot, each from the latest
+ *      snapshot that holds it or from the program as loaded.
+ *      What the program prints is only passed on the first time
+ *      it runs past it, so replaying does not print anything
+ *      twice.
+ **********************************************************/
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <climits>
+#include "interp.h"
+#include "disasm.h"
+
+// instructions between snapshots
+const unsigned long long DEFAULT_SNAPSHOT_INTERVAL = 1000000;
+
+// an output stream buffer that passes on only characters past the
+// furthest the run has printed
+class ReplayBuf : public std::streambuf
+{
+public:
+  ReplayBuf(std::streambuf *to): _to(to), _count(0), _mark(0) {}
+
+  unsigned long long Count() const {return _count;}
+  // goes back to where the run had printed count characters
+  void Rewind(unsigned long long count) {_count = count;}
+
+protected:
+  int overflow(int c)
+  {
+    if(c == EOF)
+      return 0;
+    if(++_count > _mark)
+    {
+      _mark = _count;
+      return _to->sputc(c);
+    }
+    return c;
+  }
+
+  int sync() {return _to->pubsync();}
+
+private:
+  std::streambuf *_to;
+  unsigned long long _count;
+  unsigned long long _mark;
+};
+
+// the state of a run at one instruction count
+struct Snapshot
+{
+  MachineState state;
+  unsigned long long printed;
+  std::vector<size_t> pages;        // changed since the one before
+  std::vector<unsigned char> bytes; // PAGE_SIZE of each
+};
+
+class TimeMachine
+{
+public:
+
+  // constructor, takes over a machine that has not run yet,
+  // logging what it reads from in and printing to out
+  TimeMachine(Interpreter &machine, std::istream &in, std::ostream &out,
+              std::vector<int> &log,
+              unsigned long long interval = DEFAULT_SNAPSHOT_INTERVAL)
+    : _machine(machine), _buf(out.rdbuf()), _out(&_buf),
+      _interval(interval ? interval : 1), _base(0), _ended(false),
+      _endStop(STOP_END), _restores(0), _replayed(0)
+  {
+    _machine.Streams(in, _out);
+    _machine.LogInput(&log);
+    Take();
+  }
+
+  // runs or goes back to instruction count target, or to where
+  // the program stopped if that is before it. Returns how the
+  // program stopped, or STOP_LIMIT if it reached target
+  Stop Seek(unsigned long long target)
+  {
+    bool clamped = _ended && target >= _endCount;
+    if(clamped)
+      target = _endCount;
+
+    // the last snapshot at or before target
+    size_t k = _snaps.size() - 1;
+    while(_snaps[k].state.executed > target)
+      --k;
+    if(target < Now() || _snaps[k].state.executed > Now())
+      Restore(k);
+
+    while(Now() < target)
+    {
+      // behind the last snapshot the run replays up to it, past
+      // it the run goes on a snapshot at a time
+      unsigned long long last = _snaps.back().state.executed;
+      unsigned long long from = Now();
+      bool frontier = from >= last;
+      unsigned long long to = frontier ? last + _interval : last;
+      if(to > target || to < last)
+        to = target;
+
+      Stop stop = _machine.RunExactly(to - from);
+      if(!frontier)
+        _replayed += Now() - from;
+      if(stop != STOP_LIMIT)
+      {
+        _ended = true;
+        _endStop = stop;
+        _endCount = Now();
+        _endFault = _machine.Fault();
+        _out.flush();
+        return stop;
+      }
+      if(frontier && Now() >= last + _interval)
+        Take();
+    }
+    _out.flush();
+    return clamped ? _endStop : STOP_LIMIT;
+  }
+
+  // steps count instructions forward, or back if it is negative
+  Stop Step(long long count)
+  {
+    unsigned long long now = Now();
+    if(count < 0 && (unsigned long long)-count > now)
+      return Seek(0);
+    return Seek(now + count);
+  }
+
+  unsigned long long Now() const {return _machine.Executed();}
+  // how the program stopped if the run is where it did, else
+  // STOP_LIMIT
+  Stop Stopped() const
+  {
+    return _ended && Now() == _endCount ? _endStop : STOP_LIMIT;
+  }
+  const std::string &Fault() const {return _endFault;}
+  size_t Snapshots() const {return _snaps.size();}
+  // pages held by all the snapshots
+  size_t SnapshotPages() const
+  {
+    size_t pages = 0;
+    for(size_t i = 0; i < _snaps.size(); ++i)
+      pages += _snaps[i].pages.size();
+    return pages;
+  }
+  unsigned long long Restores() const {return _restores;}
+  // instructions run again after restores
+  unsigned long long Replayed() const {return _replayed;}
+
+private:
+  // takes a snapshot where the run is now, past the last one
+  void Take()
+  {
+    GuestMemory &memory = _machine.Memory();
+    _snaps.push_back(Snapshot());
+    Snapshot &s = _snaps.back();
+    _machine.Save(s.state);
+    s.printed = _buf.Count();
+    memory.TakeDirty(s.pages);
+    std::sort(s.pages.begin(), s.pages.end());
+    s.pages.erase(std::unique(s.pages.begin(), s.pages.end()),
+                  s.pages.end());
+    s.bytes.resize(s.pages.size() * PAGE_SIZE);
+    for(size_t i = 0; i < s.pages.size(); ++i)
+      memcpy(&s.bytes[i * PAGE_SIZE], memory.Read(s.pages[i] << PAGE_BITS),
+             PAGE_SIZE);
+    _base = _snaps.size() - 1;
+  }
+
+  // goes back to snapshot k. The pages that can differ from it
+  // are those stored to since memory last matched a snapshot and
+  // those held by the snapshots between that one and k
+  void Restore(size_t k)
+  {
+    GuestMemory &memory = _machine.Memory();
+    std::vector<size_t> changed;
+    memory.TakeDirty(changed);
+    size_t from = std::min(k, _base) + 1;
+    size_t to = std::max(k, _base);
+    for(size_t i = from; i <= to; ++i)
+      changed.insert(changed.end(), _snaps[i].pages.begin(),
+                     _snaps[i].pages.end());
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()),
+                  changed.end());
+
+    bool textChanged = false;
+    size_t textPages = (_machine.TextWords() * 4 + PAGE_MASK) >> PAGE_BITS;
+    for(size_t i = 0; i < changed.size(); ++i)
+    {
+      memory.Restore(changed[i], PageAt(changed[i], k));
+      textChanged = textChanged || changed[i] < textPages;
+    }
+    _machine.Restore(_snaps[k].state, textChanged);
+    _buf.Rewind(_snaps[k].printed);
+    _base = k;
+    ++_restores;
+  }
+
+  // what page held at snapshot k
+  const unsigned char *PageAt(size_t page, size_t k) const
+  {
+    for(size_t i = k + 1; i-- > 0; )
+    {
+      const std::vector<size_t> &pages = _snaps[i].pages;
+      std::vector<size_t>::const_iterator it
+        = std::lower_bound(pages.begin(), pages.end(), page);
+      if(it != pages.end() && *it == page)
+        return &_snaps[i].bytes[(it - pages.begin()) * PAGE_SIZE];
+    }
+    return _machine.Memory().Initial(page);
+  }
+
+  Interpreter &_machine;
+  ReplayBuf _buf;
+  std::ostream _out;
+  unsigned long long _interval;
+  std::vector<Snapshot> _snaps;
+  size_t _base;                     // the snapshot memory last matched
+  bool _ended;
+  Stop _endStop;
+  unsigned long long _endCount;
+  std::string _endFault;
+  unsigned long long _restores;
+  unsigned long long _replayed;
+};
+
+// reads an input log, one value a line, returns false if it
+// cannot be read
+inline bool ReadInputLog(const char *name, std::vector<int> &log)
+{
+  std::ifstream in(name);
+  if(!in)
+    return false;
+  int value;
+  while(in >> value)
+    log.push_back(value);
+  return in.eof();
+}
+
+inline bool WriteInputLog(const char *name, const std::vector<int> &log)
+{
+  std::ofstream out(name);
+  for(size_t i = 0; i < log.size(); ++i)
+    out << log[i] << std::endl;
+  return (bool)out;
+}
+
+// prints where a run is: its count, pc and the instruction there,
+// as it is in memory if the program has stored over it
+inline void PrintWhere(std::ostream &out, Interpreter &machine)
+{
+  std::string statement;
+  int pc = machine.Pc();
+  if(pc >= 0 && pc < machine.TextWords())
+  {
+    unsigned int word;
+    memcpy(&word, machine.Memory().Read(pc * 4), 4);
+    Disassemble(word, pc, statement);
+  }
+  out << std::dec << "at " << machine.Executed() << ": word " << pc
+      << "  " << statement << std::endl;
+}
+
+// runs the commands of a debugging script on a run, one a line,
+// printing to out:
+//
+//   goto n      to instruction count n, forward or back
+//   step [n]    n instructions forward, 1 if not given
+//   back [n]    n instructions back
+//   run         to the end
+//   regs        the registers, HI and LO
+//   mem a [n]   n words, 1 if not given, from byte address a
+//
+// Returns the number of commands that were not understood
+inline int Debug(TimeMachine &run, Interpreter &machine,
+                 std::istream &commands, std::ostream &out)
+{
+  int errors = 0;
+  std::string line;
+  while(std::getline(commands, line))
+  {
+    if(!CleanLine(line))
+      continue;
+    std::istringstream words(line);
+    std::string command;
+    words >> command;
+    long long n = 1;
+    bool given = (bool)(words >> std::setbase(0) >> n);
+
+    Stop stop = STOP_LIMIT;
+    if(command == "goto" && given && n >= 0)
+      stop = run.Seek(n);
+    else if(command == "step")
+      stop = run.Step(n);
+    else if(command == "back")
+      stop = run.Step(-n);
+    else if(command == "run")
+      stop = run.Seek(ULLONG_MAX);
+    else if(command == "regs")
+    {
+      for(int r = 0; r < 32; ++r)
+        out << std::left << std::setw(6) << REGISTERS[r].name << std::right
+            << std::hex << std::setw(8) << std::setfill('0')
+            << machine.Register(r) << std::setfill(' ') << std::dec
+            << (r % 4 == 3 ? "\n" : "  ");
+      out << "hi    " << std::hex << std::setw(8) << std::setfill('0')
+          << machine.Hi() << "  lo    " << std::setw(8) << machine.Lo()
+          << std::setfill(' ') << std::dec << std::endl;
+      continue;
+    }
+    else if(command == "mem" && given)
+    {
+      long long count = 1;
+      words >> std::setbase(0) >> count;
+      GuestMemory &memory = machine.Memory();
+      unsigned long long address = n & ~3ull;
+      for(long long i = 0; i < count; ++i, address += 4)
+      {
+        if(address + 4 > memory.Size())
+          break;
+        unsigned int word;
+        memcpy(&word, memory.Read(address), 4);
+        out << std::hex << std::setw(8) << std::setfill('0') << address
+            << ": " << std::setw(8) << word << std::setfill(' ')
+            << std::dec << std::endl;
+      }
+      continue;
+    }
+    else
+    {
+      std::cerr << "error: unknown command '" << line << "'" << std::endl;
+      ++errors;
+      continue;
+    }
+
+    if(stop == STOP_FAULT)
+      out << "fault: " << run.Fault() << std::endl;
+    else if(stop == STOP_EXIT || stop == STOP_END)
+      out << "program " << (stop == STOP_EXIT ? "exited" : "ended")
+          << std::endl;
+    PrintWhere(out, machine);
+  }
+  return errors;
+}
+
+#endif
@@ -0,0 +1,224 @@
+/**
+ *	@file 		symtab.h
+ *	@author		William Ernest
+ *	@date		10/19/2026
+ *	@brief		Hashed symbol table for the assembler.
+ *
+ *	@section 	DESCRIPTION
+ * 	Label names are interned once into a single character
+ *      pool and looked up through an open addressing hash
+ *      table, so resolving a label costs the same no matter
+ *      how many labels the program has. Every symbol keeps
+ *      the statement that defined it and the first statement
+ *      that used it so duplicate and undefined labels can be
+ *      reported.
+ **********************************************************/
+
+#ifndef SYMTAB_H
+#define SYMTAB_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+
+// one label in the table
+struct Symbol
+{
+  int name;                 // offset of the name in the pool
+  int length;               // length of the name
+  unsigned int hash;        // hash of the name
+  int address;              // word address of the label
+  bool defined;             // seen as a label definition yet
+  bool global;              // exported with .globl
+  bool inData;              // defined in the data section
+  std::string definedBy;    // statement that defined the label
+  std::string usedBy;       // first statement that used the label
+};
+
+class SymbolTable
+{
+public:
+
+  // constructor
+  SymbolTable(): _dataStart(-1), _frozen(false), _slots(64, -1)
+  {
+  }
+
+  // returns the id of the named symbol, adding an undefined
+  // symbol if the name has not been seen before
+  int Intern(const char *s, size_t len)
+  {
+    unsigned int h = Hash(s, len);
+    size_t mask = _slots.size() - 1;
+    size_t slot = h & mask;
+
+    while(_slots[slot] != -1)
+    {
+      Symbol &sym = _symbols[_slots[slot]];
+      if(sym.hash == h && (size_t)sym.length == len
+         && memcmp(&_pool[sym.name], s, len) == 0)
+        return _slots[slot];
+      slot = (slot + 1) & mask;
+    }
+
+    Symbol sym;
+    sym.name = _pool.size();
+    sym.length = len;
+    sym.hash = h;
+    sym.address = 0;
+    sym.defined = false;
+    sym.global = false;
+    sym.inData = false;
+    _pool.insert(_pool.end(), s, s + len);
+    _slots[slot] = _symbols.size();
+    _symbols.push_back(sym);
+
+    // keep the table at most half full
+    if(_symbols.size() * 2 > _slots.size())
+      Grow();
+    return _symbols.size() - 1;
+  }
+
+  int Intern(const std::string &s)
+  {
+    return Intern(s.data(), s.size());
+  }
+
+  // returns the id of the named symbol or -1
+  int Find(const char *s, size_t len) const
+  {
+    unsigned int h = Hash(s, len);
+    size_t mask = _slots.size() - 1;
+    size_t slot = h & mask;
+
+    while(_slots[slot] != -1)
+    {
+      const Symbol &sym = _symbols[_slots[slot]];
+      if(sym.hash == h && (size_t)sym.length == len
+         && memcmp(&_pool[sym.name], s, len) == 0)
+        return _slots[slot];
+      slot = (slot + 1) & mask;
+    }
+    return -1;
+  }
+
+  int Find(const std::string &s) const
+  {
+    return Find(s.data(), s.size());
+  }
+
+  // defines a label at address, returns false if it was
+  // already defined. The statement is stmtLen characters
+  bool Define(const char *s, size_t len, int address, const char *stmt,
+              size_t stmtLen)
+  {
+    Symbol &sym = _symbols[Intern(s, len)];
+    if(sym.defined)
+      return false;
+    sym.defined = true;
+    sym.address = address;
+    sym.definedBy.assign(stmt, stmtLen);
+    return true;
+  }
+
+  bool Define(const std::string &s, int address, const std::string &stmt)
+  {
+    return Define(s.data(), s.size(), address, stmt.data(), stmt.size());
+  }
+
+  // marks a label as visible to other files
+  void Export(const std::string &s)
+  {
+    _symbols[Intern(s)].global = true;
+  }
+
+  // looks up a label used as an operand, returns its id or -1
+  // if it was never defined. The use is remembered either way,
+  // unless the table is frozen
+  int Use(const char *s, size_t len, const char *stmt, size_t stmtLen)
+  {
+    if(_frozen)
+    {
+      int id = Find(s, len);
+      return id >= 0 && _symbols[id].defined ? id : -1;
+    }
+    Symbol &sym = _symbols[Intern(s, len)];
+    if(sym.usedBy.empty())
+      sym.usedBy.assign(stmt, stmtLen);
+    return sym.defined ? (int)(&sym - &_symbols[0]) : -1;
+  }
+
+  int Use(const std::string &s, const std::string &stmt)
+  {
+    return Use(s.data(), s.size(), stmt.data(), stmt.size());
+  }
+
+  Symbol &operator[](int id){return _symbols[id];}
+  const Symbol &operator[](int id) const {return _symbols[id];}
+  int Size() const {return _symbols.size();}
+
+  // a frozen table is only read, so any number of threads can
+  // look labels up in it at once
+  void Freeze(bool frozen){_frozen = frozen;}
+  bool Frozen() const {return _frozen;}
+
+  // word address where the data section starts, $gp points
+  // at it. -1 until it is known
+  void SetDataStart(int address){_dataStart = address;}
+  int DataStart() const {return _dataStart;}
+
+  std::string Name(int id) const
+  {
+    return std::string(&_pool[_symbols[id].name], _symbols[id].length);
+  }
+
+  // prints every label used but never defined, returns how many
+  int ReportUndefined(std::ostream &out) const
+  {
+    int count = 0;
+    for(size_t i = 0; i < _symbols.size(); ++i)
+    {
+      if(!_symbols[i].defined && !_symbols[i].usedBy.empty())
+      {
+        out << "error: undefined label '" << Name(i) << "' used in '"
+            << _symbols[i].usedBy << "'" << std::endl;
+        ++count;
+      }
+    }
+    return count;
+  }
+
+private:
+  // FNV-1a
+  static unsigned int Hash(const char *s, size_t len)
+  {
+    unsigned int h = 2166136261u;
+    for(size_t i = 0; i < len; ++i)
+      h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+  }
+
+  // doubles the slot array and rehashes from the stored hashes
+  void Grow()
+  {
+    std::vector<int> slots(_slots.size() * 2, -1);
+    size_t mask = slots.size() - 1;
+    for(size_t i = 0; i < _symbols.size(); ++i)
+    {
+      size_t slot = _symbols[i].hash & mask;
+      while(slots[slot] != -1)
+        slot = (slot + 1) & mask;
+      slots[slot] = i;
+    }
+    _slots.swap(slots);
+  }
+
+  int _dataStart;
+  bool _frozen;
+  std::vector<char> _pool;
+  std::vector<Symbol> _symbols;
+  std::vector<int> _slots;
+};
+
+#endif
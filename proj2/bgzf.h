@@ -0,0 +1,131 @@
+/**
+ * @file 	bgzf.h
+ * @author	William Ernest
+ * @date	10/19/26
+ * @brief	BGZF block compressed files.
+ *
+ * @section	DESCRIPTION
+ * BGZF is a series of gzip members of at most 64KB each, with the
+ * compressed size of every member stored in a "BC" extra field of
+ * its header. Any gzip reader can read it, and since the block
+ * boundaries are known without inflating anything the blocks can
+ * be inflated in parallel. A file ends with an empty block.
+ **/
+
+#ifndef BGZF_H
+#define BGZF_H
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+
+const int BGZF_HEADER_SIZE = 18;
+const int BGZF_FOOTER_SIZE = 8;
+const int BGZF_MAX_INPUT = 0xFF00;
+
+// returns true if the buffer starts with a BGZF block header
+inline bool IsBgzfHeader(const unsigned char *h, size_t len)
+{
+  return len >= (size_t)BGZF_HEADER_SIZE && h[0] == 31 && h[1] == 139
+    && h[2] == 8 && (h[3] & 4) && h[10] == 6 && h[11] == 0
+    && h[12] == 'B' && h[13] == 'C' && h[14] == 2 && h[15] == 0;
+}
+
+// compresses up to BGZF_MAX_INPUT bytes into one block and writes
+// it, returns false on a write or deflate failure
+inline bool WriteBgzfBlock(FILE *f, const char *data, size_t len)
+{
+  unsigned char block[BGZF_HEADER_SIZE + 0x10000 + BGZF_FOOTER_SIZE];
+  static const unsigned char header[BGZF_HEADER_SIZE] =
+    {31, 139, 8, 4, 0, 0, 0, 0, 0, 255, 6, 0, 'B', 'C', 2, 0, 0, 0};
+
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  if(deflateInit2(&zs, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+  zs.next_in = (Bytef *)data;
+  zs.avail_in = len;
+  zs.next_out = block + BGZF_HEADER_SIZE;
+  zs.avail_out = 0x10000;
+  int status = deflate(&zs, Z_FINISH);
+  size_t clen = zs.total_out;
+  deflateEnd(&zs);
+  if(status != Z_STREAM_END)
+    return false;
+
+  size_t total = BGZF_HEADER_SIZE + clen + BGZF_FOOTER_SIZE;
+  unsigned long crc = crc32(0L, (const Bytef *)data, len);
+  memcpy(block, header, BGZF_HEADER_SIZE);
+  block[16] = (total - 1) & 0xFF;
+  block[17] = ((total - 1) >> 8) & 0xFF;
+  unsigned char *footer = block + BGZF_HEADER_SIZE + clen;
+  for(int i = 0; i < 4; ++i)
+  {
+    footer[i] = (crc >> (8 * i)) & 0xFF;
+    footer[4 + i] = (len >> (8 * i)) & 0xFF;
+  }
+  return fwrite(block, 1, total, f) == total;
+}
+
+// writes the empty block that ends a BGZF file
+inline bool WriteBgzfEof(FILE *f)
+{
+  return WriteBgzfBlock(f, "", 0);
+}
+
+// reads the next whole block, header included, into block. Returns
+// false at end of file, leaving block empty, or on a truncated block
+// or one that is not BGZF
+inline bool ReadBgzfBlock(FILE *f, std::vector<unsigned char> &block)
+{
+  block.resize(BGZF_HEADER_SIZE);
+  size_t got = fread(&block[0], 1, BGZF_HEADER_SIZE, f);
+  if(got == 0)
+    block.clear();
+  if(got != (size_t)BGZF_HEADER_SIZE
+     || !IsBgzfHeader(&block[0], BGZF_HEADER_SIZE))
+    return false;
+
+  size_t total = (block[16] | (block[17] << 8)) + 1;
+  if(total < (size_t)(BGZF_HEADER_SIZE + BGZF_FOOTER_SIZE))
+    return false;
+  block.resize(total);
+  return fread(&block[BGZF_HEADER_SIZE], 1, total - BGZF_HEADER_SIZE, f)
+    == total - BGZF_HEADER_SIZE;
+}
+
+// inflates a block read by ReadBgzfBlock into out and checks its
+// length and CRC, returns false if the block is corrupt
+inline bool InflateBgzfBlock(const std::vector<unsigned char> &block,
+                             std::vector<char> &out)
+{
+  const unsigned char *footer = &block[block.size() - BGZF_FOOTER_SIZE];
+  unsigned long crc = footer[0] | (footer[1] << 8) | (footer[2] << 16)
+    | ((unsigned long)footer[3] << 24);
+  size_t len = footer[4] | (footer[5] << 8) | (footer[6] << 16)
+    | ((size_t)footer[7] << 24);
+
+  // no block holds more than 64KB, so a bigger length is corrupt
+  if(len > 0x10000)
+    return false;
+  out.resize(len);
+  if(len == 0)
+    return true;
+
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  if(inflateInit2(&zs, -15) != Z_OK)
+    return false;
+  zs.next_in = (Bytef *)&block[BGZF_HEADER_SIZE];
+  zs.avail_in = block.size() - BGZF_HEADER_SIZE - BGZF_FOOTER_SIZE;
+  zs.next_out = (Bytef *)&out[0];
+  zs.avail_out = len;
+  int status = inflate(&zs, Z_FINISH);
+  inflateEnd(&zs);
+
+  return status == Z_STREAM_END && zs.total_out == len
+    && crc32(0L, (const Bytef *)&out[0], len) == crc;
+}
+
+#endif
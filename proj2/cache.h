@@ -0,0 +1,258 @@
+/**
+ * @file 	cache.h
+ * @author	William Ernest
+ * @date	10/19/26
+ * @brief	Set associative LRU cache model.
+ *
+ * @section	DESCRIPTION
+ * The cache used by the simulator, pulled out of wbe14b.pr02.cpp
+ * so the TLB page walker can send its page table references
+ * through it as well.
+ **/
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <iostream>
+#include <string>
+
+class Cache
+{
+public:
+
+  // constructor
+  Cache(int css, int cls, int cs): _cacheSetSize(css), _cacheLineSize(cls),
+                                   _cacheSize(cs), _misses(0),_hits(0)
+  {
+    // initiate a 2D array to simulate cache
+    _data = new int*[GetSetNum()];
+    for(int i = 0; i < GetSetNum() ; ++i)
+      _data[i] = new int[_cacheSetSize];
+
+    // fill 2D array with -1 value incase we need to 
+    // check for an empty value
+    for(int i = 0; i < GetSetNum(); ++i)
+      for(int j = 0; j < _cacheSetSize;++j)
+        _data[i][j] = -1;
+  }
+
+  // destructor
+  ~Cache()
+  {
+    for(int i = 0; i < GetSetNum() ; ++i)
+      delete [] _data[i];
+    delete [] _data;
+  }
+
+  // returns number of lines
+  int GetSetNum()
+  {
+    return _cacheSize/_cacheLineSize/_cacheSetSize;
+  }
+
+  // returns line size
+  int GetLineSize()
+  {
+    return _cacheLineSize;
+  }
+
+  // returns set size
+  int GetSetSize()
+  {
+    return _cacheSetSize;
+  }
+
+  // returns total size
+  int GetSize()
+  {
+    return _cacheSize;
+  }
+
+  // returns hits
+  long long GetHits(){return _hits;}
+ 
+  // returns misses
+  long long GetMisses(){return _misses;}
+
+  // gives number of offset bit digits
+  int GetOffset()
+  {
+    if(_cacheLineSize == 4)
+      return 2;
+    else if(_cacheLineSize == 8)
+      return 3;
+    else if(_cacheLineSize == 16)
+      return 4;
+    else if(_cacheLineSize == 32)
+      return 5;
+  }
+
+  // gives the index an address maps to
+  int GetIndex(unsigned int address)
+  {
+    return (address / _cacheLineSize) % GetSetNum();
+  }
+
+  // gives the tag an address maps to
+  int GetTag(unsigned int address)
+  {
+    return address / _cacheLineSize / GetSetNum();
+  }
+
+  // will be called when the address calls for a read
+  std::string Read(int index, int tag)
+  {
+    // If the cache set size is 1 then we can just replace
+    // the tag if it is a miss
+    if(_cacheSetSize == 1)
+    {
+      if(_data[index][0] == tag)
+      {
+        ++_hits;
+        return "Hit";
+      }
+      else
+      {
+        _data[index][0]= tag;
+        ++_misses;
+        return "Miss";
+      }
+    }
+
+    // if there is a hit on the first tag then we don't need to 
+    // reshuffle
+    if(_data[index][0] == tag)
+    {
+      ++_hits;
+      return "Hit";
+    }
+
+    // if there is a hit some where else along the line, we need to
+    // reshuffle the line moving the tag to the front and dropping
+    // the LRU tag off the line
+    for(int i = 0; i < _cacheSetSize ; ++i)
+    {
+      if(_data[index][i] == tag)
+      {
+        int temp;
+        int next;
+        for( int j = i; j > 0 ; --j)
+        {                                
+          temp = _data[index][j];
+         _data[index][j] = _data[index][j-1];
+         _data[index][j-1] = temp;
+        }
+        ++_hits;
+        return "Hit";
+      }
+    }
+    
+
+    // if there is a miss we can just push the tag onto the front
+    // of the line and move everything else down 1 and drop the LRU
+    // tagg off the back of the line
+    for(int i = _cacheSetSize - 1; i > 0; --i)
+    {
+      _data[index][i] = _data[index][i - 1];
+    }
+    _data[index][0] = tag;
+    ++_misses;
+    return "Miss";
+
+  }
+
+  // will be called for when address calls for writes
+  std::string Write( int index, int tag)
+  {
+    // If the cache set size is 1 then we can just replace                     
+    // the tag if it is a miss                                                 
+    if(_cacheSetSize == 1)
+    {
+      if(_data[index][0] == tag)
+      {
+        ++_hits;
+        return "Hit";
+      }
+      else
+      {
+        _data[index][0]= tag;
+        ++_misses;
+        return "Miss";
+      }
+    }
+
+    // if there is a hit on the first tag then we don't need to                
+    // reshuffle                                                               
+    if(_data[index][0] == tag)
+    {
+      ++_hits;
+      return "Hit";
+    }
+
+    // if there is a hit some where else along the line, we need to            
+    // reshuffle the line moving the tag to the front and dropping             
+    // the LRU tag off the line                                                
+    for(int i = 0; i < _cacheSetSize ; ++i)
+    {
+      if(_data[index][i] == tag)
+      {
+        int temp;
+        int next;
+        for( int j = i; j > 0 ; --j)
+        {
+          temp = _data[index][j];
+          _data[index][j] = _data[index][j-1];
+          _data[index][j-1] = temp;
+        }
+        ++_hits;
+        return "Hit";
+      }
+    }
+
+    // if there is a miss we can just push the tag onto the front              
+    // of the line and move everything else down 1 and drop the LRU            
+    // tagg off the back of the line                                           
+    for(int i = _cacheSetSize - 1; i > 0; --i)
+    {
+      _data[index][i] = _data[index][i - 1];
+    }
+    _data[index][0] = tag;
+    ++_misses;
+    return "Miss";
+
+  }
+
+  // this will print the cache diminsions
+  void PrintConfig(std::ostream &out = std::cout)
+  {
+    out << "Total Cache Size:  " << _cacheSize << "B\n"
+        << "Line Size:  " << _cacheLineSize << "B\n"
+        << "Set Size:  " << _cacheSetSize << std::endl
+        << "Number of Sets:  " << GetSetNum() << std::endl;
+  }
+
+  // this is a debug feature that allows you to see whats in the 
+  // cache
+  void PrintCache()
+  {
+    for( int i = 0 ; i < GetSetNum(); ++i)
+    {
+      for(int j = 0; j < _cacheSetSize ; ++j)
+        std::cout << _data[i][j] << ' ';
+      std::cout << std::endl;
+    }
+    std::cout << std::endl;
+  }
+
+private:
+  // Data will be stored for cache in a 2D array. We will setup the cache
+  // using the cache size, block size, and line size. 
+  int _cacheSetSize;
+  int _cacheLineSize;
+  int _cacheSize;
+  int** _data;
+  long long _hits;
+  long long _misses;
+};
+
+#endif
@@ -0,0 +1,313 @@
+/**
+ * @file 	compressed.h
+ * @author	William Ernest
+ * @date	10/19/26
+ * @brief	Compressed trace input.
+ *
+ * @section	DESCRIPTION
+ * Reads gzip, BGZF, zstd and lz4 compressed traces straight into
+ * the simulator's reference ring (see tracestream.h), so archived
+ * traces never have to be decompressed to disk.
+ *
+ * BGZF blocks are inflated on a pool of worker threads and decoded
+ * in file order, so decompression runs ahead of the simulation.
+ * Plain gzip has no block boundaries and is inflated as one
+ * stream. zstd and lz4 are piped through the zstd and lz4 tools,
+ * which also keeps their decompression off the simulation thread.
+ **/
+
+#ifndef COMPRESSED_H
+#define COMPRESSED_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <zlib.h>
+#include "bgzf.h"
+#include "trace.h"
+#include "tracestream.h"
+
+enum Compression
+{
+  NOT_COMPRESSED,
+  GZIP,
+  BGZF,
+  ZSTD,
+  LZ4
+};
+
+// works out the compression of a file from its first bytes
+inline Compression CompressionOf(const char *name)
+{
+  unsigned char h[BGZF_HEADER_SIZE];
+  FILE *f = fopen(name, "rb");
+  if(!f)
+    return NOT_COMPRESSED;
+  size_t len = fread(h, 1, sizeof(h), f);
+  fclose(f);
+
+  if(IsBgzfHeader(h, len))
+    return BGZF;
+  if(len >= 2 && h[0] == 31 && h[1] == 139)
+    return GZIP;
+  if(len >= 4 && h[0] == 0x28 && h[1] == 0xB5 && h[2] == 0x2F
+     && h[3] == 0xFD)
+    return ZSTD;
+  if(len >= 4 && h[0] == 0x04 && h[1] == 0x22 && h[2] == 0x4D
+     && h[3] == 0x18)
+    return LZ4;
+  return NOT_COMPRESSED;
+}
+
+// one BGZF block on its way through the worker pool
+struct BgzfJob
+{
+  std::vector<unsigned char> in;
+  std::vector<char> out;
+  bool done;
+  bool ok;
+};
+
+// inflates BGZF blocks on worker threads. Blocks are queued in
+// file order and handed back in the same order
+class BgzfPool
+{
+public:
+
+  // constructor
+  BgzfPool(int workers): _stop(false)
+  {
+    for(int i = 0; i < workers; ++i)
+      _workers.push_back(std::thread(&BgzfPool::Work, this));
+  }
+
+  // destructor
+  ~BgzfPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _ready.notify_all();
+    for(size_t i = 0; i < _workers.size(); ++i)
+      _workers[i].join();
+    while(!_window.empty())
+    {
+      delete _window.front();
+      _window.pop_front();
+    }
+  }
+
+  // queues a block, the pool takes ownership
+  void Add(BgzfJob *job)
+  {
+    job->done = false;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _window.push_back(job);
+      _pending.push_back(job);
+    }
+    _ready.notify_one();
+  }
+
+  // number of queued blocks not yet taken back
+  size_t InFlight()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _window.size();
+  }
+
+  // waits for the oldest block and gives it back to the caller,
+  // NULL if nothing is queued
+  BgzfJob *Next()
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if(_window.empty())
+      return NULL;
+    while(!_window.front()->done)
+      _finished.wait(lock);
+    BgzfJob *job = _window.front();
+    _window.pop_front();
+    return job;
+  }
+
+private:
+  // worker thread body
+  void Work()
+  {
+    for(;;)
+    {
+      BgzfJob *job;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while(_pending.empty() && !_stop)
+          _ready.wait(lock);
+        if(_stop)
+          return;
+        job = _pending.front();
+        _pending.pop_front();
+      }
+
+      bool ok = InflateBgzfBlock(job->in, job->out);
+
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        job->ok = ok;
+        job->done = true;
+      }
+      _finished.notify_all();
+    }
+  }
+
+  bool _stop;
+  std::vector<std::thread> _workers;
+  std::deque<BgzfJob *> _window;
+  std::deque<BgzfJob *> _pending;
+  std::mutex _mutex;
+  std::condition_variable _ready;
+  std::condition_variable _finished;
+};
+
+// decodes a BGZF trace, keeping a few blocks per worker in flight
+inline bool ReadBgzfTrace(FILE *f, RefRing *ring, int workers)
+{
+  BgzfPool pool(workers);
+  RefDecoder decoder;
+  std::vector<MemRef> refs;
+  size_t window = workers * 4;
+  bool more = true;
+  bool ok = true;
+  bool clean = true;
+
+  while(ok)
+  {
+    while(more && pool.InFlight() < window)
+    {
+      BgzfJob *job = new BgzfJob;
+      more = ReadBgzfBlock(f, job->in);
+      if(more)
+        pool.Add(job);
+      else
+      {
+        clean = job->in.empty();
+        delete job;
+      }
+    }
+
+    BgzfJob *job = pool.Next();
+    if(!job)
+      break;
+    ok = job->ok;
+    if(ok)
+      decoder.Feed(job->out.data(), job->out.size(), refs);
+    delete job;
+    if(!refs.empty())
+    {
+      ring->Push(refs);
+      refs.clear();
+    }
+  }
+
+  // a clean file ends exactly at a block boundary
+  ok = ok && clean;
+  decoder.Finish(refs);
+  ring->Push(refs);
+  return ok;
+}
+
+// decodes a gzip trace as a single stream
+inline bool ReadGzipTrace(const char *name, RefRing *ring)
+{
+  gzFile f = gzopen(name, "rb");
+  if(!f)
+    return false;
+  gzbuffer(f, 1 << 17);
+
+  std::vector<char> buffer(1 << 16);
+  std::vector<MemRef> refs;
+  RefDecoder decoder;
+  int n;
+  while((n = gzread(f, &buffer[0], buffer.size())) > 0)
+  {
+    decoder.Feed(&buffer[0], n, refs);
+    ring->Push(refs);
+    refs.clear();
+  }
+  decoder.Finish(refs);
+  ring->Push(refs);
+  int err;
+  gzerror(f, &err);
+  gzclose(f);
+  return n == 0 && err == Z_OK;
+}
+
+// decodes a trace through an external decompressor
+inline bool ReadPipedTrace(const char *tool, const char *name,
+                           RefRing *ring)
+{
+  std::string quoted = "'";
+  for(const char *p = name; *p; ++p)
+  {
+    if(*p == '\'')
+      quoted += "'\\''";
+    else
+      quoted += *p;
+  }
+  quoted += "'";
+
+  std::string cmd = std::string(tool) + " -dc -- " + quoted;
+  FILE *f = popen(cmd.c_str(), "r");
+  if(!f)
+    return false;
+
+  std::vector<char> buffer(1 << 16);
+  std::vector<MemRef> refs;
+  RefDecoder decoder;
+  size_t n;
+  while((n = fread(&buffer[0], 1, buffer.size(), f)) > 0)
+  {
+    decoder.Feed(&buffer[0], n, refs);
+    ring->Push(refs);
+    refs.clear();
+  }
+  decoder.Finish(refs);
+  ring->Push(refs);
+  return pclose(f) == 0;
+}
+
+// reader thread body for compressed traces, closes the ring at the
+// end and reports a corrupt or unreadable file through ok
+inline void ReadCompressedTrace(const char *name, RefRing *ring,
+                                int workers, bool *ok)
+{
+  switch(CompressionOf(name))
+  {
+  case BGZF:
+  {
+    FILE *f = fopen(name, "rb");
+    *ok = f && ReadBgzfTrace(f, ring, workers);
+    if(f)
+      fclose(f);
+    break;
+  }
+  case GZIP:
+    *ok = ReadGzipTrace(name, ring);
+    break;
+  case ZSTD:
+    *ok = ReadPipedTrace("zstd", name, ring);
+    break;
+  case LZ4:
+    *ok = ReadPipedTrace("lz4", name, ring);
+    break;
+  default:
+    *ok = false;
+  }
+  ring->Close();
+}
+
+#endif
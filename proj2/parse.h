@@ -0,0 +1,123 @@
+/**
+ * @file 	parse.h
+ * @author	William Ernest
+ * @date	10/19/26
+ * @brief	Trace line parsing and simulation.
+ *
+ * @section	DESCRIPTION
+ * ParseAddress, pulled out of wbe14b.pr02.cpp so the benchmark
+ * harness can time the same parser the simulator uses.
+ **/
+
+#ifndef PARSE_H
+#define PARSE_H
+
+#include <boost/tokenizer.hpp>
+#include <string>
+#include <list>
+#include <cstdlib>
+#include "cache.h"
+#include "tlb.h"
+#include "trace.h"
+
+struct Trace
+{
+  int refNum;
+  std::string rw;
+  int refSize;
+  int address;
+  int tag;
+  int index;
+  int offset;
+  std::string hm;
+};
+
+// calculates the tag, index and offset of a reference whose refNum,
+// rw, refSize and address are filled in, then runs it through the
+// TLBs and cache and notes whether it hit. The index and tag are the
+// cache's own, as SimulateRef uses, so every input maps an address
+// alike whatever the number of sets
+inline void RunTrace(Cache &c, Trace &temp, Mmu *mmu = NULL)
+{
+  unsigned int address = temp.address;
+
+  // calculate value for offset
+  temp.offset = address % c.GetLineSize();
+
+  // calculate index and tag value
+  temp.index = c.GetIndex(address);
+  temp.tag = c.GetTag(address);
+    
+  // translate the address before it reaches the cache
+  if(mmu)
+    mmu->Translate(temp.address);
+
+  //perform memory trace
+  if(temp.rw == " Read")
+    temp.hm = c.Read(temp.index, temp.tag);
+  else
+    temp.hm = c.Write(temp.index, temp.tag);
+}
+
+// parse address will take the string from the memorytrace file list and parse
+// it into the action, acces size, and address. It will then calculate the 
+// tag, index, and offset. Then it will run the trace to check hits and misses
+inline void ParseAddress(Cache &c, std::list<Trace> &mt,
+                         std::list<std::string> &mtf, Mmu *mmu = NULL)
+{
+  int i = 0;                             // to be stored as reference number
+  // temp variable to populate before pushing onto list
+  Trace temp;
+
+  // begin parsing address using tokenizer
+  for(std::list<std::string>::iterator it = mtf.begin(); it != mtf.end();
+      ++it)
+  {
+    temp.refNum = i;
+    boost::char_separator<char> delimeter(":");
+    boost::tokenizer< boost::char_separator<char> > tokens ( *it, delimeter);
+    boost::tokenizer< boost::char_separator<char> >::iterator itr 
+      = tokens.begin();
+    
+    // check for read or write command
+    if((*itr) == "R")
+      temp.rw = " Read";
+    else
+      temp.rw = "Write";
+    
+    // get access size
+    ++itr;
+    temp.refSize = atoi((*itr).c_str());
+
+    // get address
+    ++itr;
+    temp.address = strtoul((*itr).c_str(), NULL, 16);
+
+    RunTrace(c, temp, mmu);
+
+    // push temp onto back of list
+    mt.push_back(temp);
+
+    // for debugging
+    //c.PrintCache();
+    
+    ++i;
+  }
+
+
+
+}
+
+// runs one already decoded reference through the TLBs and cache,
+// used by the streaming inputs which never keep the whole trace
+inline void SimulateRef(Cache &c, const MemRef &r, Mmu *mmu = NULL)
+{
+  if(mmu)
+    mmu->Translate(r.address);
+  if(r.write)
+    c.Write(c.GetIndex(r.address), c.GetTag(r.address));
+  else
+    c.Read(c.GetIndex(r.address), c.GetTag(r.address));
+}
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * @file 	report.h
+ * @author	William Ernest
+ * @date	10/19/26
+ * @brief	Result tables of the cache simulator.
+ *
+ * @section	DESCRIPTION
+ * PrintTable, PrintTrace and PrintSummary, pulled out of
+ * wbe14b.pr02.cpp and given a stream to print to, so the
+ * simulation daemon (see simd.cpp) answers with exactly what
+ * proj2 prints.
+ **/
+
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <iostream>
+#include <iomanip>
+#include <list>
+#include "cache.h"
+#include "parse.h"
+
+// This will print the table header using Dr. Hughes' format
+inline void PrintTable(std::ostream &out = std::cout)
+{
+  out << std::setw(8)  << std::left << "RefNum";
+  out << std::setw(10) << std::left << "  R/W";
+  out << std::setw(13) << std::left << "Address";
+  out << std::setw(6)  << std::left << "Tag";
+  out << std::setw(8)  << std::left << "Index";
+  out << std::setw(10) << std::left << "Offset";
+  out << std::setw(8)  << std::left << "H/M";
+  out << std::setfill('*') << std::setw(64) << "\n" 
+      << std::setfill(' ');
+  out << "\n";
+
+}
+
+// this will print one row of the trace results
+inline void PrintRow(const Trace &t, std::ostream &out = std::cout)
+{
+  out << "   " << std::setw(5) << std::left << t.refNum 
+      << std::setw(8) << t.rw << "  " 
+      << std::setw(8) << std::setfill('0') << std::hex 
+      << std::right << t.address << std::setfill(' ')
+      << std::setw(7) << t.tag 
+      << std::setw(8) << std::dec << t.index 
+      << std::setw(8) << t.offset 
+      << std::setw(10) << t.hm << std::endl;
+}
+
+// this will print the trace results using Dr. Hughes' format
+inline void PrintTrace(std::list<Trace> &mt, std::ostream &out = std::cout)
+{
+  for(std::list<Trace>::iterator i = mt.begin(); i != mt.end(); ++i)
+    PrintRow(*i, out);
+}
+
+// this will print the hit or miss summary using Dr. Hughes' format
+inline void PrintSummary(Cache &c, std::ostream &out = std::cout)
+{
+  long long total = c.GetHits() + c.GetMisses();
+  float hr = (float)c.GetHits()/total;
+  float mr = (float)c.GetMisses()/total;
+  out << std:: endl 
+      << "    Simulation Summary\n"
+      << "**************************\n"
+      << "Total Hits:\t" << c.GetHits() << std::endl
+      << "Total Misses:\t" << c.GetMisses() << std::endl
+      << "Hit Rate:\t" << std::setprecision(5) << hr << '\n'
+      << "Miss Rate:\t" << std::setprecision(5) << mr << '\n';
+}
+
+#endif
@@ -0,0 +1,469 @@
+/**
+ * @file 	simbench.cpp
+ * @author	William Ernest
+ * @date	10/19/26
+ * @brief	Benchmark harness for the cache simulator.
+ *
+ * @section	DESCRIPTION
+ * This program times the Cache read/write hot path and the trace
+ * parser over a matrix of cache geometries and tracegen patterns.
+ * It reports references per second, ns per access, peak RSS and,
+ * where perf_event is available, hardware counters as JSON. With
+ * a baseline JSON file from an earlier revision it also flags any
+ * case that got slower than the threshold, so "make bench
+ * BASELINE=old.json" catches regressions.
+ **/
+
+#ifndef SIMBENCH_CPP
+#define SIMBENCH_CPP
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <list>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "cache.h"
+#include "trace.h"
+#include "parse.h"
+
+// one cache geometry in the matrix
+struct Geometry
+{
+  const char *name;
+  int setSize;
+  int lineSize;
+  int cacheSize;
+};
+
+// one tracegen pattern in the matrix
+struct Pattern
+{
+  const char *name;
+  const char *args;
+};
+
+// the timing of one benchmark case
+struct Result
+{
+  std::string name;
+  long long refs;
+  double seconds;
+  long long hits;
+  long long misses;
+  long peakRss;
+  bool counters;
+  long long cycles;
+  long long instructions;
+  long long cacheMisses;
+  long long branchMisses;
+};
+
+const Geometry GEOMETRIES[] =
+{
+  {"dm-32k",    1, 64, 32768},
+  {"4way-32k",  4, 64, 32768},
+  {"16way-32k", 16, 64, 32768},
+  {"8way-1m",   8, 64, 1048576},
+};
+
+const Pattern PATTERNS[] =
+{
+  {"seq",     "--footprint 8388608"},
+  {"stride",  "--stride 4096 --footprint 8388608"},
+  {"uniform", "--footprint 8388608 --writes 30"},
+  {"zipf",    "--footprint 8388608 --writes 30"},
+  {"chase",   "--footprint 8388608"},
+  {"matmul",  "--dim 128 --tile 16"},
+  {"gups",    "--footprint 8388608"},
+};
+
+// hardware counters for the calling thread through perf_event,
+// every call is a no-op when the counters cannot be opened
+class Counters
+{
+public:
+
+  // constructor
+  Counters(): _leader(-1)
+  {
+    const unsigned long long events[COUNT] =
+    {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    for(int i = 0; i < COUNT; ++i)
+    {
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = events[i];
+      attr.disabled = i == 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      _fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, _leader, 0);
+      if(_fd[i] < 0)
+      {
+        Close(i);
+        return;
+      }
+      if(i == 0)
+        _leader = _fd[0];
+    }
+  }
+
+  // destructor
+  ~Counters()
+  {
+    if(_leader >= 0)
+      Close(COUNT);
+  }
+
+  bool Available(){return _leader >= 0;}
+
+  void Start()
+  {
+    if(_leader < 0)
+      return;
+    ioctl(_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+
+  // stops counting and fills in the counter fields of r
+  void Stop(Result &r)
+  {
+    r.counters = false;
+    if(_leader < 0)
+      return;
+    ioctl(_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    unsigned long long values[COUNT + 1];
+    if(read(_leader, values, sizeof(values)) != sizeof(values))
+      return;
+    r.counters = true;
+    r.cycles = values[1];
+    r.instructions = values[2];
+    r.cacheMisses = values[3];
+    r.branchMisses = values[4];
+  }
+
+private:
+  static const int COUNT = 4;
+
+  // closes the first n counters
+  void Close(int n)
+  {
+    for(int i = 0; i < n; ++i)
+      close(_fd[i]);
+    _leader = -1;
+  }
+
+  int _leader;
+  int _fd[COUNT];
+};
+
+bool LoadPattern(const std::string &, const Pattern &, long long,
+                 std::vector<MemRef> &);
+Result BenchCache(const Geometry &, const Pattern &,
+                  std::vector<MemRef> &, Counters &);
+Result BenchParser(const Pattern &, std::vector<MemRef> &, Counters &);
+long PeakRss();
+std::string Revision();
+void WriteJson(std::ostream &, std::vector<Result> &, long long, bool);
+int Compare(const char *, std::vector<Result> &, double);
+
+int main(int argc, char *argv[])
+{
+  long long refs = 2000000;
+  const char *out = NULL;
+  const char *baseline = NULL;
+  double threshold = 10.0;
+  std::string tracegen = "./tracegen";
+
+  for(int i = 1; i + 1 < argc; i += 2)
+  {
+    std::string a = argv[i];
+    if(a == "--refs")
+      refs = atoll(argv[i + 1]);
+    else if(a == "--out")
+      out = argv[i + 1];
+    else if(a == "--baseline")
+      baseline = argv[i + 1];
+    else if(a == "--threshold")
+      threshold = atof(argv[i + 1]);
+    else if(a == "--tracegen")
+      tracegen = argv[i + 1];
+    else
+    {
+      std::cerr << "usage: simbench [--refs N] [--out FILE] "
+                << "[--baseline FILE] [--threshold PCT] "
+                << "[--tracegen PATH]\n";
+      return 1;
+    }
+  }
+
+  Counters counters;
+  std::vector<Result> results;
+  std::vector<MemRef> trace;
+
+  for(size_t p = 0; p < sizeof(PATTERNS) / sizeof(PATTERNS[0]); ++p)
+  {
+    if(!LoadPattern(tracegen, PATTERNS[p], refs, trace))
+    {
+      std::cerr << "Cannot run " << tracegen << std::endl;
+      return 1;
+    }
+    for(size_t g = 0; g < sizeof(GEOMETRIES) / sizeof(GEOMETRIES[0]); ++g)
+      results.push_back(BenchCache(GEOMETRIES[g], PATTERNS[p], trace,
+                                   counters));
+    results.push_back(BenchParser(PATTERNS[p], trace, counters));
+    std::cerr << PATTERNS[p].name << " done\n";
+  }
+
+  if(out)
+  {
+    std::ofstream f(out);
+    WriteJson(f, results, refs, counters.Available());
+  }
+  else
+    WriteJson(std::cout, results, refs, counters.Available());
+
+  return baseline ? Compare(baseline, results, threshold) : 0;
+}
+
+// runs tracegen for the pattern and reads its binary output into
+// trace, returns false if tracegen could not be run
+bool LoadPattern(const std::string &tracegen, const Pattern &p,
+                 long long refs, std::vector<MemRef> &trace)
+{
+  std::ostringstream cmd;
+  cmd << tracegen << ' ' << p.name << ' ' << refs << ' ' << p.args
+      << " --binary";
+
+  FILE *f = popen(cmd.str().c_str(), "r");
+  if(!f)
+    return false;
+
+  char magic[TRACE_MAGIC_SIZE];
+  unsigned char record[TRACE_RECORD_SIZE];
+  MemRef r;
+  trace.clear();
+  if(fread(magic, 1, TRACE_MAGIC_SIZE, f) == (size_t)TRACE_MAGIC_SIZE
+     && IsBinaryTrace(magic, TRACE_MAGIC_SIZE))
+  {
+    while(fread(record, 1, TRACE_RECORD_SIZE, f)
+          == (size_t)TRACE_RECORD_SIZE)
+    {
+      DecodeRef(record, r);
+      trace.push_back(r);
+    }
+  }
+  return pclose(f) == 0 && !trace.empty();
+}
+
+// times the cache hot path, best of three runs on a fresh cache
+Result BenchCache(const Geometry &g, const Pattern &p,
+                  std::vector<MemRef> &trace, Counters &counters)
+{
+  Result best;
+  best.seconds = -1;
+
+  for(int run = 0; run < 3; ++run)
+  {
+    Cache c(g.setSize, g.lineSize, g.cacheSize);
+    Result r;
+    r.name = std::string("cache/") + g.name + "/" + p.name;
+    r.refs = trace.size();
+
+    counters.Start();
+    std::chrono::steady_clock::time_point start
+      = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < trace.size(); ++i)
+    {
+      int index = c.GetIndex(trace[i].address);
+      int tag = c.GetTag(trace[i].address);
+      if(trace[i].write)
+        c.Write(index, tag);
+      else
+        c.Read(index, tag);
+    }
+    r.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+    counters.Stop(r);
+
+    r.hits = c.GetHits();
+    r.misses = c.GetMisses();
+    r.peakRss = PeakRss();
+    if(best.seconds < 0 || r.seconds < best.seconds)
+      best = r;
+  }
+  return best;
+}
+
+// times ParseAddress on the text form of the trace, the way the
+// simulator runs it
+Result BenchParser(const Pattern &p, std::vector<MemRef> &trace,
+                   Counters &counters)
+{
+  std::list<std::string> lines;
+  std::list<Trace> results;
+  char text[16];
+  for(size_t i = 0; i < trace.size(); ++i)
+    lines.push_back(std::string(text, FormatRef(trace[i], text)));
+
+  Cache c(4, 64, 32768);
+  Result r;
+  r.name = std::string("parse/") + p.name;
+  r.refs = trace.size();
+
+  counters.Start();
+  std::chrono::steady_clock::time_point start
+    = std::chrono::steady_clock::now();
+  ParseAddress(c, results, lines);
+  r.seconds = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  counters.Stop(r);
+
+  r.hits = c.GetHits();
+  r.misses = c.GetMisses();
+  r.peakRss = PeakRss();
+  return r;
+}
+
+// peak resident set size of the process so far in KB
+long PeakRss()
+{
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_maxrss;
+}
+
+// the git revision being benchmarked, if there is one
+std::string Revision()
+{
+  std::string rev;
+  FILE *f = popen("git rev-parse --short HEAD 2>/dev/null", "r");
+  if(!f)
+    return rev;
+  char buf[64];
+  if(fgets(buf, sizeof(buf), f))
+    rev = buf;
+  pclose(f);
+  while(!rev.empty() && (rev[rev.size() - 1] == '\n'))
+    rev.erase(rev.size() - 1);
+  return rev;
+}
+
+// writes the results as JSON, one case per line so Compare and
+// plain diff can both read it
+void WriteJson(std::ostream &out, std::vector<Result> &results,
+               long long refs, bool counters)
+{
+  char line[512];
+
+  out << "{\n"
+      << "  \"revision\": \"" << Revision() << "\",\n"
+      << "  \"refs\": " << refs << ",\n"
+      << "  \"perf_event\": " << (counters ? "true" : "false") << ",\n"
+      << "  \"peak_rss_kb\": " << PeakRss() << ",\n"
+      << "  \"results\": [\n";
+  for(size_t i = 0; i < results.size(); ++i)
+  {
+    Result &r = results[i];
+    snprintf(line, sizeof(line),
+             "    {\"name\": \"%s\", \"refs\": %lld, \"seconds\": %.6f, "
+             "\"refs_per_sec\": %.0f, \"ns_per_access\": %.3f, "
+             "\"hits\": %lld, \"misses\": %lld, \"peak_rss_kb\": %ld",
+             r.name.c_str(), r.refs, r.seconds, r.refs / r.seconds,
+             r.seconds * 1e9 / r.refs, r.hits, r.misses, r.peakRss);
+    out << line;
+    if(r.counters)
+    {
+      snprintf(line, sizeof(line),
+               ", \"cycles\": %lld, \"instructions\": %lld, "
+               "\"cache_misses\": %lld, \"branch_misses\": %lld",
+               r.cycles, r.instructions, r.cacheMisses, r.branchMisses);
+      out << line;
+    }
+    out << '}' << (i + 1 < results.size() ? "," : "") << '\n';
+  }
+  out << "  ]\n}\n";
+}
+
+// pulls a numeric field out of one result line of our own JSON
+bool Field(const std::string &line, const char *key, double &value)
+{
+  std::string k = std::string("\"") + key + "\": ";
+  size_t at = line.find(k);
+  if(at == std::string::npos)
+    return false;
+  value = atof(line.c_str() + at + k.size());
+  return true;
+}
+
+// compares ns per access against a baseline run. Returns 2 if any
+// case is slower by more than threshold percent, a changed miss
+// count is reported too since it means the model itself changed
+int Compare(const char *baseline, std::vector<Result> &results,
+            double threshold)
+{
+  std::ifstream in(baseline);
+  std::map<std::string, std::pair<double, double> > old;
+  std::string line;
+
+  while(std::getline(in, line))
+  {
+    size_t at = line.find("\"name\": \"");
+    if(at == std::string::npos)
+      continue;
+    at += 9;
+    std::string name = line.substr(at, line.find('"', at) - at);
+    double ns, misses;
+    if(Field(line, "ns_per_access", ns) && Field(line, "misses", misses))
+      old[name] = std::make_pair(ns, misses);
+  }
+  if(old.empty())
+  {
+    std::cerr << "No results in baseline " << baseline << std::endl;
+    return 1;
+  }
+
+  int status = 0;
+  for(size_t i = 0; i < results.size(); ++i)
+  {
+    Result &r = results[i];
+    if(old.find(r.name) == old.end())
+      continue;
+    double was = old[r.name].first;
+    double now = r.seconds * 1e9 / r.refs;
+    double change = (now - was) / was * 100.0;
+    if(change > threshold)
+    {
+      std::cerr << "REGRESSION " << r.name << ": " << was << " -> "
+                << now << " ns/access (+" << change << "%)\n";
+      status = 2;
+    }
+    if((long long)old[r.name].second != r.misses)
+      std::cerr << "CHANGED " << r.name << ": misses "
+                << (long long)old[r.name].second << " -> " << r.misses
+                << std::endl;
+  }
+  return status;
+}
+
+#endif
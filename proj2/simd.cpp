@@ -0,0 +1,804 @@
+/**
+ * @file 	simd.cpp
+ * @author	William Ernest
+ * @date	10/19/26
+ * @brief	Cache simulation daemon.
+ *
+ * @section	DESCRIPTION
+ * This program keeps memory traces resident and simulates cache
+ * configs over them for simq (see simproto.h), so a query pays
+ * for neither a process start nor reading and parsing its trace.
+ * A trace is read the first time it is asked for, or at startup
+ * if it is named on the command line, and read again when its
+ * file changes. Compressed traces are inflated once as they are
+ * read. A pool of -j threads serves the connections, one request
+ * each. A connection waits in the accepting thread until its
+ * request arrives, or is dropped if it does not in time, so idle
+ * clients hold no worker, and stats and shutdown are answered
+ * there too so a busy pool cannot hold them up.
+ *
+ * Every result is kept, keyed by a hash of the trace's references
+ * and the configs as read, so a repeated query is answered
+ * without simulating, even on a copy of the trace under another
+ * name. Past --memo bytes of results the least recently used are
+ * dropped. The output is what proj2 prints for the trace file,
+ * so compressed traces, like live ones sent by simq, get no table
+ * and end with the count of references, as proj2 prints them
+ * with --interval 0. Live traces are neither kept nor memoized.
+ *
+ *   simd [-j threads] [--memo bytes] [--socket path] [trace ...]
+ **/
+
+#ifndef SIMD_CPP
+#define SIMD_CPP
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <set>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <csignal>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <poll.h>
+#include "cache.h"
+#include "tlb.h"
+#include "trace.h"
+#include "parse.h"
+#include "report.h"
+#include "tracestream.h"
+#include "compressed.h"
+#include "simproto.h"
+
+// results kept unless --memo says otherwise
+const size_t DEFAULT_MEMO_BYTES = 256 << 20;
+// seconds a connection has to send its request
+const int REQUEST_SECONDS = 2;
+
+// a trace held in memory
+struct ResidentTrace
+{
+  std::vector<MemRef> refs;
+  unsigned long long hash;  // FNV-1a over the binary records
+  off_t size;               // of the file when it was read
+  struct timespec mtime;
+  bool streamed;            // compressed, so reported as proj2 does
+};
+
+// a trace and the lock held while it is read, so requests for a
+// trace being read wait for it rather than read it again
+struct TraceSlot
+{
+  std::mutex load;
+  std::shared_ptr<const ResidentTrace> trace;
+};
+
+// 64 bit FNV-1a over the references as binary records, so the text
+// and binary forms of a trace hash the same
+unsigned long long HashRefs(const std::vector<MemRef> &refs)
+{
+  unsigned long long h = 14695981039346656037ull;
+  unsigned char record[TRACE_RECORD_SIZE];
+  for(size_t i = 0; i < refs.size(); ++i)
+  {
+    EncodeRef(refs[i], record);
+    for(int k = 0; k < TRACE_RECORD_SIZE; ++k)
+      h = (h ^ record[k]) * 1099511628211ull;
+  }
+  return h;
+}
+
+// reads a text, binary or compressed trace file into refs, returns
+// false if it cannot be read
+bool ReadTrace(const char *name, std::vector<MemRef> &refs)
+{
+  if(CompressionOf(name) != NOT_COMPRESSED)
+  {
+    bool ok = false;
+    RefRing ring(1 << 16);
+    std::thread reader(ReadCompressedTrace, name, &ring,
+                       std::thread::hardware_concurrency(), &ok);
+    std::vector<MemRef> batch;
+    while(ring.Pop(batch, 4096, 100))
+      refs.insert(refs.end(), batch.begin(), batch.end());
+    reader.join();
+    return ok;
+  }
+
+  std::ifstream in(name, std::ios::binary);
+  if(!in)
+    return false;
+  std::ostringstream text;
+  text << in.rdbuf();
+  const std::string &s = text.str();
+
+  MemRef r;
+  if(IsBinaryTrace(s.data(), s.size()))
+  {
+    for(size_t at = TRACE_MAGIC_SIZE; at + TRACE_RECORD_SIZE <= s.size();
+        at += TRACE_RECORD_SIZE)
+    {
+      DecodeRef((const unsigned char *)s.data() + at, r);
+      refs.push_back(r);
+    }
+    return true;
+  }
+
+  // lines that are not references are skipped
+  for(size_t at = 0; at < s.size(); )
+  {
+    size_t nl = s.find('\n', at);
+    if(nl == std::string::npos)
+      nl = s.size();
+    if(ParseRef(s.data() + at, nl - at, r))
+      refs.push_back(r);
+    at = nl + 1;
+  }
+  return true;
+}
+
+// the traces the daemon holds, by path
+class TraceStore
+{
+public:
+
+  // constructor
+  TraceStore(): _refs(0), _reads(0)
+  {
+  }
+
+  // returns the trace at path, reading it if it is not held or
+  // its file has changed since, or NULL with a message in error
+  std::shared_ptr<const ResidentTrace> Get(const std::string &path,
+                                           std::string &error)
+  {
+    struct stat st;
+    if(stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+      error = "Cannot read trace " + path;
+      return std::shared_ptr<const ResidentTrace>();
+    }
+
+    std::shared_ptr<TraceSlot> slot;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      std::shared_ptr<TraceSlot> &s = _slots[path];
+      if(!s)
+        s.reset(new TraceSlot);
+      slot = s;
+    }
+
+    std::lock_guard<std::mutex> lock(slot->load);
+    const ResidentTrace *held = slot->trace.get();
+    if(held && held->size == st.st_size
+       && held->mtime.tv_sec == st.st_mtim.tv_sec
+       && held->mtime.tv_nsec == st.st_mtim.tv_nsec)
+      return slot->trace;
+
+    std::shared_ptr<ResidentTrace> t(new ResidentTrace);
+    if(!ReadTrace(path.c_str(), t->refs))
+    {
+      error = "Cannot read trace " + path;
+      return std::shared_ptr<const ResidentTrace>();
+    }
+    t->hash = HashRefs(t->refs);
+    t->streamed = CompressionOf(path.c_str()) != NOT_COMPRESSED;
+    t->size = st.st_size;
+    t->mtime = st.st_mtim;
+    ++_reads;
+
+    std::lock_guard<std::mutex> total(_mutex);
+    _refs += (long long)t->refs.size()
+      - (held ? (long long)held->refs.size() : 0);
+    slot->trace = t;
+    return slot->trace;
+  }
+
+  // the traces held and the references in them
+  void Counts(size_t &traces, long long &refs)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    traces = 0;
+    for(std::map<std::string, std::shared_ptr<TraceSlot> >::iterator it
+          = _slots.begin(); it != _slots.end(); ++it)
+    {
+      if(it->second->trace)
+        ++traces;
+    }
+    refs = _refs;
+  }
+
+  // times a trace file has been read
+  long long Reads() const {return _reads;}
+
+private:
+  std::mutex _mutex;
+  std::map<std::string, std::shared_ptr<TraceSlot> > _slots;
+  long long _refs;
+  std::atomic<long long> _reads;
+};
+
+// finished outputs by request key, least recently used dropped
+// first once they pass a byte budget
+class ResultMemo
+{
+public:
+
+  // constructor
+  ResultMemo(size_t budget): _budget(budget), _bytes(0), _evictions(0)
+  {
+  }
+
+  // the output kept for key, or NULL
+  std::shared_ptr<const std::string> Find(const std::string &key)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::map<std::string, Entry>::iterator it = _entries.find(key);
+    if(it == _entries.end())
+      return std::shared_ptr<const std::string>();
+    _order.splice(_order.begin(), _order, it->second.at);
+    return it->second.output;
+  }
+
+  // keeps output for key unless it is bigger than the whole budget
+  void Add(const std::string &key,
+           std::shared_ptr<const std::string> output)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(output->size() > _budget || _entries.count(key))
+      return;
+    while(_bytes + output->size() > _budget)
+    {
+      std::map<std::string, Entry>::iterator old
+        = _entries.find(_order.back());
+      _bytes -= old->second.output->size();
+      _entries.erase(old);
+      _order.pop_back();
+      ++_evictions;
+    }
+    _order.push_front(key);
+    Entry e = {output, _order.begin()};
+    _entries[key] = e;
+    _bytes += output->size();
+  }
+
+  void Counts(size_t &entries, size_t &bytes, long long &evictions)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    entries = _entries.size();
+    bytes = _bytes;
+    evictions = _evictions;
+  }
+
+private:
+  typedef std::list<std::string> Order;
+  struct Entry
+  {
+    std::shared_ptr<const std::string> output;
+    Order::iterator at;     // place in _order
+  };
+
+  std::mutex _mutex;
+  size_t _budget;
+  size_t _bytes;
+  long long _evictions;
+  std::map<std::string, Entry> _entries;
+  Order _order;             // most recently used first
+};
+
+// connections waiting for a worker
+class ConnectionQueue
+{
+public:
+
+  // constructor
+  ConnectionQueue(): _closed(false)
+  {
+  }
+
+  void Push(int fd)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _fds.push_back(fd);
+    _ready.notify_one();
+  }
+
+  // returns the next connection, or -1 once the queue is closed
+  // and empty
+  int Pop()
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(_fds.empty() && !_closed)
+      _ready.wait(lock);
+    if(_fds.empty())
+      return -1;
+    int fd = _fds.front();
+    _fds.pop_front();
+    return fd;
+  }
+
+  void Close()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _closed = true;
+    _ready.notify_all();
+  }
+
+private:
+  std::deque<int> _fds;
+  bool _closed;
+  std::mutex _mutex;
+  std::condition_variable _ready;
+};
+
+class SimServer
+{
+public:
+
+  // constructor
+  SimServer(int listener, size_t memoBytes)
+    : _listener(listener), _memo(memoBytes), _stopping(false),
+      _requests(0), _runs(0), _memoHits(0)
+  {
+  }
+
+  // accepts connections onto workers until a shutdown request
+  void Run(int threads)
+  {
+    std::vector<std::thread> pool;
+    for(int i = 0; i < threads; ++i)
+      pool.push_back(std::thread(&SimServer::Work, this));
+
+    // connections that have not sent their request yet
+    std::vector<Waiting> waiting;
+    std::vector<struct pollfd> fds;
+    while(!_stopping)
+    {
+      fds.resize(1 + waiting.size());
+      fds[0].fd = _listener;
+      for(size_t i = 0; i < waiting.size(); ++i)
+        fds[i + 1].fd = waiting[i].fd;
+      for(size_t i = 0; i < fds.size(); ++i)
+        fds[i].events = POLLIN;
+      if(poll(&fds[0], fds.size(), 100) < 0 && errno != EINTR)
+      {
+        std::cerr << "Cannot poll: " << strerror(errno) << std::endl;
+        break;
+      }
+
+      // hand on those with something to read, drop those that have
+      // waited too long
+      std::chrono::steady_clock::time_point now
+        = std::chrono::steady_clock::now();
+      size_t kept = 0;
+      for(size_t i = 0; i < waiting.size(); ++i)
+      {
+        if(fds[i + 1].revents)
+          Dispatch(waiting[i].fd);
+        else if(now >= waiting[i].deadline)
+          close(waiting[i].fd);
+        else
+          waiting[kept++] = waiting[i];
+      }
+      waiting.resize(kept);
+
+      if(!_stopping && (fds[0].revents & POLLIN))
+      {
+        Waiting w = {accept(_listener, NULL, NULL),
+                     now + std::chrono::seconds(REQUEST_SECONDS)};
+        if(w.fd >= 0)
+          waiting.push_back(w);
+        else if(errno != EINTR && errno != ECONNABORTED && !_stopping)
+        {
+          std::cerr << "Cannot accept: " << strerror(errno) << std::endl;
+          break;
+        }
+      }
+    }
+    for(size_t i = 0; i < waiting.size(); ++i)
+      close(waiting[i].fd);
+    _queue.Close();
+    for(size_t i = 0; i < pool.size(); ++i)
+      pool[i].join();
+  }
+
+  // reads a trace ahead of any request for it
+  bool Preload(const std::string &path)
+  {
+    std::string error;
+    if(_traces.Get(path, error))
+      return true;
+    std::cerr << error << std::endl;
+    return false;
+  }
+
+private:
+  // an accepted connection and when to give up on its request
+  struct Waiting
+  {
+    int fd;
+    std::chrono::steady_clock::time_point deadline;
+  };
+
+  // answers a stats or shutdown request at once, so a busy pool
+  // cannot hold it up, and queues anything else for a worker
+  void Dispatch(int fd)
+  {
+    char head[16];
+    ssize_t n = recv(fd, head, sizeof(head), MSG_PEEK | MSG_DONTWAIT);
+    if(IsLine(head, n, "stats") || IsLine(head, n, "shutdown"))
+    {
+      Serve(fd);
+      close(fd);
+    }
+    else
+      _queue.Push(fd);
+  }
+
+  // true if the n bytes at head start with all of line and its
+  // newline
+  static bool IsLine(const char *head, ssize_t n, const char *line)
+  {
+    ssize_t length = strlen(line);
+    return n > length && memcmp(head, line, length) == 0
+      && head[length] == '\n';
+  }
+
+  // worker thread body
+  void Work()
+  {
+    for(int fd; (fd = _queue.Pop()) >= 0; )
+    {
+      Serve(fd);
+      close(fd);
+    }
+  }
+
+  // answers the one request of a connection
+  void Serve(int fd)
+  {
+    if(!Register(fd))
+      return;
+    SocketReader in(fd);
+    SimRequest r;
+    Timeout(fd, REQUEST_SECONDS);
+    if(ReadRequest(in, r))
+    {
+      ++_requests;
+      if(r.command == "stats")
+        SendReply(fd, true, Stats());
+      else if(r.command == "shutdown")
+      {
+        _stopping = true;
+        shutdown(_listener, SHUT_RDWR);
+        SendReply(fd, true, "");
+        WakeClients(fd);
+      }
+      else
+      {
+        std::string error;
+        bool memo = false;
+        std::shared_ptr<const std::string> output
+          = Simulate(r, in, fd, memo, error);
+        if(output)
+          SendReply(fd, true, *output, memo);
+        else
+          SendReply(fd, false, error);
+      }
+    }
+    Unregister(fd);
+  }
+
+  // limits how long a read of fd waits, 0 for no limit
+  static void Timeout(int fd, int seconds)
+  {
+    struct timeval t = {seconds, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(t));
+  }
+
+  // notes a connection being served, returns false if the daemon is
+  // stopping and it should just be closed
+  bool Register(int fd)
+  {
+    std::lock_guard<std::mutex> lock(_clientMutex);
+    if(_stopping)
+      return false;
+    _clients.insert(fd);
+    return true;
+  }
+
+  void Unregister(int fd)
+  {
+    std::lock_guard<std::mutex> lock(_clientMutex);
+    _clients.erase(fd);
+  }
+
+  // ends every connection being served but the one asking, so
+  // workers waiting on a client return and Run can join them
+  void WakeClients(int asking)
+  {
+    std::lock_guard<std::mutex> lock(_clientMutex);
+    for(std::set<int>::iterator it = _clients.begin(); it != _clients.end();
+        ++it)
+    {
+      if(*it != asking)
+        shutdown(*it, SHUT_RDWR);
+    }
+  }
+
+  // the output for a simulation request, from the memo if it has
+  // been asked before, or NULL with a message in error
+  std::shared_ptr<const std::string> Simulate(const SimRequest &r,
+                                              SocketReader &in, int fd,
+                                              bool &memo, std::string &error)
+  {
+    std::istringstream cacheConfig(r.cache);
+    int setSize = 0;
+    int lineSize = 0;
+    int cacheSize = 0;
+    cacheConfig >> setSize >> lineSize >> cacheSize;
+    if(!cacheConfig || setSize <= 0 || lineSize <= 0
+       || cacheSize / lineSize / setSize <= 0)
+    {
+      error = "Bad cache config";
+      return std::shared_ptr<const std::string>();
+    }
+
+    // the key holds the configs as numbers, so spacing and
+    // comments after them do not matter
+    std::ostringstream key;
+    std::istringstream tlbConfig(r.tlb);
+    key << setSize << " " << lineSize << " " << cacheSize << " |";
+    long long v;
+    for(int i = 0; !r.tlb.empty() && i < 9; ++i)
+    {
+      if(!(tlbConfig >> v))
+      {
+        error = "Bad TLB config";
+        return std::shared_ptr<const std::string>();
+      }
+      key << " " << v;
+    }
+    key << (r.table ? " | table | " : " | summary | ");
+
+    // a live trace is simulated as it arrives, anything else is
+    // looked up in the memo first
+    bool live = r.trace == "-";
+    std::shared_ptr<const ResidentTrace> trace;
+    std::shared_ptr<const std::string> output;
+    if(!live)
+    {
+      trace = _traces.Get(r.trace, error);
+      if(!trace)
+        return std::shared_ptr<const std::string>();
+      key << std::hex << std::setw(16) << std::setfill('0') << trace->hash
+          << (trace->streamed ? " | streamed" : "");
+
+      output = _memo.Find(key.str());
+      if(output)
+      {
+        memo = true;
+        ++_memoHits;
+        return output;
+      }
+    }
+
+    Cache cache(setSize, lineSize, cacheSize);
+    Mmu *mmu = NULL;
+    if(!r.tlb.empty())
+    {
+      tlbConfig.clear();
+      tlbConfig.seekg(0);
+      mmu = Mmu::FromStream(tlbConfig, cache);
+      if(!mmu)
+      {
+        error = "Bad TLB config";
+        return std::shared_ptr<const std::string>();
+      }
+    }
+    if(live)
+    {
+      // the producer may pause for as long as it likes
+      Timeout(fd, 0);
+      output.reset(new std::string(Report(in, cache, mmu)));
+    }
+    else
+      output.reset(new std::string(Report(*trace, cache, mmu, r.table)));
+    delete mmu;
+    ++_runs;
+    if(!live)
+      _memo.Add(key.str(), output);
+    return output;
+  }
+
+  // simulates a resident trace, printing what proj2 prints
+  static std::string Report(const ResidentTrace &trace, Cache &cache,
+                            Mmu *mmu, bool table)
+  {
+    std::ostringstream out;
+    out << std::endl;
+    cache.PrintConfig(out);
+    out << std::endl;
+    if(trace.streamed)
+    {
+      for(size_t i = 0; i < trace.refs.size(); ++i)
+        SimulateRef(cache, trace.refs[i], mmu);
+      PrintTotal(trace.refs.size(), cache, mmu, out);
+      return out.str();
+    }
+    if(table)
+      PrintTable(out);
+
+    Trace temp;
+    for(size_t i = 0; i < trace.refs.size(); ++i)
+    {
+      const MemRef &ref = trace.refs[i];
+      temp.refNum = i;
+      temp.rw = ref.write ? "Write" : " Read";
+      temp.refSize = ref.size;
+      temp.address = ref.address;
+      RunTrace(cache, temp, mmu);
+      if(table)
+        PrintRow(temp, out);
+    }
+
+    PrintSummary(cache, out);
+    if(mmu)
+      mmu->PrintSummary(out);
+    return out.str();
+  }
+
+  // simulates a live trace as the rest of a connection brings it,
+  // printing what proj2 prints for a live source
+  static std::string Report(SocketReader &in, Cache &cache, Mmu *mmu)
+  {
+    std::ostringstream out;
+    out << std::endl;
+    cache.PrintConfig(out);
+    out << std::endl;
+
+    RefDecoder decoder;
+    std::vector<MemRef> refs;
+    std::string chunk;
+    long long total = 0;
+    bool more;
+    do
+    {
+      more = in.Rest(chunk);
+      if(more)
+        decoder.Feed(chunk.data(), chunk.size(), refs);
+      else
+        decoder.Finish(refs);
+      for(size_t i = 0; i < refs.size(); ++i)
+        SimulateRef(cache, refs[i], mmu);
+      total += refs.size();
+      refs.clear();
+    }while(more);
+
+    PrintTotal(total, cache, mmu, out);
+    return out.str();
+  }
+
+  // the end of proj2's output for a trace simulated as it is read
+  static void PrintTotal(long long refs, Cache &cache, Mmu *mmu,
+                         std::ostream &out)
+  {
+    out << std::endl << "Total references:\t" << refs << std::endl;
+    if(refs)
+    {
+      PrintSummary(cache, out);
+      if(mmu)
+        mmu->PrintSummary(out);
+    }
+  }
+
+  std::string Stats()
+  {
+    size_t traces;
+    long long refs;
+    size_t entries;
+    size_t bytes;
+    long long evictions;
+    _traces.Counts(traces, refs);
+    _memo.Counts(entries, bytes, evictions);
+
+    std::ostringstream out;
+    out << "Traces Resident:\t" << traces << std::endl
+        << "References:\t" << refs << std::endl
+        << "Trace Reads:\t" << _traces.Reads() << std::endl
+        << "Requests:\t" << _requests << std::endl
+        << "Simulations:\t" << _runs << std::endl
+        << "Memo Hits:\t" << _memoHits << std::endl
+        << "Memo Entries:\t" << entries << std::endl
+        << "Memo Bytes:\t" << bytes << std::endl
+        << "Memo Evictions:\t" << evictions << std::endl;
+    return out.str();
+  }
+
+  int _listener;
+  TraceStore _traces;
+  ResultMemo _memo;
+  ConnectionQueue _queue;
+  std::mutex _clientMutex;
+  std::set<int> _clients;   // connections being served
+  std::atomic<bool> _stopping;
+  std::atomic<long long> _requests;
+  std::atomic<long long> _runs;
+  std::atomic<long long> _memoHits;
+};
+
+int main(int argc, char *argv[])
+{
+  int threads = std::thread::hardware_concurrency();
+  size_t memoBytes = DEFAULT_MEMO_BYTES;
+  const char *path = DEFAULT_SIMD_SOCKET;
+  std::vector<std::string> preload;
+
+  for(int i = 1; i < argc; ++i)
+  {
+    if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+      threads = atoi(argv[++i]);
+    else if(strcmp(argv[i], "--memo") == 0 && i + 1 < argc)
+      memoBytes = strtoull(argv[++i], NULL, 0);
+    else if(strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+      path = argv[++i];
+    else if(argv[i][0] == '-')
+    {
+      std::cerr << "usage: simd [-j threads] [--memo bytes] "
+                << "[--socket path] [trace ...]\n";
+      return 1;
+    }
+    else
+      preload.push_back(argv[i]);
+  }
+  if(threads <= 0)
+    threads = 1;
+
+  // a client that goes away mid reply must not end the daemon
+  signal(SIGPIPE, SIG_IGN);
+
+  int listener = ListenUnix(path, 64);
+  if(listener < 0)
+  {
+    std::cerr << "Cannot listen on " << path << ": " << strerror(errno)
+              << std::endl;
+    return 1;
+  }
+
+  SimServer server(listener, memoBytes);
+  for(size_t i = 0; i < preload.size(); ++i)
+  {
+    char *full = realpath(preload[i].c_str(), NULL);
+    bool ok = full && server.Preload(full);
+    if(!full)
+      std::cerr << "Cannot read trace " << preload[i] << std::endl;
+    free(full);
+    if(!ok)
+    {
+      close(listener);
+      unlink(path);
+      return 1;
+    }
+  }
+
+  server.Run(threads);
+  close(listener);
+  unlink(path);
+  return 0;
+}
+
+#endif
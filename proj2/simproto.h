@@ -0,0 +1,297 @@
+/**
+ * @file 	simproto.h
+ * @author	William Ernest
+ * @date	10/19/26
+ * @brief	Requests and replies between simq and simd.
+ *
+ * @section	DESCRIPTION
+ * simq talks to the simulation daemon over a Unix domain stream
+ * socket, one request to a connection. A request is one header
+ * line, with the cache and TLB config contents after it when it
+ * asks for a simulation:
+ *
+ *   sim <table|summary> <cache bytes> <tlb bytes> <trace>\n
+ *   stats\n
+ *   shutdown\n
+ *
+ * The trace is the absolute path of a trace file, the rest of
+ * the line, or - for a live trace whose bytes follow the configs
+ * until the client shuts down its side of the connection. A TLB
+ * config of 0 bytes means no TLB. A reply is a
+ * line and a body of the given size, the output for ok and a
+ * message for error:
+ *
+ *   ok <bytes> <memo|run>\n
+ *   error <bytes>\n
+ **/
+
+#ifndef SIMPROTO_H
+#define SIMPROTO_H
+
+#include <string>
+#include <sstream>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// where simd listens unless told otherwise
+const char DEFAULT_SIMD_SOCKET[] = "/tmp/simd.socket";
+// longest header line either side accepts
+const size_t MAX_SIMD_LINE = 4096;
+// largest config either side accepts
+const size_t MAX_SIMD_CONFIG = 65536;
+
+// one simulation request
+struct SimRequest
+{
+  std::string command;      // sim, stats or shutdown
+  bool table;               // print every reference, as proj2 does
+  std::string cache;        // cache config contents
+  std::string tlb;          // TLB config contents, empty for none
+  std::string trace;        // trace path
+};
+
+// fills in a socket address for path, returns false if it is too long
+inline bool UnixAddress(const char *path, struct sockaddr_un &addr)
+{
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if(strlen(path) >= sizeof(addr.sun_path))
+    return false;
+  strcpy(addr.sun_path, path);
+  return true;
+}
+
+// connects to a socket at path, returns the descriptor or -1
+inline int ConnectUnix(const char *path)
+{
+  struct sockaddr_un addr;
+  if(!UnixAddress(path, addr))
+    return -1;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(fd < 0)
+    return -1;
+  if(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return -1;
+  }
+  return fd;
+}
+
+// listens at path, replacing a socket a daemon left there when it
+// ended, returns the descriptor or -1. Anything else at path, or a
+// socket a daemon still answers on, is left alone
+inline int ListenUnix(const char *path, int backlog)
+{
+  struct sockaddr_un addr;
+  if(!UnixAddress(path, addr))
+    return -1;
+  struct stat st;
+  if(lstat(path, &st) == 0)
+  {
+    if(!S_ISSOCK(st.st_mode))
+    {
+      errno = EEXIST;
+      return -1;
+    }
+    int live = ConnectUnix(path);
+    if(live >= 0)
+    {
+      close(live);
+      errno = EADDRINUSE;
+      return -1;
+    }
+    if(errno != ECONNREFUSED)
+      return -1;
+    unlink(path);
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(fd < 0)
+    return -1;
+  if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+     || listen(fd, backlog) < 0)
+  {
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return -1;
+  }
+  return fd;
+}
+
+// writes all of data, returns false if the peer has gone
+inline bool WriteAll(int fd, const char *data, size_t len)
+{
+  while(len)
+  {
+    ssize_t n = write(fd, data, len);
+    if(n < 0 && errno == EINTR)
+      continue;
+    if(n <= 0)
+      return false;
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+inline bool WriteAll(int fd, const std::string &s)
+{
+  return WriteAll(fd, s.data(), s.size());
+}
+
+// buffered reads of lines and counted bodies off a socket
+class SocketReader
+{
+public:
+
+  // constructor
+  SocketReader(int fd): _fd(fd), _at(0)
+  {
+  }
+
+  // reads a line without its newline, returns false at the end of
+  // the input or if the line is longer than MAX_SIMD_LINE
+  bool Line(std::string &line)
+  {
+    for(;;)
+    {
+      size_t nl = _buffer.find('\n', _at);
+      if(nl != std::string::npos)
+      {
+        line.assign(_buffer, _at, nl - _at);
+        _at = nl + 1;
+        return true;
+      }
+      if(_buffer.size() - _at > MAX_SIMD_LINE || !Fill())
+        return false;
+    }
+  }
+
+  // reads exactly len bytes, returns false if the input ends first
+  bool Bytes(size_t len, std::string &out)
+  {
+    while(_buffer.size() - _at < len)
+    {
+      if(!Fill())
+        return false;
+    }
+    out.assign(_buffer, _at, len);
+    _at += len;
+    return true;
+  }
+
+  // hands over the rest of the input a piece at a time, returns
+  // false at its end
+  bool Rest(std::string &out)
+  {
+    if(_at == _buffer.size() && !Fill())
+      return false;
+    out.assign(_buffer, _at, std::string::npos);
+    _at = _buffer.size();
+    return true;
+  }
+
+private:
+  // reads more of the input onto the buffer, dropping what has
+  // been used
+  bool Fill()
+  {
+    _buffer.erase(0, _at);
+    _at = 0;
+    char chunk[65536];
+    ssize_t n;
+    do
+    {
+      n = read(_fd, chunk, sizeof(chunk));
+    }while(n < 0 && errno == EINTR);
+    if(n <= 0)
+      return false;
+    _buffer.append(chunk, n);
+    return true;
+  }
+
+  int _fd;
+  std::string _buffer;
+  size_t _at;               // first unused byte of the buffer
+};
+
+inline bool SendRequest(int fd, const SimRequest &r)
+{
+  std::ostringstream head;
+  head << r.command;
+  if(r.command == "sim")
+    head << (r.table ? " table " : " summary ") << r.cache.size() << " "
+         << r.tlb.size() << " " << r.trace;
+  head << "\n";
+  return WriteAll(fd, head.str()) && WriteAll(fd, r.cache)
+    && WriteAll(fd, r.tlb);
+}
+
+// reads a request, returns false at the end of the input or if the
+// request is not understood
+inline bool ReadRequest(SocketReader &in, SimRequest &r)
+{
+  std::string line;
+  if(!in.Line(line))
+    return false;
+  std::istringstream head(line);
+  std::string mode;
+  size_t cacheBytes = 0;
+  size_t tlbBytes = 0;
+  head >> r.command;
+  r.cache.clear();
+  r.tlb.clear();
+  r.trace.clear();
+  if(r.command != "sim")
+    return r.command == "stats" || r.command == "shutdown";
+
+  head >> mode >> cacheBytes >> tlbBytes;
+  if(!head || (mode != "table" && mode != "summary")
+     || cacheBytes > MAX_SIMD_CONFIG || tlbBytes > MAX_SIMD_CONFIG)
+    return false;
+  r.table = mode == "table";
+  std::getline(head >> std::ws, r.trace);
+  return !r.trace.empty() && in.Bytes(cacheBytes, r.cache)
+    && in.Bytes(tlbBytes, r.tlb);
+}
+
+// sends the output of a request, or an error message if ok is false
+inline bool SendReply(int fd, bool ok, const std::string &body,
+                      bool memo = false)
+{
+  std::ostringstream head;
+  head << (ok ? "ok " : "error ") << body.size();
+  if(ok)
+    head << (memo ? " memo" : " run");
+  head << "\n";
+  return WriteAll(fd, head.str()) && WriteAll(fd, body);
+}
+
+// reads a reply, returns false if the connection ends or the reply
+// is not understood
+inline bool ReadReply(SocketReader &in, bool &ok, std::string &body,
+                      bool &memo)
+{
+  std::string line;
+  if(!in.Line(line))
+    return false;
+  std::istringstream head(line);
+  std::string status;
+  std::string how;
+  size_t bytes = 0;
+  head >> status >> bytes >> how;
+  ok = status == "ok";
+  memo = how == "memo";
+  return (ok || status == "error") && in.Bytes(bytes, body);
+}
+
+#endif
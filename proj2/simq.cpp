@@ -0,0 +1,184 @@
+/**
+ * @file 	simq.cpp
+ * @author	William Ernest
+ * @date	10/19/26
+ * @brief	Client of the cache simulation daemon.
+ *
+ * @section	DESCRIPTION
+ * This program takes proj2's arguments and prints what proj2
+ * would, but asks a running simd (see simd.cpp) for it, so the
+ * trace is not read again and a query asked before is answered
+ * from the daemon's memo. --summary leaves out the table of
+ * references. -v tells on stderr whether the answer was
+ * simulated or remembered and how long it took. --stats prints
+ * the daemon's counts and --shutdown stops it. A live trace (see
+ * tracestream.h) is read here and passed on to the daemon as it
+ * arrives.
+ *
+ *   simq [--socket path] [--summary] [-v] <cache config> <trace>
+ *        [tlb config]
+ *   simq [--socket path] --stats | --shutdown
+ **/
+
+#ifndef SIMQ_CPP
+#define SIMQ_CPP
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include "tracestream.h"
+#include "simproto.h"
+
+// reads a whole config file into text, returns false if it cannot be
+// read
+bool ReadConfig(const char *name, std::string &text)
+{
+  std::ifstream in(name);
+  if(!in)
+    return false;
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  text = contents.str();
+  return text.size() <= MAX_SIMD_CONFIG;
+}
+
+// copies a live source to the daemon until the source ends, then
+// shuts down the sending side to mark the end of the trace
+bool SendLive(int source, int fd)
+{
+  char buffer[65536];
+  for(;;)
+  {
+    ssize_t n = read(source, buffer, sizeof(buffer));
+    if(n < 0 && errno == EINTR)
+      continue;
+    if(n <= 0)
+      break;
+    if(!WriteAll(fd, buffer, n))
+      return false;
+  }
+  if(source != 0)
+    close(source);
+  return shutdown(fd, SHUT_WR) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+  const char *path = DEFAULT_SIMD_SOCKET;
+  bool verbose = false;
+  SimRequest request;
+  request.command = "sim";
+  request.table = true;
+  std::vector<const char *> args;
+  int live = -1;            // live source being passed on
+
+  for(int i = 1; i < argc; ++i)
+  {
+    if(strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+      path = argv[++i];
+    else if(strcmp(argv[i], "--summary") == 0)
+      request.table = false;
+    else if(strcmp(argv[i], "-v") == 0)
+      verbose = true;
+    else if(strcmp(argv[i], "--stats") == 0)
+      request.command = "stats";
+    else if(strcmp(argv[i], "--shutdown") == 0)
+      request.command = "shutdown";
+    else
+      args.push_back(argv[i]);
+  }
+  if(request.command == "sim" ? args.size() < 2 || args.size() > 3
+     : !args.empty())
+  {
+    std::cerr << "usage: simq [--socket path] [--summary] [-v] "
+              << "<cache config> <trace> [tlb config]\n"
+              << "       simq [--socket path] --stats | --shutdown\n";
+    return 1;
+  }
+
+  if(request.command == "sim")
+  {
+    if(!ReadConfig(args[0], request.cache))
+    {
+      std::cerr << "Bad cache config file: " << args[0] << std::endl;
+      return 1;
+    }
+    if(args.size() > 2 && !ReadConfig(args[2], request.tlb))
+    {
+      std::cerr << "Bad TLB config file: " << args[2] << std::endl;
+      return 1;
+    }
+
+    // a live source is opened here and its bytes sent after the
+    // request, a file is left for the daemon, which runs elsewhere
+    // and so is sent the full path
+    if(IsLiveSource(args[1]))
+    {
+      live = OpenLiveSource(args[1]);
+      if(live < 0)
+      {
+        std::cerr << "Cannot open live source " << args[1] << ": "
+                  << strerror(errno) << std::endl;
+        return 1;
+      }
+      request.trace = "-";
+    }
+    else
+    {
+      char *full = realpath(args[1], NULL);
+      if(!full)
+      {
+        std::cerr << "Cannot read trace " << args[1] << std::endl;
+        return 1;
+      }
+      request.trace = full;
+      free(full);
+    }
+  }
+
+  int fd = ConnectUnix(path);
+  if(fd < 0)
+  {
+    std::cerr << "Cannot reach simd at " << path << ": " << strerror(errno)
+              << std::endl;
+    return 1;
+  }
+
+  std::chrono::steady_clock::time_point start
+    = std::chrono::steady_clock::now();
+  SocketReader in(fd);
+  bool ok = false;
+  bool memo = false;
+  std::string body;
+  if(!SendRequest(fd, request) || (live >= 0 && !SendLive(live, fd))
+     || !ReadReply(in, ok, body, memo))
+  {
+    std::cerr << "Lost the connection to simd at " << path << std::endl;
+    close(fd);
+    return 1;
+  }
+  close(fd);
+  double seconds = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  if(!ok)
+  {
+    std::cerr << body << std::endl;
+    return 1;
+  }
+  std::cout << body;
+  std::cout.flush();
+  if(verbose && request.command == "sim")
+    std::cerr << (memo ? "remembered" : "simulated") << " in " << std::fixed
+              << std::setprecision(3) << seconds * 1000 << " ms" << std::endl;
+  return 0;
+}
+
+#endif
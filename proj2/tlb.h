@@ -0,0 +1,247 @@
+/**
+ * @file 	tlb.h
+ * @author	William Ernest
+ * @date	10/19/26
+ * @brief	Two level TLB and page walk model.
+ *
+ * @section	DESCRIPTION
+ * Every trace address is translated through an L1 dTLB and an
+ * L2 STLB before it goes to the cache. A miss in both levels
+ * does a page walk, whose page table entry references can be
+ * sent through a cache shaped like the data cache. It is a cache
+ * of the walker's own, so walks neither evict trace lines nor
+ * count in the cache summary, which stays that of the trace. The
+ * TLB config file holds, in order:
+ *
+ *   page size in bytes (4096, 2097152 or 1073741824)
+ *   L1 dTLB entries and associativity, a multiple of it
+ *   L2 STLB entries and associativity, a multiple of it
+ *   1 to send page table references through the cache, else 0
+ *   STLB hit, cache hit and memory latencies in cycles
+ **/
+
+#ifndef TLB_H
+#define TLB_H
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include "cache.h"
+
+// a single set associative TLB level using the same move to
+// front LRU ordering as the cache
+class TLB
+{
+public:
+
+  // constructor, every entry starts out with an impossible page
+  TLB(int entries, int ways): _ways(ways), _sets(entries/ways),
+                              _hits(0), _misses(0),
+                              _data(entries, 0xFFFFFFFF)
+  {
+  }
+
+  // returns true if the page is in the TLB, on a miss the page
+  // is filled and the LRU entry of the set is dropped
+  bool Lookup(unsigned int vpn)
+  {
+    unsigned int *set = &_data[(vpn % _sets) * _ways];
+
+    for(int i = 0; i < _ways; ++i)
+    {
+      if(set[i] == vpn)
+      {
+        for(int j = i; j > 0; --j)
+          set[j] = set[j - 1];
+        set[0] = vpn;
+        ++_hits;
+        return true;
+      }
+    }
+
+    for(int i = _ways - 1; i > 0; --i)
+      set[i] = set[i - 1];
+    set[0] = vpn;
+    ++_misses;
+    return false;
+  }
+
+  int GetEntries(){return _sets * _ways;}
+  int GetWays(){return _ways;}
+  long long GetHits(){return _hits;}
+  long long GetMisses(){return _misses;}
+
+private:
+  int _ways;
+  int _sets;
+  long long _hits;
+  long long _misses;
+  std::vector<unsigned int> _data;
+};
+
+
+// the L1 dTLB, L2 STLB and page walker in front of the cache
+class Mmu
+{
+public:
+
+  // constructor, page table references go through a cache shaped
+  // like c, which may be NULL when they should not be simulated
+  Mmu(unsigned int ps, int l1e, int l1w, int l2e, int l2w, Cache *c,
+      int stlbLat, int cacheLat, int memLat)
+    : _pageSize(ps), _l1(l1e, l1w), _l2(l2e, l2w),
+      _cache(c ? new Cache(c->GetSetSize(), c->GetLineSize(), c->GetSize())
+             : NULL),
+      _stlbLatency(stlbLat), _cacheLatency(cacheLat),
+      _memLatency(memLat), _walks(0), _walkCycles(0), _pteRefs(0),
+      _pteHits(0)
+  {
+    _pageBits = 0;
+    while((1u << _pageBits) < _pageSize)
+      ++_pageBits;
+
+    // x86-64 style 4 level paging, large pages stop the walk early
+    if(_pageSize == 4096)
+      _levels = 4;
+    else if(_pageSize == 2097152)
+      _levels = 3;
+    else
+      _levels = 2;
+  }
+
+  // destructor
+  ~Mmu()
+  {
+    delete _cache;
+  }
+
+  // reads an Mmu from a TLB config file, returns NULL if the file
+  // cannot be read, the page size is not supported or a level
+  // does not hold a whole number of sets
+  static Mmu *FromFile(const char *name, Cache &c)
+  {
+    std::ifstream in(name);
+    return FromStream(in, c);
+  }
+
+  // the same from a stream holding a TLB config
+  static Mmu *FromStream(std::istream &in, Cache &c)
+  {
+    unsigned int ps;
+    int l1e, l1w, l2e, l2w, walkCache, stlbLat, cacheLat, memLat;
+
+    in >> ps >> l1e >> l1w >> l2e >> l2w >> walkCache
+       >> stlbLat >> cacheLat >> memLat;
+    if(!in)
+      return NULL;
+    if(ps != 4096 && ps != 2097152 && ps != 1073741824)
+      return NULL;
+    if(l1w <= 0 || l2w <= 0 || l1e < l1w || l2e < l2w
+       || l1e % l1w != 0 || l2e % l2w != 0)
+      return NULL;
+
+    return new Mmu(ps, l1e, l1w, l2e, l2w, walkCache ? &c : NULL,
+                   stlbLat, cacheLat, memLat);
+  }
+
+  // translates one reference, returns the cycles spent on the
+  // translation beyond an L1 dTLB hit
+  int Translate(unsigned int address)
+  {
+    unsigned int vpn = address >> _pageBits;
+
+    if(_l1.Lookup(vpn))
+      return 0;
+    if(_l2.Lookup(vpn))
+      return _stlbLatency;
+
+    return _stlbLatency + Walk(vpn);
+  }
+
+  // this will print the TLB miss rates alongside the cache summary
+  void PrintSummary(std::ostream &out = std::cout)
+  {
+    out << std::endl
+        << "      TLB Summary\n"
+        << "**************************\n"
+        << "Page Size:\t" << _pageSize << "B\n"
+        << "dTLB Misses:\t" << _l1.GetMisses() << std::endl
+        << "dTLB Miss Rate:\t" << std::setprecision(5)
+        << Rate(_l1.GetMisses(), _l1.GetHits()) << '\n'
+        << "STLB Misses:\t" << _l2.GetMisses() << std::endl
+        << "STLB Miss Rate:\t" << std::setprecision(5)
+        << Rate(_l2.GetMisses(), _l2.GetHits()) << '\n'
+        << "Page Walks:\t" << _walks << std::endl
+        << "Walk Cycles:\t" << _walkCycles << std::endl
+        << "Cycles/Walk:\t" << std::setprecision(5)
+        << (_walks ? (float)_walkCycles / _walks : 0.0f) << '\n';
+    if(_cache)
+      out << "PTE Refs:\t" << _pteRefs << std::endl
+          << "PTE Hits:\t" << _pteHits << std::endl;
+  }
+
+  long long GetWalks(){return _walks;}
+  long long GetWalkCycles(){return _walkCycles;}
+  TLB &GetL1(){return _l1;}
+  TLB &GetL2(){return _l2;}
+
+private:
+  Mmu(const Mmu &);
+  Mmu &operator=(const Mmu &);
+
+  // walks the radix page table one level at a time. Each level
+  // reads an 8 byte entry out of a table page placed in a region
+  // of its own so the entries of neighbouring pages share lines
+  int Walk(unsigned int vpn)
+  {
+    int cycles = 0;
+
+    ++_walks;
+    for(int level = 0; level < _levels; ++level)
+    {
+      int shift = 9 * (_levels - 1 - level);
+      unsigned int table = (unsigned int)((unsigned long long)vpn
+                                          >> shift >> 9);
+      unsigned int entry = (vpn >> shift) & 0x1FF;
+      unsigned int pte = 0xC0000000u + (level << 24)
+        + ((table << 12) & 0x00FFF000u) + entry * 8;
+
+      if(_cache)
+      {
+        ++_pteRefs;
+        if(_cache->Read(_cache->GetIndex(pte), _cache->GetTag(pte))
+           == "Hit")
+        {
+          ++_pteHits;
+          cycles += _cacheLatency;
+          continue;
+        }
+      }
+      cycles += _memLatency;
+    }
+    _walkCycles += cycles;
+    return cycles;
+  }
+
+  static float Rate(long long misses, long long hits)
+  {
+    return misses + hits ? (float)misses / (misses + hits) : 0.0f;
+  }
+
+  unsigned int _pageSize;
+  int _pageBits;
+  int _levels;
+  TLB _l1;
+  TLB _l2;
+  Cache *_cache;            // page table entries, or NULL
+  int _stlbLatency;
+  int _cacheLatency;
+  int _memLatency;
+  long long _walks;
+  long long _walkCycles;
+  long long _pteRefs;
+  long long _pteHits;
+};
+
+#endif
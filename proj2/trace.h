@@ -0,0 +1,128 @@
+/**
+ * @file 	trace.h
+ * @author	William Ernest
+ * @date	10/19/26
+ * @brief	Memory trace record formats.
+ *
+ * @section	DESCRIPTION
+ * A trace is either the text format, one "R:4:58" style line per
+ * reference, or the binary format. A binary trace starts with the
+ * 8 byte magic "MEMTRC01" followed by 8 byte little endian records:
+ * a 32 bit address, a byte that is 1 for writes and 0 for reads,
+ * the access size in a byte and two bytes of padding.
+ **/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// binary trace file magic
+const char TRACE_MAGIC[] = "MEMTRC01";
+const int TRACE_MAGIC_SIZE = 8;
+const int TRACE_RECORD_SIZE = 8;
+
+// a single memory reference
+struct MemRef
+{
+  unsigned int address;
+  bool write;
+  int size;
+};
+
+// returns true if the buffer starts with the binary trace magic
+inline bool IsBinaryTrace(const char *buf, size_t len)
+{
+  return len >= (size_t)TRACE_MAGIC_SIZE
+    && memcmp(buf, TRACE_MAGIC, TRACE_MAGIC_SIZE) == 0;
+}
+
+// packs a reference into a binary record
+inline void EncodeRef(const MemRef &r, unsigned char *out)
+{
+  out[0] = r.address & 0xFF;
+  out[1] = (r.address >> 8) & 0xFF;
+  out[2] = (r.address >> 16) & 0xFF;
+  out[3] = (r.address >> 24) & 0xFF;
+  out[4] = r.write ? 1 : 0;
+  out[5] = r.size & 0xFF;
+  out[6] = 0;
+  out[7] = 0;
+}
+
+// unpacks a binary record into a reference
+inline void DecodeRef(const unsigned char *in, MemRef &r)
+{
+  r.address = in[0] | (in[1] << 8) | (in[2] << 16)
+    | ((unsigned int)in[3] << 24);
+  r.write = in[4] != 0;
+  r.size = in[5];
+}
+
+// formats a reference as a text trace line without the newline,
+// returns the number of characters written into out which must
+// hold at least 16 characters
+inline int FormatRef(const MemRef &r, char *out)
+{
+  static const char digits[] = "0123456789abcdef";
+  char hex[8];
+  int n = 0;
+  int len = 0;
+  unsigned int a = r.address;
+
+  out[len++] = r.write ? 'W' : 'R';
+  out[len++] = ':';
+  if(r.size >= 10)
+    out[len++] = '0' + (r.size / 10) % 10;
+  out[len++] = '0' + r.size % 10;
+  out[len++] = ':';
+  do
+  {
+    hex[n++] = digits[a & 0xF];
+    a >>= 4;
+  }while(a);
+  while(n)
+    out[len++] = hex[--n];
+  return len;
+}
+
+// parses one "R:4:58" text line without the newline, returns false
+// if the line is not a reference
+inline bool ParseRef(const char *line, size_t len, MemRef &r)
+{
+  const char *end = line + len;
+  const char *p = line;
+
+  if(p == end || (*p != 'R' && *p != 'W'))
+    return false;
+  r.write = *p++ == 'W';
+  if(p == end || *p++ != ':')
+    return false;
+
+  r.size = 0;
+  while(p != end && *p >= '0' && *p <= '9')
+    r.size = r.size * 10 + (*p++ - '0');
+  if(p == end || *p++ != ':')
+    return false;
+
+  r.address = 0;
+  const char *digits = p;
+  for(; p != end; ++p)
+  {
+    int d;
+    if(*p >= '0' && *p <= '9')
+      d = *p - '0';
+    else if(*p >= 'a' && *p <= 'f')
+      d = *p - 'a' + 10;
+    else if(*p >= 'A' && *p <= 'F')
+      d = *p - 'A' + 10;
+    else
+      break;
+    r.address = (r.address << 4) | d;
+  }
+  return p != digits;
+}
+
+#endif
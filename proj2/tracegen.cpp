@@ -0,0 +1,536 @@
+/**
+ * @file 	tracegen.cpp
+ * @author	William Ernest
+ * @date	10/19/26
+ * @brief	Synthetic memory trace generator.
+ *
+ * @section	DESCRIPTION
+ * This program writes reproducible memory traces for the cache
+ * simulator in the text or binary format (see trace.h). The same
+ * pattern, options and seed always give the same trace, so large
+ * traces can be regenerated instead of kept around. Traces can
+ * also be written BGZF compressed (see bgzf.h).
+ *
+ *   tracegen <pattern> <refs> [options]
+ *
+ * Patterns are seq, stride, uniform, zipf, chase, matmul and gups.
+ **/
+
+#ifndef TRACEGEN_CPP
+#define TRACEGEN_CPP
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "trace.h"
+#include "bgzf.h"
+
+// generator options, everything but the pattern and
+// reference count has a default
+struct Options
+{
+  std::string pattern;
+  long long refs;
+  unsigned long long seed;
+  bool binary;
+  bool bgzf;
+  const char *out;
+  unsigned int base;
+  unsigned int footprint;
+  int size;
+  unsigned int stride;
+  int writes;
+  double theta;
+  int dim;
+  int tile;
+};
+
+// small, fast and platform independent random numbers so the
+// same seed always gives the same trace
+class Random
+{
+public:
+
+  // constructor, the seed is spread with splitmix64 so small
+  // seeds still give well mixed state
+  Random(unsigned long long seed)
+  {
+    unsigned long long z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    _state = z ^ (z >> 31);
+    if(_state == 0)
+      _state = 1;
+  }
+
+  // xorshift64*
+  unsigned long long Next()
+  {
+    _state ^= _state >> 12;
+    _state ^= _state << 25;
+    _state ^= _state >> 27;
+    return _state * 0x2545F4914F6CDD1DULL;
+  }
+
+  // returns a number in [0, n)
+  unsigned long long Below(unsigned long long n)
+  {
+    return Next() % n;
+  }
+
+  // returns a number in [0, 1)
+  double Unit()
+  {
+    return (Next() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+private:
+  unsigned long long _state;
+};
+
+// zipf distributed ranks in [1, n] by rejection inversion, this
+// needs no table so it works for any footprint
+class Zipf
+{
+public:
+
+  // constructor
+  Zipf(unsigned long long n, double theta): _n(n), _theta(theta)
+  {
+    _hX1 = H(1.5) - 1.0;
+    _hN = H(n + 0.5);
+    _s = 2.0 - HInverse(H(2.5) - h(2.0));
+  }
+
+  // returns the next rank
+  unsigned long long Sample(Random &r)
+  {
+    for(;;)
+    {
+      double u = _hN + r.Unit() * (_hX1 - _hN);
+      double x = HInverse(u);
+      unsigned long long k = (unsigned long long)(x + 0.5);
+      if(k < 1)
+        k = 1;
+      else if(k > _n)
+        k = _n;
+      if(k - x <= _s || u >= H(k + 0.5) - h(k))
+        return k;
+    }
+  }
+
+private:
+  double h(double x)
+  {
+    return exp(-_theta * log(x));
+  }
+
+  double H(double x)
+  {
+    double lx = log(x);
+    return Helper2((1.0 - _theta) * lx) * lx;
+  }
+
+  double HInverse(double x)
+  {
+    double t = x * (1.0 - _theta);
+    if(t < -1.0)
+      t = -1.0;
+    return exp(Helper1(t) * x);
+  }
+
+  // log1p(x) / x without the cancellation near zero
+  static double Helper1(double x)
+  {
+    if(fabs(x) > 1e-8)
+      return log1p(x) / x;
+    return 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+  }
+
+  // expm1(x) / x without the cancellation near zero
+  static double Helper2(double x)
+  {
+    if(fabs(x) > 1e-8)
+      return expm1(x) / x;
+    return 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+  }
+
+  unsigned long long _n;
+  double _theta;
+  double _hX1;
+  double _hN;
+  double _s;
+};
+
+// buffers references and writes them out in the chosen format,
+// Emit returns false once the requested count has been written or
+// a write has failed
+class Writer
+{
+public:
+
+  // constructor
+  Writer(FILE *f, bool binary, bool bgzf, long long refs)
+    : _file(f), _binary(binary), _bgzf(bgzf), _failed(false), _left(refs),
+      _used(0)
+  {
+    if(_binary)
+    {
+      memcpy(_buffer, TRACE_MAGIC, TRACE_MAGIC_SIZE);
+      _used = TRACE_MAGIC_SIZE;
+    }
+  }
+
+  // writes out what is left and the BGZF end marker, returns
+  // false if any of the trace could not be written
+  bool Finish()
+  {
+    Flush();
+    if(_bgzf && !_failed)
+      _failed = !WriteBgzfEof(_file);
+    return !_failed;
+  }
+
+  // adds one reference to the trace
+  bool Emit(unsigned int address, bool write, int size)
+  {
+    if(_left <= 0 || _failed)
+      return false;
+
+    MemRef r;
+    r.address = address;
+    r.write = write;
+    r.size = size;
+
+    if(_used + 32 > BUFFER_SIZE)
+      Flush();
+    if(_binary)
+    {
+      EncodeRef(r, (unsigned char *)_buffer + _used);
+      _used += TRACE_RECORD_SIZE;
+    }
+    else
+    {
+      _used += FormatRef(r, _buffer + _used);
+      _buffer[_used++] = '\n';
+    }
+    return --_left > 0;
+  }
+
+  // writes out everything buffered so far
+  void Flush()
+  {
+    if(!_bgzf)
+      _failed = _failed || fwrite(_buffer, 1, _used, _file) != (size_t)_used;
+    else
+      for(int i = 0; i < _used && !_failed; i += BGZF_MAX_INPUT)
+        _failed = !WriteBgzfBlock(_file, _buffer + i,
+                                  _used - i < BGZF_MAX_INPUT ? _used - i
+                                  : BGZF_MAX_INPUT);
+    _used = 0;
+  }
+
+private:
+  static const int BUFFER_SIZE = 1 << 20;
+
+  FILE *_file;
+  bool _binary;
+  bool _bgzf;
+  bool _failed;             // a write came up short
+  long long _left;
+  int _used;
+  char _buffer[BUFFER_SIZE];
+};
+
+void Usage();
+bool ParseOptions(int, char *[], Options &);
+void Sequential(Options &, Writer &, Random &);
+void Strided(Options &, Writer &, Random &);
+void Uniform(Options &, Writer &, Random &);
+void Zipfian(Options &, Writer &, Random &);
+void PointerChase(Options &, Writer &, Random &);
+void MatrixMultiply(Options &, Writer &);
+void Gups(Options &, Writer &, Random &);
+
+int main(int argc, char *argv[])
+{
+  Options opt;
+
+  if(!ParseOptions(argc, argv, opt))
+  {
+    Usage();
+    return 1;
+  }
+
+  FILE *f = opt.out ? fopen(opt.out, "wb") : stdout;
+  if(!f)
+  {
+    std::cerr << "Cannot open " << opt.out << std::endl;
+    return 1;
+  }
+
+  Random rng(opt.seed);
+  Writer *w = new Writer(f, opt.binary, opt.bgzf, opt.refs);
+
+  if(opt.pattern == "seq")
+    Sequential(opt, *w, rng);
+  else if(opt.pattern == "stride")
+    Strided(opt, *w, rng);
+  else if(opt.pattern == "uniform")
+    Uniform(opt, *w, rng);
+  else if(opt.pattern == "zipf")
+    Zipfian(opt, *w, rng);
+  else if(opt.pattern == "chase")
+    PointerChase(opt, *w, rng);
+  else if(opt.pattern == "matmul")
+    MatrixMultiply(opt, *w);
+  else
+    Gups(opt, *w, rng);
+
+  // a full disk must not leave a silently truncated trace
+  bool ok = w->Finish();
+  delete w;
+  ok = (f != stdout ? fclose(f) : fflush(f)) == 0 && ok;
+  if(!ok)
+  {
+    std::cerr << "Cannot write " << (opt.out ? opt.out : "the trace")
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// prints how to run the generator
+void Usage()
+{
+  std::cerr
+    << "usage: tracegen <pattern> <refs> [options]\n"
+    << "patterns: seq stride uniform zipf chase matmul gups\n"
+    << "  --seed N       random seed (1)\n"
+    << "  --binary       write the binary trace format\n"
+    << "  --bgzf         compress the trace into BGZF blocks\n"
+    << "  --out FILE     write to FILE instead of stdout\n"
+    << "  --base ADDR    first address, hex (0)\n"
+    << "  --footprint N  bytes touched before wrapping (1048576)\n"
+    << "  --size N       access size in bytes (4)\n"
+    << "  --stride N     stride pattern step in bytes (64)\n"
+    << "  --writes N     percent of references that write (0)\n"
+    << "  --theta X      zipf skew (0.99)\n"
+    << "  --dim N        matmul matrix dimension (64)\n"
+    << "  --tile N       matmul tile size (16)\n";
+}
+
+// reads the command line into opt, returns false on a bad
+// command line
+bool ParseOptions(int argc, char *argv[], Options &opt)
+{
+  if(argc < 3)
+    return false;
+
+  opt.pattern = argv[1];
+  opt.refs = atoll(argv[2]);
+  opt.seed = 1;
+  opt.binary = false;
+  opt.bgzf = false;
+  opt.out = NULL;
+  opt.base = 0;
+  opt.footprint = 1 << 20;
+  opt.size = 4;
+  opt.stride = 64;
+  opt.writes = 0;
+  opt.theta = 0.99;
+  opt.dim = 64;
+  opt.tile = 16;
+
+  if(opt.pattern != "seq" && opt.pattern != "stride"
+     && opt.pattern != "uniform" && opt.pattern != "zipf"
+     && opt.pattern != "chase" && opt.pattern != "matmul"
+     && opt.pattern != "gups")
+    return false;
+
+  for(int i = 3; i < argc; ++i)
+  {
+    std::string a = argv[i];
+    if(a == "--binary" || a == "--bgzf")
+    {
+      (a == "--binary" ? opt.binary : opt.bgzf) = true;
+      continue;
+    }
+    if(i + 1 >= argc)
+      return false;
+
+    const char *v = argv[++i];
+    if(a == "--seed")
+      opt.seed = strtoull(v, NULL, 10);
+    else if(a == "--out")
+      opt.out = v;
+    else if(a == "--base")
+      opt.base = strtoul(v, NULL, 16);
+    else if(a == "--footprint")
+      opt.footprint = strtoul(v, NULL, 10);
+    else if(a == "--size")
+      opt.size = atoi(v);
+    else if(a == "--stride")
+      opt.stride = strtoul(v, NULL, 10);
+    else if(a == "--writes")
+      opt.writes = atoi(v);
+    else if(a == "--theta")
+      opt.theta = atof(v);
+    else if(a == "--dim")
+      opt.dim = atoi(v);
+    else if(a == "--tile")
+      opt.tile = atoi(v);
+    else
+      return false;
+  }
+
+  return opt.refs > 0 && opt.size > 0 && opt.size < 100
+    && opt.footprint >= (unsigned int)opt.size && opt.stride > 0
+    && opt.dim > 0 && opt.tile > 0 && opt.theta > 0;
+}
+
+// decides if the next reference is a write
+bool IsWrite(Options &opt, Random &rng)
+{
+  return opt.writes > 0 && (int)rng.Below(100) < opt.writes;
+}
+
+// walks the footprint one access after another
+void Sequential(Options &opt, Writer &w, Random &rng)
+{
+  unsigned int offset = 0;
+  while(w.Emit(opt.base + offset, IsWrite(opt, rng), opt.size))
+  {
+    offset += opt.size;
+    if(offset + opt.size > opt.footprint)
+      offset = 0;
+  }
+}
+
+// walks the footprint stride bytes at a time, each wrap starts one
+// access further in so every word is eventually touched
+void Strided(Options &opt, Writer &w, Random &rng)
+{
+  unsigned int start = 0;
+  unsigned int offset = 0;
+  while(w.Emit(opt.base + offset, IsWrite(opt, rng), opt.size))
+  {
+    offset += opt.stride;
+    if(offset + opt.size > opt.footprint)
+    {
+      start += opt.size;
+      if(start >= opt.stride || start + opt.size > opt.footprint)
+        start = 0;
+      offset = start;
+    }
+  }
+}
+
+// picks every access uniformly from the footprint
+void Uniform(Options &opt, Writer &w, Random &rng)
+{
+  unsigned int items = opt.footprint / opt.size;
+  for(;;)
+  {
+    unsigned int item = rng.Below(items);
+    if(!w.Emit(opt.base + item * opt.size, IsWrite(opt, rng), opt.size))
+      return;
+  }
+}
+
+// picks accesses with zipf popularity, the ranks are scattered
+// over the footprint so the hot items are not all neighbours
+void Zipfian(Options &opt, Writer &w, Random &rng)
+{
+  unsigned int items = opt.footprint / opt.size;
+  Zipf z(items, opt.theta);
+  for(;;)
+  {
+    unsigned long long rank = z.Sample(rng) - 1;
+    unsigned int item = (rank * 2654435761ULL) % items;
+    if(!w.Emit(opt.base + item * opt.size, IsWrite(opt, rng), opt.size))
+      return;
+  }
+}
+
+// follows a linked list whose nodes are spread randomly over the
+// footprint, one node per stride bytes. Sattolo's shuffle makes
+// the list a single cycle through every node
+void PointerChase(Options &opt, Writer &w, Random &rng)
+{
+  unsigned int nodes = opt.footprint / opt.stride;
+  if(nodes == 0)
+    nodes = 1;
+
+  std::vector<unsigned int> next(nodes);
+  for(unsigned int i = 0; i < nodes; ++i)
+    next[i] = i;
+  for(unsigned int i = nodes - 1; i > 0; --i)
+  {
+    unsigned int j = rng.Below(i);
+    unsigned int t = next[i];
+    next[i] = next[j];
+    next[j] = t;
+  }
+
+  unsigned int node = 0;
+  while(w.Emit(opt.base + node * opt.stride, false, opt.size))
+    node = next[node];
+}
+
+// C += A * B over dim x dim matrices of 8 byte elements, tiled
+// tile x tile, repeated until enough references are written
+void MatrixMultiply(Options &opt, Writer &w)
+{
+  unsigned int n = opt.dim;
+  unsigned int t = opt.tile;
+  unsigned int a = opt.base;
+  unsigned int b = a + n * n * 8;
+  unsigned int c = b + n * n * 8;
+
+  for(;;)
+    for(unsigned int ii = 0; ii < n; ii += t)
+      for(unsigned int jj = 0; jj < n; jj += t)
+        for(unsigned int kk = 0; kk < n; kk += t)
+          for(unsigned int i = ii; i < ii + t && i < n; ++i)
+            for(unsigned int j = jj; j < jj + t && j < n; ++j)
+            {
+              unsigned int cij = c + (i * n + j) * 8;
+              if(!w.Emit(cij, false, 8))
+                return;
+              for(unsigned int k = kk; k < kk + t && k < n; ++k)
+              {
+                if(!w.Emit(a + (i * n + k) * 8, false, 8)
+                   || !w.Emit(b + (k * n + j) * 8, false, 8))
+                  return;
+              }
+              if(!w.Emit(cij, true, 8))
+                return;
+            }
+}
+
+// the HPCC RandomAccess update stream, a read and a write of an 8
+// byte word per update. The table is the largest power of two
+// number of words that fits in the footprint
+void Gups(Options &opt, Writer &w, Random &rng)
+{
+  const unsigned long long POLY = 0x7;
+  unsigned long long words = 1;
+  while(words * 2 * 8 <= opt.footprint)
+    words *= 2;
+
+  unsigned long long ran = rng.Next() | 1;
+  for(;;)
+  {
+    ran = (ran << 1) ^ ((long long)ran < 0 ? POLY : 0);
+    unsigned int addr = opt.base + (ran & (words - 1)) * 8;
+    if(!w.Emit(addr, false, 8) || !w.Emit(addr, true, 8))
+      return;
+  }
+}
+
+#endif
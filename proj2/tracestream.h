@@ -0,0 +1,305 @@
+/**
+ * @file 	tracestream.h
+ * @author	William Ernest
+ * @date	10/19/26
+ * @brief	Live trace input from stdin, a FIFO or a Unix socket.
+ *
+ * @section	DESCRIPTION
+ * A reader thread decodes references off the input as they arrive
+ * and hands them to the simulation thread through a bounded ring.
+ * When the simulator falls behind the ring fills, the reader stops
+ * reading and the producer blocks on its full pipe or socket, so
+ * memory use stays fixed no matter how long the producer runs.
+ *
+ * A source of "-" is stdin, "unix:PATH" listens on a Unix domain
+ * socket at PATH and takes one connection, and a path naming a
+ * FIFO reads the FIFO.
+ **/
+
+#ifndef TRACESTREAM_H
+#define TRACESTREAM_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "trace.h"
+
+// turns a byte stream of either trace format into references, the
+// stream may be split anywhere between calls to Feed
+class RefDecoder
+{
+public:
+
+  // constructor
+  RefDecoder(): _started(false), _binary(false)
+  {
+  }
+
+  // decodes as much of data as possible onto the back of out
+  void Feed(const char *data, size_t len, std::vector<MemRef> &out)
+  {
+    if(!_started)
+    {
+      _carry.append(data, len);
+      if(_carry.size() < (size_t)TRACE_MAGIC_SIZE
+         && _carry.compare(0, _carry.size(), TRACE_MAGIC,
+                           _carry.size()) == 0)
+        return;
+      _started = true;
+      _binary = IsBinaryTrace(_carry.data(), _carry.size());
+      std::string first;
+      first.swap(_carry);
+      size_t skip = _binary ? TRACE_MAGIC_SIZE : 0;
+      Feed(first.data() + skip, first.size() - skip, out);
+      return;
+    }
+
+    if(_binary)
+      FeedBinary(data, len, out);
+    else
+      FeedText(data, len, out);
+  }
+
+  // decodes a last text line with no newline after it
+  void Finish(std::vector<MemRef> &out)
+  {
+    MemRef r;
+    if(!_started)
+    {
+      std::string first;
+      first.swap(_carry);
+      _started = true;
+      FeedText(first.data(), first.size(), out);
+    }
+    if(!_binary && ParseRef(_carry.data(), _carry.size(), r))
+      out.push_back(r);
+    _carry.clear();
+  }
+
+private:
+  void FeedBinary(const char *data, size_t len, std::vector<MemRef> &out)
+  {
+    MemRef r;
+
+    // finish a record split over the last call
+    if(!_carry.empty())
+    {
+      size_t need = TRACE_RECORD_SIZE - _carry.size();
+      if(len < need)
+      {
+        _carry.append(data, len);
+        return;
+      }
+      _carry.append(data, need);
+      DecodeRef((const unsigned char *)_carry.data(), r);
+      out.push_back(r);
+      _carry.clear();
+      data += need;
+      len -= need;
+    }
+
+    for(; len >= (size_t)TRACE_RECORD_SIZE; data += TRACE_RECORD_SIZE,
+          len -= TRACE_RECORD_SIZE)
+    {
+      DecodeRef((const unsigned char *)data, r);
+      out.push_back(r);
+    }
+    _carry.append(data, len);
+  }
+
+  void FeedText(const char *data, size_t len, std::vector<MemRef> &out)
+  {
+    const char *end = data + len;
+    MemRef r;
+
+    while(data != end)
+    {
+      const char *nl = (const char *)memchr(data, '\n', end - data);
+      if(!nl)
+      {
+        _carry.append(data, end - data);
+        return;
+      }
+
+      const char *line = data;
+      size_t n = nl - data;
+      if(!_carry.empty())
+      {
+        _carry.append(data, n);
+        line = _carry.data();
+        n = _carry.size();
+      }
+      if(n && line[n - 1] == '\r')
+        --n;
+      if(ParseRef(line, n, r))
+        out.push_back(r);
+      _carry.clear();
+      data = nl + 1;
+    }
+  }
+
+  bool _started;
+  bool _binary;
+  std::string _carry;
+};
+
+
+// bounded single producer single consumer queue of references
+class RefRing
+{
+public:
+
+  // constructor
+  RefRing(size_t capacity): _buffer(capacity), _head(0), _count(0),
+                            _closed(false)
+  {
+  }
+
+  // adds refs, blocking while the ring is full
+  void Push(const std::vector<MemRef> &refs)
+  {
+    size_t done = 0;
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while(done < refs.size())
+    {
+      while(_count == _buffer.size())
+        _notFull.wait(lock);
+      while(done < refs.size() && _count < _buffer.size())
+      {
+        _buffer[(_head + _count) % _buffer.size()] = refs[done++];
+        ++_count;
+      }
+      _notEmpty.notify_one();
+    }
+  }
+
+  // moves up to max references into out, waiting at most timeoutMs
+  // for some to arrive. Returns false once the ring is closed and
+  // empty
+  bool Pop(std::vector<MemRef> &out, size_t max, int timeoutMs)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    out.clear();
+    if(_count == 0 && !_closed)
+      _notEmpty.wait_for(lock, std::chrono::milliseconds(timeoutMs));
+    if(_count == 0)
+      return !_closed;
+
+    while(out.size() < max && _count)
+    {
+      out.push_back(_buffer[_head]);
+      _head = (_head + 1) % _buffer.size();
+      --_count;
+    }
+    _notFull.notify_one();
+    return true;
+  }
+
+  // marks the end of the stream
+  void Close()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _closed = true;
+    _notEmpty.notify_one();
+  }
+
+private:
+  std::vector<MemRef> _buffer;
+  size_t _head;
+  size_t _count;
+  bool _closed;
+  std::mutex _mutex;
+  std::condition_variable _notFull;
+  std::condition_variable _notEmpty;
+};
+
+
+// returns true if the trace argument names a live source rather
+// than a trace file
+inline bool IsLiveSource(const char *name)
+{
+  struct stat st;
+
+  if(strcmp(name, "-") == 0 || strncmp(name, "unix:", 5) == 0)
+    return true;
+  return stat(name, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+// opens a live source and returns a descriptor to read from, or -1.
+// For a socket this waits for the producer to connect
+inline int OpenLiveSource(const char *name)
+{
+  if(strcmp(name, "-") == 0)
+    return 0;
+  if(strncmp(name, "unix:", 5) != 0)
+    return open(name, O_RDONLY);
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if(strlen(name + 5) >= sizeof(addr.sun_path))
+    return -1;
+  strcpy(addr.sun_path, name + 5);
+
+  int server = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(server < 0)
+    return -1;
+  unlink(addr.sun_path);
+  if(bind(server, (struct sockaddr *)&addr, sizeof(addr)) < 0
+     || listen(server, 1) < 0)
+  {
+    close(server);
+    return -1;
+  }
+
+  int fd;
+  do
+  {
+    fd = accept(server, NULL, NULL);
+  }while(fd < 0 && errno == EINTR);
+  close(server);
+  unlink(addr.sun_path);
+  return fd;
+}
+
+// reader thread body, decodes everything read from fd into the
+// ring and closes the ring at end of input
+inline void ReadLiveSource(int fd, RefRing *ring)
+{
+  std::vector<char> buffer(1 << 16);
+  std::vector<MemRef> refs;
+  RefDecoder decoder;
+
+  for(;;)
+  {
+    ssize_t n = read(fd, &buffer[0], buffer.size());
+    if(n < 0 && errno == EINTR)
+      continue;
+    if(n <= 0)
+      break;
+    decoder.Feed(&buffer[0], n, refs);
+    if(!refs.empty())
+    {
+      ring->Push(refs);
+      refs.clear();
+    }
+  }
+  decoder.Finish(refs);
+  ring->Push(refs);
+  ring->Close();
+  if(fd != 0)
+    close(fd);
+}
+
+#endif
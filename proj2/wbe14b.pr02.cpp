@@ -7,7 +7,11 @@
  * @section	DESCRIPTION
  * This program will take a cache configuration file and a 
  * memory trace file with cache "addressing" that will be used
- * to simulate hit/miss ratios of cache.
+ * to simulate hit/miss ratios of cache. An optional third
+ * argument names a TLB config file (see tlb.h) to also simulate
+ * address translation in front of the cache. The trace may also
+ * be a live source (see tracestream.h) or a compressed file (see
+ * compressed.h), both of which are simulated as they are read.
  **/
  
 #ifndef WBE14B_PR02_CPP
@@ -20,251 +24,50 @@
 #include <list>
 #include <iomanip>
 #include <cmath>
-
-struct Trace
-{
-  int refNum;
-  std::string rw;
-  int refSize;
-  int address;
-  int tag;
-  int index;
-  int offset;
-  std::string hm;
-};
-
-
-class Cache
-{
-public:
-
-  // constructor
-  Cache(int css, int cls, int cs): _cacheSetSize(css), _cacheLineSize(cls),
-                                   _cacheSize(cs), _misses(0),_hits(0)
-  {
-    // initiate a 2D array to simulate cache
-    _data = new int*[GetSetNum()];
-    for(int i = 0; i < GetSetNum() ; ++i)
-      _data[i] = new int[_cacheSetSize];
-
-    // fill 2D array with -1 value incase we need to 
-    // check for an empty value
-    for(int i = 0; i < GetSetNum(); ++i)
-      for(int j = 0; j < _cacheSetSize;++j)
-        _data[i][j] = -1;
-  }
-
-  // destructor
-  ~Cache()
-  {
-    for(int i = 0; i < GetSetNum() ; ++i)
-      delete [] _data[i];
-    delete [] _data;
-  }
-
-  // returns number of lines
-  int GetSetNum()
-  {
-    return _cacheSize/_cacheLineSize/_cacheSetSize;
-  }
-
-  // returns line size
-  int GetLineSize()
-  {
-    return _cacheLineSize;
-  }
-
-  // returns hits
-  int GetHits(){return _hits;}
- 
-  // returns misses
-  int GetMisses(){return _misses;}
-
-  // gives number of offset bit digits
-  int GetOffset()
-  {
-    if(_cacheLineSize == 4)
-      return 2;
-    else if(_cacheLineSize == 8)
-      return 3;
-    else if(_cacheLineSize == 16)
-      return 4;
-    else if(_cacheLineSize == 32)
-      return 5;
-  }
-
-  // will be called when the address calls for a read
-  std::string Read(int index, int tag)
-  {
-    // If the cache set size is 1 then we can just replace
-    // the tag if it is a miss
-    if(_cacheSetSize == 1)
-    {
-      if(_data[index][0] == tag)
-      {
-        ++_hits;
-        return "Hit";
-      }
-      else
-      {
-        _data[index][0]= tag;
-        ++_misses;
-        return "Miss";
-      }
-    }
-
-    // if there is a hit on the first tag then we don't need to 
-    // reshuffle
-    if(_data[index][0] == tag)
-    {
-      ++_hits;
-      return "Hit";
-    }
-
-    // if there is a hit some where else along the line, we need to
-    // reshuffle the line moving the tag to the front and dropping
-    // the LRU tag off the line
-    for(int i = 0; i < _cacheSetSize ; ++i)
-    {
-      if(_data[index][i] == tag)
-      {
-        int temp;
-        int next;
-        for( int j = i; j > 0 ; --j)
-        {                                
-          temp = _data[index][j];
-         _data[index][j] = _data[index][j-1];
-         _data[index][j-1] = temp;
-        }
-        ++_hits;
-        return "Hit";
-      }
-    }
-    
-
-    // if there is a miss we can just push the tag onto the front
-    // of the line and move everything else down 1 and drop the LRU
-    // tagg off the back of the line
-    for(int i = _cacheSetSize - 1; i > 0; --i)
-    {
-      _data[index][i] = _data[index][i - 1];
-    }
-    _data[index][0] = tag;
-    ++_misses;
-    return "Miss";
-
-  }
-
-  // will be called for when address calls for writes
-  std::string Write( int index, int tag)
-  {
-    // If the cache set size is 1 then we can just replace                     
-    // the tag if it is a miss                                                 
-    if(_cacheSetSize == 1)
-    {
-      if(_data[index][0] == tag)
-      {
-        ++_hits;
-        return "Hit";
-      }
-      else
-      {
-        _data[index][0]= tag;
-        ++_misses;
-        return "Miss";
-      }
-    }
-
-    // if there is a hit on the first tag then we don't need to                
-    // reshuffle                                                               
-    if(_data[index][0] == tag)
-    {
-      ++_hits;
-      return "Hit";
-    }
-
-    // if there is a hit some where else along the line, we need to            
-    // reshuffle the line moving the tag to the front and dropping             
-    // the LRU tag off the line                                                
-    for(int i = 0; i < _cacheSetSize ; ++i)
-    {
-      if(_data[index][i] == tag)
-      {
-        int temp;
-        int next;
-        for( int j = i; j > 0 ; --j)
-        {
-          temp = _data[index][j];
-          _data[index][j] = _data[index][j-1];
-          _data[index][j-1] = temp;
-        }
-        ++_hits;
-        return "Hit";
-      }
-    }
-
-    // if there is a miss we can just push the tag onto the front              
-    // of the line and move everything else down 1 and drop the LRU            
-    // tagg off the back of the line                                           
-    for(int i = _cacheSetSize - 1; i > 0; --i)
-    {
-      _data[index][i] = _data[index][i - 1];
-    }
-    _data[index][0] = tag;
-    ++_misses;
-    return "Miss";
-
-  }
-
-  // this will print the cache diminsions
-  void PrintConfig()
-  {
-    std::cout << "Total Cache Size:  " << _cacheSize << "B\n"
-              << "Line Size:  " << _cacheLineSize << "B\n"
-              << "Set Size:  " << _cacheSetSize << std::endl
-              << "Number of Sets:  " << GetSetNum() << std::endl;
-  }
-
-  // this is a debug feature that allows you to see whats in the 
-  // cache
-  void PrintCache()
-  {
-    for( int i = 0 ; i < GetSetNum(); ++i)
-    {
-      for(int j = 0; j < _cacheSetSize ; ++j)
-        std::cout << _data[i][j] << ' ';
-      std::cout << std::endl;
-    }
-    std::cout << std::endl;
-  }
-
-private:
-  // Data will be stored for cache in a 2D array. We will setup the cache
-  // using the cache size, block size, and line size. 
-  int _cacheSetSize;
-  int _cacheLineSize;
-  int _cacheSize;
-  int** _data;
-  int _hits;
-  int _misses;
-};
-
-
-void ParseAddress(Cache &, std::list<Trace> &, std::list<std::string> &);
-void PrintTable();
-void PrintTrace(std::list<Trace> &);
-void PrintSummary(Cache &);
+#include <cstring>
+#include <thread>
+#include "cache.h"
+#include "tlb.h"
+#include "trace.h"
+#include "parse.h"
+#include "report.h"
+#include "tracestream.h"
+#include "compressed.h"
+
+void ReadTraceFile(const char *, std::list<std::string> &);
+int RunLive(Cache &, Mmu *, const char *, int);
+int RunCompressed(Cache &, Mmu *, const char *, int, int);
+void DrainRing(Cache &, Mmu *, RefRing &, int);
  
 int main(int argc, char * argv[])
 {
   std::ifstream cacheConfigFile;	// Cache config file
-  std::ifstream memoryTraceFile;	// Memory trace file
   std::list<std::string> memoryTrace;        // will hold memory traces
   std::list<Trace> memoryTraceResults;
-  std::string lineIn;
   int cacheSetSize;	                // Cache set size
   int cacheLineSize;                    // Cache Line size
   int cacheSize;			// Cache total size
+  int interval = 5;                     // live snapshot period in seconds
+  int threads = std::thread::hardware_concurrency(); // inflate workers
+
+  // pull out the options so the rest are positional
+  int args = 1;
+  for(int i = 1; i < argc; ++i)
+  {
+    if(strcmp(argv[i], "--interval") == 0 && i + 1 < argc)
+      interval = atoi(argv[++i]);
+    else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+      threads = atoi(argv[++i]);
+    else
+      argv[args++] = argv[i];
+  }
+  argc = args;
+  if(argc < 3)
+  {
+    std::cerr << "usage: proj2 <cache config> <trace> [tlb config] "
+              << "[--interval seconds] [--threads n]\n";
+    return 1;
+  }
     	 
   cacheConfigFile.open(argv[1]);	// Get the file from command line
   cacheConfigFile >> cacheSetSize;
@@ -273,27 +76,48 @@ int main(int argc, char * argv[])
 
   cacheConfigFile.close();		// close config file
 
-  memoryTraceFile.open(argv[2]);        // open trace file
-
-  do                                    // put the file into a list
-  {
-    std::getline(memoryTraceFile, lineIn);
-    if(!memoryTraceFile) break;
-    memoryTrace.push_back(lineIn);
-  }while(memoryTraceFile.eof() == 0);  
-
-  memoryTraceFile.close();              // cloase trace file
-
   // initialize cache
   Cache cache = Cache(cacheSetSize, cacheLineSize, cacheSize);
   std::cout << std::endl;
+
+  // initialize TLBs if a TLB config file was given
+  Mmu *mmu = NULL;
+  if(argc > 3)
+  {
+    mmu = Mmu::FromFile(argv[3], cache);
+    if(!mmu)
+    {
+      std::cerr << "Bad TLB config file: " << argv[3] << std::endl;
+      return 1;
+    }
+  }
   
   // print cache diminsions
   cache.PrintConfig();
   std::cout << std::endl;
+
+  // live sources are simulated as they arrive, with no table
+  if(IsLiveSource(argv[2]))
+  {
+    int status = RunLive(cache, mmu, argv[2], interval);
+    delete mmu;
+    return status;
+  }
+
+  // so are compressed traces, which are decompressed as they go
+  if(CompressionOf(argv[2]) != NOT_COMPRESSED)
+  {
+    int status = RunCompressed(cache, mmu, argv[2], interval,
+                               threads > 1 ? threads - 1 : 1);
+    delete mmu;
+    return status;
+  }
+
+  // read the whole trace file
+  ReadTraceFile(argv[2], memoryTrace);
   
   // parse address and tally hits and misses
-  ParseAddress(cache,memoryTraceResults,memoryTrace);
+  ParseAddress(cache,memoryTraceResults,memoryTrace,mmu);
   
   // print results table header
   PrintTable();
@@ -303,6 +127,9 @@ int main(int argc, char * argv[])
   
   // print the results from the hit and miss summary
   PrintSummary(cache);
+  if(mmu)
+    mmu->PrintSummary();
+  delete mmu;
   
   // used for debugging
   //cache.PrintCache();
@@ -312,115 +139,114 @@ int main(int argc, char * argv[])
 }
 
 
-// parse address will take the string from the memorytrace file list and parse
-// it into the action, acces size, and address. It will then calculate the 
-// tag, index, and offset. Then it will run the trace to check hits and misses
-void ParseAddress(Cache &c, std::list<Trace> &mt, std::list<std::string> &mtf)
+// reads a text or binary trace file into a list of text lines,
+// binary traces are turned back into text lines
+void ReadTraceFile(const char *name, std::list<std::string> &mt)
 {
-  int i = 0;                             // to be stored as reference number
-  // used as offset number size in bits
-  int offsetNum = (int)log2(c.GetLineSize());
-  // used as index number size in bits
-  int bitNum = (int)log2(c.GetSetNum());
-  // temp variable to populate before pushing onto list
-  Trace temp;
-
-  // begin parsing address using tokenizer
-  for(std::list<std::string>::iterator it = mtf.begin(); it != mtf.end();
-      ++it)
-  {
-    temp.refNum = i;
-    boost::char_separator<char> delimeter(":");
-    boost::tokenizer< boost::char_separator<char> > tokens ( *it, delimeter);
-    boost::tokenizer< boost::char_separator<char> >::iterator itr 
-      = tokens.begin();
-    
-    // check for read or write command
-    if((*itr) == "R")
-      temp.rw = " Read";
-    else
-      temp.rw = "Write";
-    
-    // get access size
-    ++itr;
-    temp.refSize = atoi((*itr).c_str());
-
-    // get address
-    ++itr;
-    temp.address = strtoul((*itr).c_str(), NULL, 16);
-
-    // calculate value for offset
-    temp.offset = temp.address & (c.GetLineSize() - 1);
-
-    // calculate index value
-    temp.index = (temp.address & ( (c.GetSetNum() -  1) << offsetNum))
-      >> offsetNum;
-
-    // calculate tag value
-    temp.tag = (temp.address & 
-                (0xFFFFFFFF << offsetNum << bitNum)) >> offsetNum >> bitNum;
-    
-    //perform memory trace
-    if(temp.rw == " Read")
-      temp.hm = c.Read(temp.index, temp.tag);
-    else
-      temp.hm = c.Write(temp.index, temp.tag);
+  std::ifstream memoryTraceFile;	// Memory trace file
+  std::string lineIn;
 
-    // push temp onto back of list
-    mt.push_back(temp);
+  memoryTraceFile.open(name, std::ios::binary);  // open trace file
 
-    // for debugging
-    //c.PrintCache();
-    
-    ++i;
+  char magic[TRACE_MAGIC_SIZE];
+  memoryTraceFile.read(magic, TRACE_MAGIC_SIZE);
+  if(IsBinaryTrace(magic, memoryTraceFile.gcount()))
+  {
+    unsigned char record[TRACE_RECORD_SIZE];
+    char text[16];
+    MemRef ref;
+    while(memoryTraceFile.read((char *)record, TRACE_RECORD_SIZE))
+    {
+      DecodeRef(record, ref);
+      mt.push_back(std::string(text, FormatRef(ref, text)));
+    }
+  }
+  else
+  {
+    memoryTraceFile.clear();
+    memoryTraceFile.seekg(0);
+    do                                  // put the file into a list
+    {
+      std::getline(memoryTraceFile, lineIn);
+      if(!memoryTraceFile) break;
+      mt.push_back(lineIn);
+    }while(memoryTraceFile.eof() == 0);
   }
 
-
-
+  memoryTraceFile.close();              // cloase trace file
 }
 
-// This will print the table header using Dr. Hughes' format
-void PrintTable()
+// simulates a live source until the producer closes it
+int RunLive(Cache &c, Mmu *mmu, const char *name, int interval)
 {
-  std::cout << std::setw(8)  << std::left << "RefNum";
-  std::cout << std::setw(10) << std::left << "  R/W";
-  std::cout << std::setw(13) << std::left << "Address";
-  std::cout << std::setw(6)  << std::left << "Tag";
-  std::cout << std::setw(8)  << std::left << "Index";
-  std::cout << std::setw(10) << std::left << "Offset";
-  std::cout << std::setw(8)  << std::left << "H/M";
-  std::cout << std::setfill('*') << std::setw(64) << "\n" 
-            << std::setfill(' ');
-  std::cout << "\n";
+  int fd = OpenLiveSource(name);
+  if(fd < 0)
+  {
+    std::cerr << "Cannot open live source " << name << ": "
+              << strerror(errno) << std::endl;
+    return 1;
+  }
 
+  RefRing ring(1 << 16);
+  std::thread reader(ReadLiveSource, fd, &ring);
+  DrainRing(c, mmu, ring, interval);
+  reader.join();
+  return 0;
 }
 
-// this will print the trace results using Dr. Hughes' format
-void PrintTrace(std::list<Trace> &mt)
+// simulates a compressed trace while worker threads decompress it
+int RunCompressed(Cache &c, Mmu *mmu, const char *name, int interval,
+                  int workers)
 {
-  for(std::list<Trace>::iterator i = mt.begin(); i != mt.end(); ++i)
-    std::cout << "   " << std::setw(5) << std::left << (*i).refNum 
-              << std::setw(8) << (*i).rw << "  " 
-              << std::setw(8) << std::setfill('0') << std::hex 
-              << std::right << (*i).address << std::setfill(' ')
-              << std::setw(7) << (*i).tag 
-              << std::setw(8) << std::dec << (*i).index 
-              << std::setw(8) << (*i).offset 
-              << std::setw(10) << (*i).hm << std::endl;
+  bool ok = false;
+  RefRing ring(1 << 16);
+  std::thread reader(ReadCompressedTrace, name, &ring, workers, &ok);
+  DrainRing(c, mmu, ring, interval);
+  reader.join();
+
+  if(!ok)
+  {
+    std::cerr << "Could not decompress all of " << name << std::endl;
+    return 1;
+  }
+  return 0;
 }
 
-// this will print the hit or miss summary using Dr. Hughes' format
-void PrintSummary(Cache &c)
+// simulates everything that comes through the ring, printing a
+// summary snapshot every interval seconds along the way
+void DrainRing(Cache &c, Mmu *mmu, RefRing &ring, int interval)
 {
-  float hr = (float)c.GetHits()/(c.GetHits()+c.GetMisses());
-  float mr = (float)c.GetMisses()/(c.GetHits()+c.GetMisses());
-  std::cout << std:: endl 
-            << "    Simulation Summary\n"
-            << "**************************\n"
-            << "Total Hits:\t" << c.GetHits() << std::endl
-            << "Total Misses:\t" << c.GetMisses() << std::endl
-            << "Hit Rate:\t" << std::setprecision(5) << hr << '\n'
-            << "Miss Rate:\t" << std::setprecision(5) << mr << '\n';
+  std::vector<MemRef> batch;
+  long long refs = 0;
+  std::chrono::steady_clock::time_point next
+    = std::chrono::steady_clock::now() + std::chrono::seconds(interval);
+
+  while(ring.Pop(batch, 4096, 100))
+  {
+    for(size_t i = 0; i < batch.size(); ++i)
+      SimulateRef(c, batch[i], mmu);
+    refs += batch.size();
+
+    if(interval > 0 && refs && std::chrono::steady_clock::now() >= next)
+    {
+      std::cout << std::endl << "Snapshot after " << refs
+                << " references" << std::endl;
+      PrintSummary(c);
+      if(mmu)
+        mmu->PrintSummary();
+      std::cout.flush();
+      next = std::chrono::steady_clock::now()
+        + std::chrono::seconds(interval);
+    }
+  }
+
+  std::cout << std::endl << "Total references:\t" << refs << std::endl;
+  if(refs)
+  {
+    PrintSummary(c);
+    if(mmu)
+      mmu->PrintSummary();
+  }
 }
 
 